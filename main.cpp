@@ -6,6 +6,9 @@
 #include <algorithm>
 #include <fstream>
 #include <chrono>
+#include <cstdlib>
+#include <string_view>
+#include <string>
 
 // Current Chapter https://vulkan-tutorial.com/en/Drawing_a_triangle/Presentation/Image_views
 // Current Chapter https://vkguide.dev/docs/chapter-5/drawing_images/
@@ -18,8 +21,45 @@ void glfw_error(int error_code, const char *error_message)
 
 int main(int argc, char **argv)
 {
+    vengine::vengine::engine_options options { };
+    // 0 renders until the window is closed
+    size_t frame_limit = 0;
+    std::string capture_path;
+    // Chrome trace of the whole run, written on exit
+    std::string profile_path;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (arg == "--frames-in-flight" && i + 1 < argc)
+        {
+            options.frames_in_flight = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+        {
+            frame_limit = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--capture" && i + 1 < argc)
+        {
+            capture_path = argv[++i];
+        }
+        else if (arg == "--profile" && i + 1 < argc)
+        {
+            profile_path = argv[++i];
+            options.profiling = true;
+        }
+    }
+    if (options.headless && frame_limit == 0)
+    {
+        // Nothing would ever stop the loop otherwise
+        frame_limit = 1;
+    }
+
     vengine::log::info("main(int, char**)", "Creating engine...");
-    vengine::vengine engine;
+    vengine::vengine engine(options);
     if (!engine.good())
     {
         vengine::log::error("main(int, char**)", "Failed to create the engine");
@@ -42,22 +82,74 @@ int main(int argc, char **argv)
         auto old_ts = std::chrono::system_clock::now();
 
 
+        if (!profile_path.empty())
+        {
+            engine.profiler().begin_capture();
+        }
         vengine::log::info("main(int, char**)", "Starting engine loop");
         while (alive)
         {
-            vengine::vengine::handle_pending_events();
+            if (!engine.headless())
+            {
+                vengine::vengine::handle_pending_events();
+            }
+            bool last_frame = frame_limit != 0 && engine.frame_count() + 1 >= frame_limit;
+            if (last_frame && !capture_path.empty() && engine.headless())
+            {
+                engine.read_back([&](std::span<const uint8_t> texels, VkExtent2D extent, VkFormat format) {
+                    // Binary PPM, the alpha channel is dropped
+                    std::ofstream capture(capture_path, std::ios::binary);
+                    capture << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+                    bool bgra = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+                    for (size_t i = 0; i + 3 < texels.size(); i += 4)
+                    {
+                        char rgb[3] = {
+                                (char)texels[i + (bgra ? 2 : 0)],
+                                (char)texels[i + 1],
+                                (char)texels[i + (bgra ? 0 : 2)] };
+                        capture.write(rgb, 3);
+                    }
+                    vengine::log::info("main(int, char**)", std::string("Captured frame to ").append(capture_path));
+                });
+            }
             auto render_result = engine.render();
             if (!render_result) { break; }
             engine.swap_buffers();
+            if (last_frame)
+            {
+                alive = false;
+            }
             auto new_ts = std::chrono::system_clock::now();
             if (new_ts - old_ts > std::chrono::seconds(1))
             {
                 old_ts = new_ts;
                 auto frame_count = engine.frame_count();
-                std::cout << "FPS: " << frame_count - old_fps_count << std::endl;
+                std::cout << "FPS: " << frame_count - old_fps_count;
+                auto& frames = engine.profiler().frames();
+                if (!frames.empty())
+                {
+                    // Averaged over the frames of the last second
+                    auto count = std::min<size_t>(frames.size(), std::max<size_t>(frame_count - old_fps_count, 1));
+                    uint64_t cpu_time = 0;
+                    uint64_t gpu_time = 0;
+                    for (auto it = frames.end() - (std::ptrdiff_t)count; it != frames.end(); it++)
+                    {
+                        cpu_time += it->cpu_time();
+                        gpu_time += it->gpu_time();
+                    }
+                    std::cout << " (CPU " << (double)cpu_time / (double)count / 1'000'000.0 << " ms, GPU "
+                              << (double)gpu_time / (double)count / 1'000'000.0 << " ms)";
+                }
+                std::cout << std::endl;
                 old_fps_count = frame_count;
             }
         }
+        // Delivers the capture of the last frame
+        engine.finish_read_backs();
+        if (!profile_path.empty() && engine.profiler().end_capture(profile_path))
+        {
+            vengine::log::info("main(int, char**)", std::string("Wrote profile to ").append(profile_path));
+        }
     }
     catch (const std::exception &e)
     {
@@ -6,12 +6,17 @@
 #include "../vengine/vulkan-utils/pipeline_builder.hpp"
 #include "../vengine/vulkan-utils/pipeline_layout_builder.hpp"
 #include "../vengine/mesh.hpp"
+#include "../vengine/mesh_optimizer.hpp"
 #include "../vengine/ecs/position.hpp"
 #include "../vengine/ecs/rotation.hpp"
 #include "../vengine/ecs/renderable.hpp"
 #include "../vengine/ecs/velocity.hpp"
 
+#include <array>
+#include <chrono>
 #include <filesystem>
+#include <string>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -51,22 +56,17 @@ glm::mat4 scenes::test::set_camera()
     projection[1][1] *= -1;
 
     auto projection_view = projection * view;
-    engine().current_frame_data().camera_buffer.with_mapped(
-            [&](auto &span)
-            {
-                auto camera_data = reinterpret_cast<vengine::vengine::gpu_camera_data *>(span.data());
-                camera_data->view = view;
-                camera_data->projection = projection;
-                camera_data->view_projection = projection * view;
-            });
+    auto camera_data = engine().current_frame_data().camera_buffer.mapped_as<vengine::vengine::gpu_camera_data>();
+    camera_data->view = view;
+    camera_data->projection = projection;
+    camera_data->view_projection = projection_view;
     return projection_view;
 }
 
-void scenes::test::render_pass(vengine::vengine::on_render_pass_event_args &args)
+void scenes::test::before_render_pass(vengine::vengine::on_before_render_pass_event_args &args)
 {
+    m_shaders.update();
     handle_player_input();
-    vkCmdBindPipeline(args.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
-    vkCmdBindDescriptorSets(args.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, 1, &args.current_frame_data.descriptor_set, 0, NULL);
 
     auto projection_view = set_camera();
 
@@ -78,65 +78,117 @@ void scenes::test::render_pass(vengine::vengine::on_render_pass_event_args &args
                  });
 
 
-    engine().current_frame_data().mesh_buffer.with_mapped(
-            [&](std::span<uint8_t>& span)
-            {
-                auto mesh_data = reinterpret_cast<vengine::vengine::gpu_mesh_data*>(span.data());
-                uint32_t render_index = 0;
-                vengine::mesh *current_mesh { };
-                auto view = ecs().view<const vengine::ecs::position, const vengine::ecs::rotation, const vengine::ecs::renderable>();
-                for (auto [entity, pos, rot, renderable] : view.each())
-                {
-                    auto scale = glm::scale(glm::mat4 { 1.0f }, renderable.scale);
-                    auto rotate = glm::mat4_cast(rot.data);
-                    auto translate = glm::translate(glm::mat4 { 1.0f }, pos.data);
-                    auto model = translate * rotate * scale;
-                    mesh_data[render_index].matrix = model;
-                    if (renderable.mesh != current_mesh)
-                    {
-                        VkDeviceSize offset = 0;
-                        vkCmdBindVertexBuffers(
-                                args.command_buffer,
-                                0,
-                                1,
-                                &renderable.mesh->vertex_buffer.buffer,
-                                &offset);
-                        current_mesh = renderable.mesh;
-                    }
-                    vkCmdDraw(args.command_buffer, (uint32_t) current_mesh->vertices.size(), 1, 0, render_index++);
-                }
-            });
+    {
+        VENGINE_PROFILE_ZONE("indirect_renderer::build");
+        m_indirect_renderer.build(ecs(), args.current_frame_data);
+    }
+    VENGINE_PROFILE_GPU_ZONE(engine().profiler(), args.command_buffer, "Culling");
+    m_indirect_renderer.cull(args.command_buffer, args.current_frame_data, projection_view);
 }
 
-void scenes::test::load_scene()
+void scenes::test::render_pass(vengine::vengine::on_render_pass_event_args &args)
 {
-    vengine::log::info("scenes::test::load_scene()", "Loading fragment shader");
-    m_fragment_shader = engine().create_shader_module(vengine::ram_file::from_disk("shaders/frag.spv").value()).value();
-    vengine::log::info("scenes::test::load_scene()", "Loading vertex shader");
-    m_vertex_shader = engine().create_shader_module(vengine::ram_file::from_disk("shaders/vert.spv").value()).value();
-    vengine::log::info("scenes::test::load_scene()", "Creating pipeline layout");
-    m_pipeline_layout = vengine::vulkan_utils::pipeline_layout_builder(engine().vulkan_device())
-            // .add_push_constant_range(sizeof(vengine::mesh::push_constant),0,VK_SHADER_STAGE_VERTEX_BIT)
-            .add_descriptor_set_layout(engine().vulkan_descriptor_set_layout())
-            .build()
-            .value();
-    vengine::log::info("scenes::test::load_scene()", "Creating pipeline");
-    m_pipeline = vengine::vulkan_utils::pipeline_builder(
+    struct draw_pass
+    {
+        vengine::vertex_format format;
+        VkPipeline pipeline;
+        // String literal, names the GPU zone
+        const char* name;
+    };
+    // Pipelines are looked up here, m_shaders is not thread safe
+    std::vector<draw_pass> draw_passes {
+            { vengine::vertex_format::standard, m_shaders.pipeline(m_pipeline), "Scene draw (standard)" } };
+    if (m_compact_pipeline.has_value())
+    {
+        draw_passes.push_back({ vengine::vertex_format::compact, m_shaders.pipeline(m_compact_pipeline.value()), "Scene draw (compact)" });
+    }
+
+    // One secondary command buffer per vertex format, recorded on the worker threads
+    auto record_result = engine().record_parallel(args, draw_passes.size(), [&](VkCommandBuffer command_buffer, size_t index)
+    {
+        auto& draw_pass = draw_passes[index];
+        VENGINE_PROFILE_GPU_ZONE(engine().profiler(), command_buffer, draw_pass.name);
+        args.current_frame_data.bind_graphics_pipeline(command_buffer, m_pipeline_layout, draw_pass.pipeline);
+        m_indirect_renderer.record(command_buffer, args.current_frame_data, draw_pass.format);
+    });
+    if (!record_result)
+    {
+        vengine::log::error("scenes::test::render_pass(vengine::vengine::on_render_pass_event_args&)", "Failed to record the scene draws.");
+    }
+}
+
+vengine::vulkan_utils::result<VkPipeline> scenes::test::create_pipeline(vengine::vertex_format format, std::span<const VkShaderModule> modules)
+{
+    auto vertex_input_description = vengine::mesh::get_vertex_input_description(format);
+    return vengine::vulkan_utils::pipeline_builder(
             engine().vulkan_device(),
             engine().vulkan_render_pass(),
             engine().vulkan_default_viewport(),
             engine().vulkan_default_scissors(),
-            m_pipeline_layout).add_shader(m_fragment_shader, VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT)
-                              .add_shader(m_vertex_shader, VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)
+            m_pipeline_layout).set_pipeline_cache(engine().vulkan_pipeline_cache())
+                              .add_dynamic_state(VK_DYNAMIC_STATE_VIEWPORT)
+                              .add_dynamic_state(VK_DYNAMIC_STATE_SCISSOR)
+                              .add_shader(modules[0], VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT)
+                              .add_shader(modules[1], VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)
                               .set_input_assembly(VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
                               .set_rasterization(VkPolygonMode::VK_POLYGON_MODE_FILL)
                               .set_multisample()
                               .set_pipeline_depths_stencil_state(true, true, VK_COMPARE_OP_LESS_OR_EQUAL)
-                              .add_vertex_input_attribute_descriptions(vengine::vertex::get_vertex_input_description().attribute_descriptions)
-                              .add_vertex_input_binding_descriptions(vengine::vertex::get_vertex_input_description().binding_descriptions)
+                              .add_vertex_input_attribute_descriptions(vertex_input_description.attribute_descriptions)
+                              .add_vertex_input_binding_descriptions(vertex_input_description.binding_descriptions)
                               .add_color_blend()
-                              .build()
-                              .value();
+                              .build();
+}
+
+void scenes::test::load_scene()
+{
+    vengine::log::info("scenes::test::load_scene()", "Reading shaders");
+    // Culling shader is read in the background, m_shaders reloads the graphics shaders whenever they change on disk
+    const std::array<std::filesystem::path, 1> shader_paths { "shaders/cull.spv" };
+    auto shader_files = engine().file_io().read(shader_paths);
+    vengine::log::info("scenes::test::load_scene()", "Loading fragment and vertex shader");
+    const std::array<vengine::shader_reloader::shader_handle, 2> graphics_shaders {
+            m_shaders.add_shader("shaders/frag.spv").value(),
+            m_shaders.add_shader("shaders/vert.spv").value() };
+    vengine::log::info("scenes::test::load_scene()", "Loading culling shader");
+    auto cull_shader_file = shader_files[0].get();
+    if (cull_shader_file.has_value())
+    {
+        m_cull_shader = engine().create_shader_module(cull_shader_file.value()).value();
+        if (!m_indirect_renderer.enable_culling(engine(), m_cull_shader))
+        {
+            vengine::log::warning("scenes::test::load_scene()", "Failed to enable GPU culling, drawing everything.");
+        }
+    }
+    else
+    {
+        vengine::log::warning("scenes::test::load_scene()", "shaders/cull.spv not found, drawing everything.");
+    }
+    vengine::log::info("scenes::test::load_scene()", "Creating pipeline layout");
+    m_pipeline_layout = vengine::vulkan_utils::pipeline_layout_builder(engine().vulkan_device())
+            // .add_push_constant_range(sizeof(vengine::mesh::push_constant),0,VK_SHADER_STAGE_VERTEX_BIT)
+            .add_descriptor_set_layout(engine().vulkan_descriptor_set_layout())
+            .build()
+            .value();
+    vengine::log::info("scenes::test::load_scene()", "Creating pipelines");
+    m_pipeline = m_shaders.add_pipeline(graphics_shaders, [this](auto modules) {
+        return create_pipeline(vengine::vertex_format::standard, modules);
+    }).value();
+    // compact_vertex needs a vertex shader of its own, decoding the normal
+    if (auto compact_vertex_shader = m_shaders.add_shader("shaders/compact_vert.spv"); compact_vertex_shader.good())
+    {
+        const std::array<vengine::shader_reloader::shader_handle, 2> compact_shaders {
+                graphics_shaders[0],
+                compact_vertex_shader.value() };
+        m_compact_pipeline = m_shaders.add_pipeline(compact_shaders, [this](auto modules) {
+            return create_pipeline(vengine::vertex_format::compact, modules);
+        }).value();
+    }
+    else
+    {
+        vengine::log::warning("scenes::test::load_scene()", "shaders/compact_vert.spv not found, drawing the monkey head with the standard vertex format.");
+    }
+    auto monkey_format = m_compact_pipeline.has_value() ? vengine::vertex_format::compact : vengine::vertex_format::standard;
     vengine::log::info("scenes::test::load_scene()", "Creating triangle mesh");
     m_triangle_mesh = vengine::mesh {
             vengine::vertex {
@@ -154,11 +206,39 @@ void scenes::test::load_scene()
     vengine::log::info("scenes::test::load_scene()", "Uploading triangle mesh");
     m_triangle_mesh.upload_to_gpu_memory(engine(), engine().allocator());
     vengine::log::info("scenes::test::load_scene()", "Loading monkey head mesh");
-    m_monkey_mesh = vengine::mesh::from_obj(
-            vengine::ram_file::from_disk("assets/monkey_smooth.obj").value(),
-            vengine::ram_file::from_disk("assets/monkey_smooth.mtl").value()).value();
+    // Rebaked whenever monkey_smooth.obj changes
+    if (auto baked_monkey_mesh = vengine::mesh::from_baked("assets/monkey_smooth.vmesh", "assets/monkey_smooth.obj");
+            baked_monkey_mesh.has_value() && baked_monkey_mesh->format == monkey_format)
+    {
+        m_monkey_mesh = baked_monkey_mesh.value();
+    }
+    else
+    {
+        m_monkey_mesh = vengine::mesh::from_obj(
+                vengine::ram_file::map_from_disk("assets/monkey_smooth.obj").value(),
+                vengine::ram_file::from_disk("assets/monkey_smooth.mtl").value(),
+                &engine().worker_pool()).value();
+        vengine::log::info("scenes::test::load_scene()", "Optimizing monkey head mesh");
+        vengine::mesh_optimizer::optimize(m_monkey_mesh);
+        m_monkey_mesh.format = monkey_format;
+        vengine::log::info("scenes::test::load_scene()", "Baking monkey head mesh");
+        if (!m_monkey_mesh.bake("assets/monkey_smooth.vmesh", "assets/monkey_smooth.obj"))
+        {
+            vengine::log::warning("scenes::test::load_scene()", "Failed to bake monkey head mesh, the OBJ will be parsed again next start.");
+        }
+    }
     vengine::log::info("scenes::test::load_scene()", "Uploading monkey head mesh");
     m_monkey_mesh.upload_to_gpu_memory(engine(), engine().allocator());
+    // Both meshes land in a single transfer submit
+    vengine::log::info("scenes::test::load_scene()", "Waiting for uploads");
+    engine().uploads().wait_all();
+
+    for (auto& statistics : engine().file_io().take_statistics())
+    {
+        vengine::log::info("scenes::test::load_scene()", std::string("Read ").append(statistics.path.string()).append(" (")
+                .append(std::to_string(statistics.size)).append(" bytes) in ")
+                .append(std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(statistics.latency).count())).append("us"));
+    }
 
     vengine::log::info("scenes::test::load_scene()", "Creating camera");
     {
@@ -232,12 +312,13 @@ void scenes::test::unload_scene()
 {
     m_triangle_mesh.destroy();
     m_monkey_mesh.destroy();
-    engine().destroy_shader_module(m_fragment_shader);
-    engine().destroy_shader_module(m_vertex_shader);
-    vkDestroyPipeline(engine().vulkan_device(), m_pipeline, nullptr);
+    m_shaders.destroy();
+    m_indirect_renderer.destroy();
+    if (m_cull_shader)
+    {
+        engine().destroy_shader_module(m_cull_shader);
+    }
     vkDestroyPipelineLayout(engine().vulkan_device(), m_pipeline_layout, nullptr);
-    m_triangle_mesh.vertex_buffer.destroy();
-    m_monkey_mesh.vertex_buffer.destroy();
 }
 
 void scenes::test::handle_player_input()
@@ -8,31 +8,42 @@
 #include "../vengine/scene.hpp"
 #include "../vengine/mesh.hpp"
 #include "../vengine/vengine.hpp"
+#include "../vengine/indirect_renderer.hpp"
+#include "../vengine/shader_reloader.hpp"
+
+#include <optional>
+#include <span>
 
 namespace scenes
 {
     class test : public vengine::scene
     {
-        VkShaderModule m_fragment_shader{};
-        VkShaderModule m_vertex_shader{};
+        VkShaderModule m_cull_shader{};
         VkPipelineLayout m_pipeline_layout{};
-        VkPipeline m_pipeline{};
+        vengine::shader_reloader m_shaders;
+        vengine::shader_reloader::pipeline_handle m_pipeline{};
+        // Empty if shaders/compact_vert.spv is missing, every mesh uses vertex_format::standard then
+        std::optional<vengine::shader_reloader::pipeline_handle> m_compact_pipeline{};
         vengine::mesh m_triangle_mesh;
         vengine::mesh m_monkey_mesh;
         bool m_can_rotate;
         entt::entity m_camera;
+        vengine::indirect_renderer m_indirect_renderer;
 
         void callback_mouse_button(vengine::vengine& engine, vengine::vengine::on_mouse_button_event_args& args);
         void callback_mouse_move(vengine::vengine& engine, vengine::vengine::on_mouse_move_event_args& args);
     protected:
+        void before_render_pass(::vengine::vengine::on_before_render_pass_event_args &args) override;
         void render_pass(::vengine::vengine::on_render_pass_event_args &args) override;
         void load_scene() override;
         void unload_scene() override;
 
         void handle_player_input();
         glm::mat4 set_camera();
+        // modules are the fragment and vertex shader, invoked on the shader_reloader thread on changes
+        vengine::vulkan_utils::result<VkPipeline> create_pipeline(vengine::vertex_format format, std::span<const VkShaderModule> modules);
     public:
-        explicit test(vengine::vengine& engine) : vengine::scene(engine), m_can_rotate(false) {}
+        explicit test(vengine::vengine& engine) : vengine::scene(engine), m_shaders(engine), m_can_rotate(false), m_indirect_renderer(engine) {}
 
     };
 }
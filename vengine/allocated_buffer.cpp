@@ -15,4 +15,5 @@ void vengine::allocated_buffer::destroy()
     buffer = nullptr;
     allocation = nullptr;
     size = 0;
+    mapped_data = nullptr;
 }
@@ -20,14 +20,80 @@ namespace vengine
         VmaAllocation allocation;
         VmaAllocator allocator;
         size_t size;
-        allocated_buffer() : buffer(nullptr), allocation(nullptr), allocator(nullptr), size(0) {}
-        explicit allocated_buffer(VmaAllocator allocator) : buffer(nullptr), allocation(nullptr), allocator(allocator), size(0) {}
+        void* mapped_data;
+        allocated_buffer() : buffer(nullptr), allocation(nullptr), allocator(nullptr), size(0), mapped_data(nullptr) {}
+        explicit allocated_buffer(VmaAllocator allocator) : buffer(nullptr), allocation(nullptr), allocator(allocator), size(0), mapped_data(nullptr) {}
 
         [[nodiscard]] bool uploaded() const { return buffer || allocator || allocation; }
+        [[nodiscard]] bool persistently_mapped() const { return mapped_data != nullptr; }
         void destroy();
 
+        /**
+         * Access to the memory of a persistently mapped buffer (see buffer_builder::set_persistently_mapped).
+         * No map call is involved, the returned span stays valid until the buffer is destroyed.
+         *
+         * @returns The mapped memory or an empty span if the buffer is not persistently mapped.
+         */
+        [[nodiscard]] std::span<uint8_t> mapped() const
+        {
+            if (!mapped_data)
+            {
+                return { };
+            }
+            return { reinterpret_cast<uint8_t*>(mapped_data), size };
+        }
+
+        /**
+         * Typed access to the memory of a persistently mapped buffer.
+         *
+         * @returns Pointer to the start of the buffer or nullptr if the buffer is not persistently mapped.
+         */
+        template<typename T>
+        [[nodiscard]] T* mapped_as() const
+        {
+            return reinterpret_cast<T*>(mapped_data);
+        }
+
+        /**
+         * Makes host writes to a persistently mapped buffer visible to the device.
+         * Is a no-op for host-coherent memory.
+         */
+        vulkan_utils::result<void> flush(size_t offset = 0, size_t length = VK_WHOLE_SIZE) const
+        {
+            auto flush_result = vmaFlushAllocation(allocator, allocation, offset, length);
+            if (flush_result != VK_SUCCESS)
+            {
+                auto message = std::string("Failed to flush memory (").append(vulkan_utils::stringify::data(flush_result)).append(")");
+                log::error("vengine::allocated_buffer::flush(size_t, size_t)", message);
+                return { flush_result, message };
+            }
+            return {};
+        }
+
+        /**
+         * Makes device writes to a persistently mapped buffer visible to the host.
+         * Is a no-op for host-coherent memory.
+         */
+        vulkan_utils::result<void> invalidate(size_t offset = 0, size_t length = VK_WHOLE_SIZE) const
+        {
+            auto invalidate_result = vmaInvalidateAllocation(allocator, allocation, offset, length);
+            if (invalidate_result != VK_SUCCESS)
+            {
+                auto message = std::string("Failed to invalidate memory (").append(vulkan_utils::stringify::data(invalidate_result)).append(")");
+                log::error("vengine::allocated_buffer::invalidate(size_t, size_t)", message);
+                return { invalidate_result, message };
+            }
+            return {};
+        }
+
         vulkan_utils::result<void> with_mapped(const std::function<void(std::span<uint8_t>&)>& func) const
         {
+            if (mapped_data)
+            {
+                std::span span{ reinterpret_cast<uint8_t*>(mapped_data), size };
+                func(span);
+                return {};
+            }
             void* data{};
             auto map_memory_result = vmaMapMemory(allocator, allocation, &data);
             if (map_memory_result != VK_SUCCESS)
@@ -0,0 +1,432 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "async_io.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+// Minimal io_uring ring, liburing is not required for the handful of operations needed here
+struct vengine::async_io::uring
+{
+    int descriptor = -1;
+    int event_descriptor = -1;
+    io_uring_params params { };
+    void* sq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    void* cq_ring = MAP_FAILED;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // Submissions written but not yet passed to io_uring_enter
+    unsigned pending_submissions = 0;
+
+    ~uring()
+    {
+        if (sqes != MAP_FAILED)
+        {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+        {
+            munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring != MAP_FAILED)
+        {
+            munmap(sq_ring, sq_ring_size);
+        }
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+        if (event_descriptor >= 0)
+        {
+            close(event_descriptor);
+        }
+    }
+
+    bool setup(unsigned entries)
+    {
+        descriptor = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED)
+        {
+            return false;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            cq_ring = sq_ring;
+        }
+        else
+        {
+            cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED)
+            {
+                return false;
+            }
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        auto sq_bytes = static_cast<uint8_t*>(sq_ring);
+        auto cq_bytes = static_cast<uint8_t*>(cq_ring);
+        sq_tail = reinterpret_cast<unsigned*>(sq_bytes + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq_bytes + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq_bytes + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned*>(cq_bytes + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq_bytes + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq_bytes + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq_bytes + params.cq_off.cqes);
+
+        event_descriptor = eventfd(0, EFD_CLOEXEC);
+        return event_descriptor >= 0;
+    }
+
+    // The I/O thread is the only producer, the kernel only consumes
+    io_uring_sqe& next_submission()
+    {
+        auto tail = *sq_tail;
+        auto index = tail & sq_mask;
+        auto& sqe = sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        pending_submissions++;
+        return sqe;
+    }
+
+    void prepare_read(request& req)
+    {
+        req.iovec.base = req.data.data() + req.read;
+        req.iovec.length = req.data.size() - req.read;
+        auto& sqe = next_submission();
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = req.descriptor;
+        sqe.off = req.read;
+        sqe.addr = reinterpret_cast<uint64_t>(&req.iovec);
+        sqe.len = 1;
+        sqe.user_data = reinterpret_cast<uint64_t>(&req);
+    }
+
+    // One shot, re-armed after every wakeup
+    void prepare_wakeup()
+    {
+        auto& sqe = next_submission();
+        sqe.opcode = IORING_OP_POLL_ADD;
+        sqe.fd = event_descriptor;
+        sqe.poll_events = POLLIN;
+        sqe.user_data = 0;
+    }
+
+    void wake() const
+    {
+        uint64_t value = 1;
+        [[maybe_unused]] auto written = write(event_descriptor, &value, sizeof(value));
+    }
+
+    // Submits pending submissions and blocks until at least one completion is available
+    bool submit_and_wait()
+    {
+        while (true)
+        {
+            auto result = syscall(__NR_io_uring_enter, descriptor, pending_submissions, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0)
+            {
+                pending_submissions -= (unsigned)result;
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                return false;
+            }
+        }
+    }
+};
+static_assert(sizeof(iovec) == sizeof(void*) + sizeof(size_t), "request::iovec has to match struct iovec");
+#else
+struct vengine::async_io::uring
+{
+};
+#endif
+
+vengine::async_io::async_io(size_t queue_depth, size_t fallback_threads)
+        : m_fallback_threads(std::max<size_t>(fallback_threads, 1)),
+        m_stop(false),
+        m_uring_failed(false)
+{
+#ifdef __linux__
+    auto ring = std::make_unique<uring>();
+    // One entry is kept for the wakeup poll
+    if (ring->setup((unsigned)std::max<size_t>(queue_depth, 2)))
+    {
+        m_uring = std::move(ring);
+        m_thread = std::thread([this]() { uring_main(); });
+        return;
+    }
+    log::info("vengine::async_io::async_io(size_t, size_t)",
+              std::string("io_uring is not available (").append(strerror(errno)).append("), falling back to blocking reads on worker threads."));
+#else
+    (void)queue_depth;
+#endif
+    m_fallback_pool = std::make_unique<utils::worker_pool>(m_fallback_threads);
+}
+
+vengine::async_io::~async_io()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_stop = true;
+    }
+#ifdef __linux__
+    if (m_uring)
+    {
+        m_uring->wake();
+    }
+#endif
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    // Joins the workers after they finished all queued reads
+    m_fallback_pool.reset();
+}
+
+void vengine::async_io::record_statistics(const std::filesystem::path& path, size_t size, std::chrono::steady_clock::time_point queued, bool success)
+{
+    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - queued);
+    std::unique_lock lock(m_statistics_mutex);
+    m_statistics.push_back({ path, size, latency, success });
+}
+
+void vengine::async_io::complete(std::unique_ptr<request> req, bool success)
+{
+#ifdef __linux__
+    if (req->descriptor >= 0)
+    {
+        close(req->descriptor);
+    }
+#endif
+    record_statistics(req->path, req->data.size(), req->queued, success);
+    if (success)
+    {
+        req->promise.set_value(ram_file(std::move(req->data)));
+    }
+    else
+    {
+        req->promise.set_value({ });
+    }
+}
+
+std::future<std::optional<vengine::ram_file>> vengine::async_io::read_blocking(
+        utils::worker_pool& pool, const std::filesystem::path& path, std::chrono::steady_clock::time_point queued)
+{
+    return pool.submit([this, path, queued]() {
+        auto file = ram_file::from_disk(path);
+        record_statistics(path, file.has_value() ? file->size() : 0, queued, file.has_value());
+        return file;
+    });
+}
+
+std::future<std::optional<vengine::ram_file>> vengine::async_io::read(const std::filesystem::path& path)
+{
+    return std::move(read(std::span<const std::filesystem::path>(&path, 1)).front());
+}
+
+std::vector<std::future<std::optional<vengine::ram_file>>> vengine::async_io::read(std::span<const std::filesystem::path> paths)
+{
+    std::vector<std::future<std::optional<ram_file>>> futures;
+    futures.reserve(paths.size());
+    auto queued = std::chrono::steady_clock::now();
+    if (!m_uring)
+    {
+        for (auto& path : paths)
+        {
+            futures.push_back(read_blocking(*m_fallback_pool, path, queued));
+        }
+        return futures;
+    }
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_uring_failed)
+        {
+            // Nothing consumes m_queue anymore
+            if (!m_fallback_pool)
+            {
+                m_fallback_pool = std::make_unique<utils::worker_pool>(m_fallback_threads);
+            }
+            for (auto& path : paths)
+            {
+                futures.push_back(read_blocking(*m_fallback_pool, path, queued));
+            }
+            return futures;
+        }
+        for (auto& path : paths)
+        {
+            auto req = std::make_unique<request>();
+            req->path = path;
+            req->queued = queued;
+            futures.push_back(req->promise.get_future());
+            m_queue.push_back(std::move(req));
+        }
+    }
+#ifdef __linux__
+    m_uring->wake();
+#endif
+    return futures;
+}
+
+std::vector<vengine::async_io::request_statistics> vengine::async_io::take_statistics()
+{
+    std::unique_lock lock(m_statistics_mutex);
+    return std::exchange(m_statistics, { });
+}
+
+void vengine::async_io::uring_main()
+{
+#ifdef __linux__
+    const char* source = "vengine::async_io::uring_main()";
+    auto& ring = *m_uring;
+    // Keyed by address, which is also the user_data of the submission
+    std::vector<std::unique_ptr<request>> in_flight;
+    auto capacity = ring.params.sq_entries - 1;
+    ring.prepare_wakeup();
+    while (true)
+    {
+        std::vector<std::unique_ptr<request>> started;
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_stop && m_queue.empty() && in_flight.empty())
+            {
+                break;
+            }
+            while (!m_queue.empty() && in_flight.size() + started.size() < capacity)
+            {
+                started.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+            }
+        }
+        for (auto& req : started)
+        {
+            // Opening is left synchronous, it only touches metadata which usually is cached
+            req->descriptor = open(req->path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat file_stat { };
+            if (req->descriptor < 0 || fstat(req->descriptor, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+            {
+                log::error(source, "Failed to open file: " + req->path.string());
+                complete(std::move(req), false);
+                continue;
+            }
+            req->data.resize((size_t)file_stat.st_size);
+            if (req->data.empty())
+            {
+                complete(std::move(req), true);
+                continue;
+            }
+            ring.prepare_read(*req);
+            in_flight.push_back(std::move(req));
+        }
+
+        if (!ring.submit_and_wait())
+        {
+            log::error(source, std::string("io_uring_enter failed: ").append(strerror(errno))
+                    .append(", falling back to blocking reads on worker threads."));
+            break;
+        }
+
+        auto head = *ring.cq_head;
+        auto tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            auto& cqe = ring.cqes[head & ring.cq_mask];
+            if (cqe.user_data == 0)
+            {
+                uint64_t value;
+                [[maybe_unused]] auto read = ::read(ring.event_descriptor, &value, sizeof(value));
+                ring.prepare_wakeup();
+                continue;
+            }
+            auto req_ptr = reinterpret_cast<request*>(cqe.user_data);
+            auto it = std::find_if(in_flight.begin(), in_flight.end(), [&](auto& r) { return r.get() == req_ptr; });
+            auto& req = *it;
+            if (cqe.res == -EAGAIN || cqe.res == -EINTR)
+            {
+                ring.prepare_read(*req);
+                continue;
+            }
+            if (cqe.res <= 0)
+            {
+                // 0 means the file got truncated while reading
+                log::error(source, std::string("Failed to read file: ").append(req->path.string()).append(" (")
+                        .append(strerror(cqe.res < 0 ? -cqe.res : EIO)).append(")"));
+                complete(std::move(req), false);
+                in_flight.erase(it);
+                continue;
+            }
+            req->read += (size_t)cqe.res;
+            if (req->read < req->data.size())
+            {
+                // Short read, queue the remainder
+                ring.prepare_read(*req);
+                continue;
+            }
+            complete(std::move(req), true);
+            in_flight.erase(it);
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+    // Only reached early if io_uring_enter failed, nothing may be left waiting forever.
+    // Set under the lock, read queues to the fallback pool from now on and m_queue stays empty.
+    std::unique_lock lock(m_mutex);
+    m_uring_failed = true;
+    for (auto& req : in_flight)
+    {
+        complete(std::move(req), false);
+    }
+    while (!m_queue.empty())
+    {
+        complete(std::move(m_queue.front()), false);
+        m_queue.pop_front();
+    }
+#endif
+}
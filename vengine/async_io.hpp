@@ -0,0 +1,121 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_ASYNC_IO_HPP
+#define GAME_PROJ_ASYNC_IO_HPP
+
+#include "ram_file.hpp"
+#include "worker_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace vengine
+{
+    /**
+     * Reads whole files in the background.
+     *
+     * On linux all queued reads are submitted at once through io_uring and completed by a single
+     * I/O thread, elsewhere (or if the kernel refuses io_uring) each read is a blocking
+     * ram_file::from_disk on a small worker_pool. If io_uring fails later on, reads queued from then on
+     * fall back to the worker_pool as well. Either way, many reads are in flight at the same
+     * time, hence loading is bound by the disk rather than by sequential open/read/close round-trips.
+     *
+     * Thread safe.
+     */
+    class async_io
+    {
+    public:
+        struct request_statistics
+        {
+            std::filesystem::path path;
+            size_t size;
+            // From queueing the request until the file was fully read
+            std::chrono::nanoseconds latency;
+            bool success;
+        };
+    private:
+        struct request
+        {
+            std::filesystem::path path;
+            std::promise<std::optional<ram_file>> promise;
+            std::chrono::steady_clock::time_point queued;
+            int descriptor = -1;
+            std::vector<uint8_t> data;
+            size_t read = 0;
+            // Referenced by the in flight submission, needs a stable address
+            struct
+            {
+                void* base;
+                size_t length;
+            } iovec { };
+        };
+        struct uring;
+
+        std::unique_ptr<uring> m_uring;
+        // Created in the constructor if io_uring is not available, else lazily under m_mutex once m_uring_failed is set
+        std::unique_ptr<utils::worker_pool> m_fallback_pool;
+        size_t m_fallback_threads;
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::deque<std::unique_ptr<request>> m_queue;
+        bool m_stop;
+        // Set under m_mutex once the I/O thread exited because io_uring_enter failed
+        std::atomic<bool> m_uring_failed;
+
+        std::mutex m_statistics_mutex;
+        std::vector<request_statistics> m_statistics;
+
+        void uring_main();
+        void record_statistics(const std::filesystem::path& path, size_t size, std::chrono::steady_clock::time_point queued, bool success);
+        void complete(std::unique_ptr<request> req, bool success);
+        std::future<std::optional<ram_file>> read_blocking(utils::worker_pool& pool, const std::filesystem::path& path, std::chrono::steady_clock::time_point queued);
+    public:
+        /**
+         * @param queue_depth Maximum number of reads in flight through io_uring.
+         * @param fallback_threads Number of threads blocking on reads if io_uring is not available.
+         */
+        async_io(size_t queue_depth, size_t fallback_threads);
+        async_io(const async_io&) = delete;
+        async_io& operator=(const async_io&) = delete;
+        /**
+         * Waits for all queued reads to complete.
+         */
+        ~async_io();
+
+        /**
+         * Queues a read of the whole file at path.
+         *
+         * @returns A future receiving the file contents or an empty optional if the file could not be read.
+         */
+        [[nodiscard]] std::future<std::optional<ram_file>> read(const std::filesystem::path& path);
+
+        /**
+         * Queues reads of all paths at once.
+         *
+         * @returns One future per path, in the order of paths.
+         */
+        [[nodiscard]] std::vector<std::future<std::optional<ram_file>>> read(std::span<const std::filesystem::path> paths);
+
+        [[nodiscard]] bool uses_io_uring() const { return m_uring != nullptr && !m_uring_failed.load(); }
+
+        /**
+         * Returns and clears the statistics of all reads completed since the last call.
+         */
+        [[nodiscard]] std::vector<request_statistics> take_statistics();
+    };
+}
+
+#endif //GAME_PROJ_ASYNC_IO_HPP
@@ -0,0 +1,67 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_BAKED_MESH_HPP
+#define GAME_PROJ_BAKED_MESH_HPP
+
+#include <cstdint>
+
+/**
+ * On disk layout of baked meshes (.vmesh), written by mesh::bake and read by mesh::from_baked.
+ *
+ * All values are little endian. The file starts with a file_header, followed by the
+ * vertex stream, the index stream and submesh_count file_submesh records at the offsets
+ * given in the header. Each section starts at a multiple of section_alignment.
+ *
+ * The vertex and index streams are stored in the exact layout the GPU consumes
+ * (see vertex_format and index_type), hence loading them is a plain copy.
+ */
+namespace vengine::baked_mesh
+{
+    const char magic[4] = { 'V', 'M', 'S', 'H' };
+    // Bump whenever the layout below changes, older files are rejected
+    const uint32_t version = 2;
+    const uint64_t section_alignment = 16;
+
+    enum class index_type : uint32_t
+    {
+        uint16 = 0,
+        uint32 = 1,
+    };
+
+#pragma pack(push, 1)
+    struct file_header
+    {
+        char magic[4];
+        uint32_t version;
+        // vengine::vertex_format
+        uint32_t vertex_format;
+        uint32_t index_type;
+        uint32_t vertex_count;
+        // Size of one vertex in bytes, must match vertex_format
+        uint32_t vertex_stride;
+        uint32_t index_count;
+        uint32_t submesh_count;
+        // xyz = center, w = radius
+        float bounding_sphere[4];
+        // Byte offsets from the start of the file
+        uint64_t vertex_data_offset;
+        uint64_t index_data_offset;
+        uint64_t submesh_data_offset;
+        // Of the file the mesh was baked from, both 0 if none was given.
+        // Write time is std::filesystem::file_time_type ticks.
+        uint64_t source_size;
+        int64_t source_write_time;
+    };
+
+    struct file_submesh
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        float bounding_sphere[4];
+    };
+#pragma pack(pop)
+}
+
+#endif //GAME_PROJ_BAKED_MESH_HPP
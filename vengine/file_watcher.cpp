@@ -0,0 +1,266 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "file_watcher.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+void vengine::file_watcher::record_change(const std::filesystem::path& path)
+{
+    std::unique_lock lock(m_mutex);
+    if (std::find(m_changes.begin(), m_changes.end(), path) == m_changes.end())
+    {
+        m_changes.push_back(path);
+    }
+}
+
+std::vector<std::filesystem::path> vengine::file_watcher::take_changes()
+{
+    std::unique_lock lock(m_mutex);
+    return std::exchange(m_changes, { });
+}
+
+#ifdef __linux__
+vengine::file_watcher::file_watcher() : m_stop(false), m_inotify_descriptor(-1), m_wakeup_descriptor(-1)
+{
+    m_inotify_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_wakeup_descriptor = eventfd(0, EFD_CLOEXEC);
+    if (m_inotify_descriptor < 0 || m_wakeup_descriptor < 0)
+    {
+        log::error("vengine::file_watcher::file_watcher()",
+                   std::string("Failed to initialize inotify (").append(strerror(errno)).append("), no changes are reported."));
+        return;
+    }
+    m_thread = std::thread([this]() { inotify_main(); });
+}
+
+vengine::file_watcher::~file_watcher()
+{
+    if (m_thread.joinable())
+    {
+        uint64_t value = 1;
+        if (write(m_wakeup_descriptor, &value, sizeof(value)) != sizeof(value))
+        {
+            log::warning("vengine::file_watcher::~file_watcher()", "Failed to wake the inotify thread.");
+        }
+        m_thread.join();
+    }
+    if (m_inotify_descriptor >= 0)
+    {
+        close(m_inotify_descriptor);
+    }
+    if (m_wakeup_descriptor >= 0)
+    {
+        close(m_wakeup_descriptor);
+    }
+}
+
+bool vengine::file_watcher::add_watch(const std::filesystem::path& directory, bool recursive)
+{
+    // Called with m_mutex locked
+    auto watch_descriptor = inotify_add_watch(m_inotify_descriptor, directory.c_str(),
+                                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF);
+    if (watch_descriptor < 0)
+    {
+        log::warning("vengine::file_watcher::add_watch(const std::filesystem::path&, bool)",
+                     std::string("Failed to watch ").append(directory.string()).append(" (").append(strerror(errno)).append(")."));
+        return false;
+    }
+    m_directories[watch_descriptor] = { directory, recursive };
+    if (!recursive)
+    {
+        return true;
+    }
+    std::error_code error_code;
+    for (auto& entry : std::filesystem::directory_iterator(directory, error_code))
+    {
+        if (entry.is_directory(error_code))
+        {
+            add_watch(entry.path(), true);
+        }
+    }
+    return true;
+}
+
+bool vengine::file_watcher::watch(const std::filesystem::path& directory, bool recursive)
+{
+    std::error_code error_code;
+    if (!m_thread.joinable() || !std::filesystem::is_directory(directory, error_code))
+    {
+        return false;
+    }
+    std::unique_lock lock(m_mutex);
+    return add_watch(directory, recursive);
+}
+
+void vengine::file_watcher::inotify_main()
+{
+    // Large enough for many events at once, aligned as required for inotify_event
+    alignas(inotify_event) char buffer[16 * 1024];
+    std::array<pollfd, 2> descriptors { pollfd { m_inotify_descriptor, POLLIN, 0 }, pollfd { m_wakeup_descriptor, POLLIN, 0 } };
+    while (true)
+    {
+        if (poll(descriptors.data(), descriptors.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            log::error("vengine::file_watcher::inotify_main()", std::string("Polling inotify failed (").append(strerror(errno)).append(")."));
+            return;
+        }
+        if (descriptors[1].revents & POLLIN)
+        {
+            return;
+        }
+
+        while (true)
+        {
+            auto length = read(m_inotify_descriptor, buffer, sizeof(buffer));
+            if (length <= 0)
+            {
+                break;
+            }
+            for (char* position = buffer; position < buffer + length;)
+            {
+                auto event = reinterpret_cast<const inotify_event*>(position);
+                position += sizeof(inotify_event) + event->len;
+
+                std::unique_lock lock(m_mutex);
+                auto directory = m_directories.find(event->wd);
+                if (directory == m_directories.end())
+                {
+                    continue;
+                }
+                if (event->mask & (IN_DELETE_SELF | IN_IGNORED))
+                {
+                    m_directories.erase(directory);
+                    continue;
+                }
+                if (event->len == 0)
+                {
+                    continue;
+                }
+                auto path = directory->second.path / event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    // Directories created below a recursively watched one are watched as well
+                    if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && directory->second.recursive)
+                    {
+                        add_watch(path, true);
+                    }
+                    continue;
+                }
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    lock.unlock();
+                    record_change(path);
+                }
+            }
+        }
+    }
+}
+#else
+vengine::file_watcher::file_watcher() : m_stop(false)
+{
+    m_thread = std::thread([this]() { poll_main(); });
+}
+
+vengine::file_watcher::~file_watcher()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void vengine::file_watcher::scan(const watched_directory& directory, bool report)
+{
+    // Called with m_mutex locked
+    std::error_code error_code;
+    auto check = [&](const std::filesystem::directory_entry& entry) {
+        if (!entry.is_regular_file(error_code))
+        {
+            return;
+        }
+        auto write_time = entry.last_write_time(error_code);
+        auto [it, inserted] = m_write_times.try_emplace(entry.path().native(), write_time);
+        if (!inserted && it->second != write_time)
+        {
+            it->second = write_time;
+            if (report && std::find(m_changes.begin(), m_changes.end(), entry.path()) == m_changes.end())
+            {
+                m_changes.push_back(entry.path());
+            }
+        }
+        else if (inserted && report)
+        {
+            m_changes.push_back(entry.path());
+        }
+    };
+    if (directory.recursive)
+    {
+        for (auto& entry : std::filesystem::recursive_directory_iterator(directory.path, error_code))
+        {
+            check(entry);
+        }
+    }
+    else
+    {
+        for (auto& entry : std::filesystem::directory_iterator(directory.path, error_code))
+        {
+            check(entry);
+        }
+    }
+}
+
+bool vengine::file_watcher::watch(const std::filesystem::path& directory, bool recursive)
+{
+    std::error_code error_code;
+    if (!std::filesystem::is_directory(directory, error_code))
+    {
+        return false;
+    }
+    std::unique_lock lock(m_mutex);
+    for (auto& watched : m_directories)
+    {
+        if (watched.path == directory)
+        {
+            return true;
+        }
+    }
+    m_directories.push_back({ directory, recursive });
+    // Existing files are only remembered, not reported
+    scan(m_directories.back(), false);
+    return true;
+}
+
+void vengine::file_watcher::poll_main()
+{
+    std::unique_lock lock(m_mutex);
+    while (!m_condition.wait_for(lock, poll_interval, [this]() { return m_stop; }))
+    {
+        for (auto& directory : m_directories)
+        {
+            scan(directory, true);
+        }
+    }
+}
+#endif
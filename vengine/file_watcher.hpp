@@ -0,0 +1,88 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_FILE_WATCHER_HPP
+#define GAME_PROJ_FILE_WATCHER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vengine
+{
+    /**
+     * Collects the files written below a set of directories.
+     *
+     * On linux a background thread blocks on inotify, reporting files once they were closed after
+     * writing or moved into place (as editors and compilers do on save). Elsewhere the thread polls
+     * the modification times of all files every poll_interval.
+     *
+     * Thread safe.
+     */
+    class file_watcher
+    {
+    public:
+        static constexpr std::chrono::milliseconds poll_interval { 500 };
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::thread m_thread;
+        bool m_stop;
+        // Changed files since the last take_changes, without duplicates
+        std::vector<std::filesystem::path> m_changes;
+#ifdef __linux__
+        int m_inotify_descriptor;
+        int m_wakeup_descriptor;
+        struct watched_directory
+        {
+            std::filesystem::path path;
+            bool recursive;
+        };
+        // By inotify watch descriptor
+        std::unordered_map<int, watched_directory> m_directories;
+
+        /**
+         * @returns false if directory itself cannot be watched, failing subdirectories are only logged.
+         */
+        bool add_watch(const std::filesystem::path& directory, bool recursive);
+        void inotify_main();
+#else
+        struct watched_directory
+        {
+            std::filesystem::path path;
+            bool recursive;
+        };
+        std::vector<watched_directory> m_directories;
+        std::unordered_map<std::filesystem::path::string_type, std::filesystem::file_time_type> m_write_times;
+
+        void scan(const watched_directory& directory, bool report);
+        void poll_main();
+#endif
+
+        void record_change(const std::filesystem::path& path);
+    public:
+        file_watcher();
+        file_watcher(const file_watcher&) = delete;
+        file_watcher& operator=(const file_watcher&) = delete;
+        ~file_watcher();
+
+        /**
+         * Starts watching directory, and all directories below it if recursive.
+         *
+         * @returns false if directory does not exist or cannot be watched.
+         */
+        bool watch(const std::filesystem::path& directory, bool recursive = true);
+
+        /**
+         * Returns and clears the files changed since the last call.
+         */
+        [[nodiscard]] std::vector<std::filesystem::path> take_changes();
+    };
+}
+
+#endif //GAME_PROJ_FILE_WATCHER_HPP
@@ -0,0 +1,127 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_FREE_LIST_ALLOCATOR_HPP
+#define GAME_PROJ_FREE_LIST_ALLOCATOR_HPP
+
+#include <map>
+#include <iterator>
+#include <optional>
+#include <cstdint>
+
+namespace vengine::utils
+{
+    /**
+     * Best fit allocator of ranges inside of [0, capacity).
+     *
+     * Only hands out offsets, the memory itself lives elsewhere (eg. inside of a geometry_pool buffer).
+     * Free ranges are kept sorted by offset and by size, hence allocate and free are O(log n)
+     * and neighbouring free ranges are merged right away.
+     */
+    class free_list_allocator
+    {
+        uint64_t m_capacity;
+        uint64_t m_free;
+        // offset -> size
+        std::map<uint64_t, uint64_t> m_free_by_offset;
+        // size -> offset
+        std::multimap<uint64_t, uint64_t> m_free_by_size;
+
+        void insert_range(uint64_t offset, uint64_t size)
+        {
+            m_free_by_offset.emplace(offset, size);
+            m_free_by_size.emplace(size, offset);
+        }
+        void erase_range(std::map<uint64_t, uint64_t>::iterator it)
+        {
+            auto [begin, end] = m_free_by_size.equal_range(it->second);
+            for (auto size_it = begin; size_it != end; size_it++)
+            {
+                if (size_it->second == it->first)
+                {
+                    m_free_by_size.erase(size_it);
+                    break;
+                }
+            }
+            m_free_by_offset.erase(it);
+        }
+    public:
+        free_list_allocator() : m_capacity(0), m_free(0) {}
+        explicit free_list_allocator(uint64_t capacity) : m_capacity(capacity), m_free(capacity)
+        {
+            if (capacity > 0)
+            {
+                insert_range(0, capacity);
+            }
+        }
+
+        /**
+         * Takes the smallest free range that fits size.
+         *
+         * @returns The offset of the allocation or an empty optional if no free range is large enough.
+         */
+        [[nodiscard]] std::optional<uint64_t> allocate(uint64_t size)
+        {
+            if (size == 0)
+            {
+                return { };
+            }
+            auto size_it = m_free_by_size.lower_bound(size);
+            if (size_it == m_free_by_size.end())
+            {
+                return { };
+            }
+            auto offset = size_it->second;
+            auto range_size = size_it->first;
+            m_free_by_size.erase(size_it);
+            m_free_by_offset.erase(offset);
+            if (range_size > size)
+            {
+                insert_range(offset + size, range_size - size);
+            }
+            m_free -= size;
+            return offset;
+        }
+
+        /**
+         * Returns a range handed out by allocate.
+         */
+        void free(uint64_t offset, uint64_t size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+            m_free += size;
+
+            // Merge with the free range following
+            auto next = m_free_by_offset.lower_bound(offset);
+            if (next != m_free_by_offset.end() && next->first == offset + size)
+            {
+                size += next->second;
+                erase_range(next);
+            }
+            // Merge with the free range preceding
+            auto following = m_free_by_offset.lower_bound(offset);
+            if (following != m_free_by_offset.begin())
+            {
+                auto previous = std::prev(following);
+                if (previous->first + previous->second == offset)
+                {
+                    offset = previous->first;
+                    size += previous->second;
+                    erase_range(previous);
+                }
+            }
+            insert_range(offset, size);
+        }
+
+        [[nodiscard]] uint64_t capacity() const { return m_capacity; }
+        [[nodiscard]] uint64_t free_space() const { return m_free; }
+        [[nodiscard]] uint64_t largest_free_range() const { return m_free_by_size.empty() ? 0 : m_free_by_size.rbegin()->first; }
+        [[nodiscard]] size_t fragment_count() const { return m_free_by_offset.size(); }
+    };
+}
+
+#endif //GAME_PROJ_FREE_LIST_ALLOCATOR_HPP
@@ -0,0 +1,121 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "geometry_pool.hpp"
+#include "log.hpp"
+#include "vulkan-utils/buffer_builder.hpp"
+
+#include <string>
+
+size_t vengine::geometry_pool::vertex_stride(vertex_format format)
+{
+    return format == vertex_format::compact ? sizeof(compact_vertex) : sizeof(vertex);
+}
+
+size_t vengine::geometry_pool::index_size(VkIndexType index_type)
+{
+    return index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+vengine::vulkan_utils::result<void> vengine::geometry_pool::ensure_buffer(VmaAllocator allocator, pool& pool, size_t size, size_t element_size,
+                                                                          VkBufferUsageFlags usage)
+{
+    if (pool.buffer.uploaded())
+    {
+        return {};
+    }
+    auto element_count = size / element_size;
+    auto buffer_builder_result = vulkan_utils::buffer_builder(allocator, element_count * element_size)
+            .set_buffer_usage(usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+            .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .build();
+    if (!buffer_builder_result)
+    {
+        return buffer_builder_result;
+    }
+    pool.buffer = buffer_builder_result.value();
+    pool.allocator = utils::free_list_allocator(element_count);
+    return {};
+}
+
+vengine::vulkan_utils::result<vengine::geometry_range>
+vengine::geometry_pool::allocate(vertex_format format, uint32_t vertex_count, VkIndexType index_type, uint32_t index_count)
+{
+    const char* source = "vengine::geometry_pool::allocate(vertex_format, uint32_t, VkIndexType, uint32_t)";
+    auto& vertex_pool = m_vertex_pools[(size_t)format];
+    auto& index_pool = m_index_pools[index_pool_index(index_type)];
+
+    auto vertex_buffer_result = ensure_buffer(m_allocator, vertex_pool, m_vertex_buffer_size, vertex_stride(format), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    if (!vertex_buffer_result)
+    {
+        return { vertex_buffer_result.vk_result(), std::string(vertex_buffer_result.message()) };
+    }
+    auto index_buffer_result = ensure_buffer(m_allocator, index_pool, m_index_buffer_size, index_size(index_type), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    if (!index_buffer_result)
+    {
+        return { index_buffer_result.vk_result(), std::string(index_buffer_result.message()) };
+    }
+
+    auto first_vertex = vertex_pool.allocator.allocate(vertex_count);
+    if (!first_vertex.has_value())
+    {
+        auto message = std::string("Vertex buffer exhausted, ").append(std::to_string(vertex_count))
+                .append(" vertices requested but the largest free range has ")
+                .append(std::to_string(vertex_pool.allocator.largest_free_range())).append(" (see engine_options::geometry_vertex_buffer_size).");
+        log::error(source, message);
+        return { VK_ERROR_OUT_OF_DEVICE_MEMORY, message };
+    }
+    auto first_index = index_pool.allocator.allocate(index_count);
+    if (!first_index.has_value())
+    {
+        vertex_pool.allocator.free(first_vertex.value(), vertex_count);
+        auto message = std::string("Index buffer exhausted, ").append(std::to_string(index_count))
+                .append(" indices requested but the largest free range has ")
+                .append(std::to_string(index_pool.allocator.largest_free_range())).append(" (see engine_options::geometry_index_buffer_size).");
+        log::error(source, message);
+        return { VK_ERROR_OUT_OF_DEVICE_MEMORY, message };
+    }
+
+    geometry_range range { };
+    range.pool = this;
+    range.format = format;
+    range.index_type = index_type;
+    range.first_vertex = (uint32_t)first_vertex.value();
+    range.vertex_count = vertex_count;
+    range.first_index = (uint32_t)first_index.value();
+    range.index_count = index_count;
+    return { range };
+}
+
+void vengine::geometry_pool::free(const geometry_range& range)
+{
+    if (range.pool != this)
+    {
+        log::warning("vengine::geometry_pool::free(const geometry_range&)", "Attempt was made to free a range of a different pool.");
+        return;
+    }
+    m_vertex_pools[(size_t)range.format].allocator.free(range.first_vertex, range.vertex_count);
+    m_index_pools[index_pool_index(range.index_type)].allocator.free(range.first_index, range.index_count);
+}
+
+void vengine::geometry_pool::destroy()
+{
+    for (auto& pool : m_vertex_pools)
+    {
+        pool.buffer.destroy();
+        pool.allocator = { };
+    }
+    for (auto& pool : m_index_pools)
+    {
+        pool.buffer.destroy();
+        pool.allocator = { };
+    }
+}
+
+void vengine::geometry_pool::bind(VkCommandBuffer command_buffer, vertex_format format, VkIndexType index_type) const
+{
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &m_vertex_pools[(size_t)format].buffer.buffer, &offset);
+    vkCmdBindIndexBuffer(command_buffer, m_index_pools[index_pool_index(index_type)].buffer.buffer, 0, index_type);
+}
@@ -0,0 +1,98 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_GEOMETRY_POOL_HPP
+#define GAME_PROJ_GEOMETRY_POOL_HPP
+
+#include "mesh.hpp"
+#include "allocated_buffer.hpp"
+#include "free_list_allocator.hpp"
+#include "vulkan-utils/result.hpp"
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+
+namespace vengine
+{
+    /**
+     * Shared device local vertex and index buffers all meshes are suballocated from.
+     *
+     * There is one vertex buffer per vertex_format and one index buffer per index type, each
+     * created on first use. Meshes only hold their geometry_range, hence all draws of the same
+     * vertex_format and index type share a single bind and may be merged into one multi draw
+     * (see indirect_renderer).
+     *
+     * Ranges are counted in elements rather than bytes, which keeps every vertex range aligned
+     * to its stride as required by vertexOffset.
+     */
+    class geometry_pool
+    {
+        struct pool
+        {
+            allocated_buffer buffer;
+            utils::free_list_allocator allocator;
+        };
+
+        VmaAllocator m_allocator;
+        size_t m_vertex_buffer_size;
+        size_t m_index_buffer_size;
+        // Indexed by vertex_format
+        std::array<pool, 2> m_vertex_pools;
+        // Indexed by index_pool_index
+        std::array<pool, 2> m_index_pools;
+
+        static size_t vertex_stride(vertex_format format);
+        static size_t index_size(VkIndexType index_type);
+        static size_t index_pool_index(VkIndexType index_type) { return index_type == VK_INDEX_TYPE_UINT16 ? 0 : 1; }
+
+        /**
+         * Creates the buffer of pool if it does not exist yet.
+         */
+        static vulkan_utils::result<void> ensure_buffer(VmaAllocator allocator, pool& pool, size_t size, size_t element_size,
+                                                        VkBufferUsageFlags usage);
+    public:
+        /**
+         * @param vertex_buffer_size Size in bytes of every vertex buffer.
+         * @param index_buffer_size Size in bytes of every index buffer.
+         */
+        geometry_pool(VmaAllocator allocator, size_t vertex_buffer_size, size_t index_buffer_size)
+                : m_allocator(allocator),
+                m_vertex_buffer_size(vertex_buffer_size),
+                m_index_buffer_size(index_buffer_size),
+                m_vertex_pools(),
+                m_index_pools()
+        {
+        }
+        geometry_pool(const geometry_pool&) = delete;
+        geometry_pool& operator=(const geometry_pool&) = delete;
+        ~geometry_pool() { destroy(); }
+
+        /**
+         * Reserves vertex_count vertices and index_count indices.
+         * The buffers need to be filled via upload_manager::upload_buffer.
+         */
+        vulkan_utils::result<geometry_range> allocate(vertex_format format, uint32_t vertex_count, VkIndexType index_type, uint32_t index_count);
+
+        /**
+         * Returns range to the pool. The GPU must be done with it.
+         */
+        void free(const geometry_range& range);
+
+        /**
+         * Destroys all buffers. The GPU must be done with them.
+         */
+        void destroy();
+
+        [[nodiscard]] VkBuffer vertex_buffer(vertex_format format) const { return m_vertex_pools[(size_t)format].buffer.buffer; }
+        [[nodiscard]] VkBuffer index_buffer(VkIndexType index_type) const { return m_index_pools[index_pool_index(index_type)].buffer.buffer; }
+
+        /**
+         * Binds the vertex buffer of format and the index buffer of index_type.
+         */
+        void bind(VkCommandBuffer command_buffer, vertex_format format, VkIndexType index_type) const;
+    };
+}
+
+#endif //GAME_PROJ_GEOMETRY_POOL_HPP
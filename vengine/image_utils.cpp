@@ -0,0 +1,275 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "image_utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VENGINE_IMAGE_UTILS_SSE2
+#endif
+
+namespace
+{
+    using texel_block = uint8_t[16][4];
+
+    void expand_rgb565(uint16_t color, uint8_t* rgba)
+    {
+        auto r = (color >> 11) & 0x1F;
+        auto g = (color >> 5) & 0x3F;
+        auto b = color & 0x1F;
+        rgba[0] = (uint8_t)((r << 3) | (r >> 2));
+        rgba[1] = (uint8_t)((g << 2) | (g >> 4));
+        rgba[2] = (uint8_t)((b << 3) | (b >> 2));
+        rgba[3] = 255;
+    }
+
+    // four_colors is set for BC3 color blocks, which never use the three color mode
+    void decode_bc1_block(const uint8_t* block, texel_block& texels, bool has_alpha, bool four_colors)
+    {
+        auto color0 = (uint16_t)(block[0] | (block[1] << 8));
+        auto color1 = (uint16_t)(block[2] | (block[3] << 8));
+        uint8_t palette[4][4];
+        expand_rgb565(color0, palette[0]);
+        expand_rgb565(color1, palette[1]);
+        for (size_t channel = 0; channel < 3; channel++)
+        {
+            if (four_colors || color0 > color1)
+            {
+                palette[2][channel] = (uint8_t)((2 * palette[0][channel] + palette[1][channel] + 1) / 3);
+                palette[3][channel] = (uint8_t)((palette[0][channel] + 2 * palette[1][channel] + 1) / 3);
+            }
+            else
+            {
+                palette[2][channel] = (uint8_t)((palette[0][channel] + palette[1][channel] + 1) / 2);
+                palette[3][channel] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = (four_colors || color0 > color1 || !has_alpha) ? 255 : 0;
+
+        auto indices = (uint32_t)block[4] | ((uint32_t)block[5] << 8) | ((uint32_t)block[6] << 16) | ((uint32_t)block[7] << 24);
+        for (size_t texel = 0; texel < 16; texel++)
+        {
+            auto& color = palette[(indices >> (texel * 2)) & 3];
+            texels[texel][0] = color[0];
+            texels[texel][1] = color[1];
+            texels[texel][2] = color[2];
+            texels[texel][3] = color[3];
+        }
+    }
+
+    // A single channel as stored in BC3 alpha and both BC5 channels
+    void decode_bc4_block(const uint8_t* block, texel_block& texels, size_t channel)
+    {
+        uint32_t palette[8] = { block[0], block[1] };
+        if (palette[0] > palette[1])
+        {
+            for (uint32_t i = 1; i < 7; i++)
+            {
+                palette[i + 1] = ((7 - i) * palette[0] + i * palette[1] + 3) / 7;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; i++)
+            {
+                palette[i + 1] = ((5 - i) * palette[0] + i * palette[1] + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (size_t i = 0; i < 6; i++)
+        {
+            indices |= (uint64_t)block[2 + i] << (i * 8);
+        }
+        for (size_t texel = 0; texel < 16; texel++)
+        {
+            texels[texel][channel] = (uint8_t)palette[(indices >> (texel * 3)) & 7];
+        }
+    }
+}
+
+uint32_t vengine::image_utils::mip_level_count(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (auto size = std::max(width, height); size > 1; size /= 2)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+std::vector<vengine::upload_manager::image_level>
+vengine::image_utils::mip_chain_layout_rgba8(uint32_t width, uint32_t height, uint32_t mip_levels, size_t& total_size)
+{
+    std::vector<upload_manager::image_level> levels;
+    levels.reserve(mip_levels);
+    total_size = 0;
+    for (uint32_t level = 0; level < mip_levels; level++)
+    {
+        levels.push_back({ total_size, { width, height, 1 } });
+        total_size += (size_t)width * height * 4;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return levels;
+}
+
+void vengine::image_utils::downsample_rgba8(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst)
+{
+    auto dst_width = std::max(width / 2, 1u);
+    auto dst_height = std::max(height / 2, 1u);
+    for (uint32_t y = 0; y < dst_height; y++)
+    {
+        auto row0 = src + (size_t)std::min(y * 2, height - 1) * width * 4;
+        auto row1 = src + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+        auto dst_row = dst + (size_t)y * dst_width * 4;
+        uint32_t x = 0;
+#ifdef VENGINE_IMAGE_UTILS_SSE2
+        // Two output texels per iteration from four input texels of both rows
+        auto zero = _mm_setzero_si128();
+        auto rounding = _mm_set1_epi16(2);
+        for (; x + 2 <= dst_width && x * 2 + 4 <= width; x += 2)
+        {
+            auto top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+            auto bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+            // Vertical sums, 16 bit per channel: lo = texels 0 and 1, hi = texels 2 and 3
+            auto lo = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            auto hi = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+            // Horizontal sums end up in the lower four lanes of each
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            auto sum = _mm_unpacklo_epi64(lo, hi);
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_row + x * 4), _mm_packus_epi16(sum, sum));
+        }
+#endif
+        for (; x < dst_width; x++)
+        {
+            auto x0 = std::min(x * 2, width - 1) * 4;
+            auto x1 = std::min(x * 2 + 1, width - 1) * 4;
+            for (uint32_t channel = 0; channel < 4; channel++)
+            {
+                auto sum = (uint32_t)row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel];
+                dst_row[x * 4 + channel] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void vengine::image_utils::generate_mip_chain_rgba8(std::span<uint8_t> chain, std::span<const upload_manager::image_level> levels)
+{
+    for (size_t level = 1; level < levels.size(); level++)
+    {
+        auto& src = levels[level - 1];
+        downsample_rgba8(chain.data() + src.offset, src.extent.width, src.extent.height, chain.data() + levels[level].offset);
+    }
+}
+
+uint32_t vengine::image_utils::bc_block_size(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+size_t vengine::image_utils::level_size(VkFormat format, uint32_t width, uint32_t height)
+{
+    auto block_size = bc_block_size(format);
+    if (block_size == 0)
+    {
+        return (size_t)width * height * 4;
+    }
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * block_size;
+}
+
+VkFormat vengine::image_utils::decoded_format(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        default:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+bool vengine::image_utils::decode_bc_rgba8(VkFormat format, std::span<const uint8_t> blocks, uint32_t width, uint32_t height, uint8_t* dst)
+{
+    auto block_size = bc_block_size(format);
+    if (block_size == 0 || format == VK_FORMAT_BC7_UNORM_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK
+        || blocks.size() < level_size(format, width, height))
+    {
+        return false;
+    }
+
+    auto blocks_x = (width + 3) / 4;
+    auto blocks_y = (height + 3) / 4;
+    texel_block texels;
+    for (uint32_t block_y = 0; block_y < blocks_y; block_y++)
+    {
+        for (uint32_t block_x = 0; block_x < blocks_x; block_x++)
+        {
+            auto block = blocks.data() + ((size_t)block_y * blocks_x + block_x) * block_size;
+            switch (format)
+            {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                    decode_bc1_block(block, texels, false, false);
+                    break;
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                    decode_bc1_block(block, texels, true, false);
+                    break;
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                    decode_bc1_block(block + 8, texels, false, true);
+                    decode_bc4_block(block, texels, 3);
+                    break;
+                default:
+                    decode_bc4_block(block, texels, 0);
+                    decode_bc4_block(block + 8, texels, 1);
+                    for (auto& texel : texels)
+                    {
+                        texel[2] = 0;
+                        texel[3] = 255;
+                    }
+                    break;
+            }
+
+            // Blocks on the right and bottom edge may extend past the level
+            for (uint32_t y = 0; y < 4 && block_y * 4 + y < height; y++)
+            {
+                for (uint32_t x = 0; x < 4 && block_x * 4 + x < width; x++)
+                {
+                    auto texel = dst + (((size_t)block_y * 4 + y) * width + block_x * 4 + x) * 4;
+                    std::memcpy(texel, texels[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_IMAGE_UTILS_HPP
+#define GAME_PROJ_IMAGE_UTILS_HPP
+
+#include "upload_manager.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace vengine::image_utils
+{
+    /**
+     * Number of levels of a full mip chain, down to 1x1.
+     */
+    [[nodiscard]] uint32_t mip_level_count(uint32_t width, uint32_t height);
+
+    /**
+     * Tightly packed layout of mip_levels RGBA8 levels, level 0 first.
+     *
+     * @param total_size Receives the size in bytes of the whole chain.
+     */
+    [[nodiscard]] std::vector<upload_manager::image_level> mip_chain_layout_rgba8(uint32_t width, uint32_t height, uint32_t mip_levels,
+                                                                                  size_t& total_size);
+
+    /**
+     * Halves an RGBA8 image with a 2x2 box filter, odd edges are clamped.
+     * dst receives max(width / 2, 1) x max(height / 2, 1) texels.
+     *
+     * Averages the stored values, for sRGB formats this is slightly darker than filtering in linear space.
+     */
+    void downsample_rgba8(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst);
+
+    /**
+     * Fills every level but the first of chain (laid out as returned by mip_chain_layout_rgba8)
+     * by repeatedly downsampling level 0.
+     */
+    void generate_mip_chain_rgba8(std::span<uint8_t> chain, std::span<const upload_manager::image_level> levels);
+
+    /**
+     * Bytes per 4x4 block of the BC1, BC3, BC5 and BC7 formats, 0 for any other format.
+     */
+    [[nodiscard]] uint32_t bc_block_size(VkFormat format);
+
+    /**
+     * Size in bytes of a tightly packed width x height level of format (a BC format or RGBA8).
+     */
+    [[nodiscard]] size_t level_size(VkFormat format, uint32_t width, uint32_t height);
+
+    /**
+     * The RGBA8 format decode_bc_rgba8 produces for format, keeping its color space.
+     */
+    [[nodiscard]] VkFormat decoded_format(VkFormat format);
+
+    /**
+     * Decodes a level of BC1, BC3 or BC5 blocks into width x height RGBA8 texels.
+     * BC5 decodes into red and green, with blue 0 and alpha 255.
+     *
+     * @returns false if format cannot be decoded on the CPU (BC7) or blocks is too small.
+     */
+    [[nodiscard]] bool decode_bc_rgba8(VkFormat format, std::span<const uint8_t> blocks, uint32_t width, uint32_t height, uint8_t* dst);
+}
+
+#endif //GAME_PROJ_IMAGE_UTILS_HPP
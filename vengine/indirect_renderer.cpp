@@ -0,0 +1,458 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "indirect_renderer.hpp"
+#include "ecs/position.hpp"
+#include "ecs/rotation.hpp"
+#include "ecs/renderable.hpp"
+#include "vulkan-utils/buffer_builder.hpp"
+#include "vulkan-utils/compute_pipeline_builder.hpp"
+#include "vulkan-utils/descriptor_pool_builder.hpp"
+#include "vulkan-utils/descriptor_set_layout_builder.hpp"
+#include "vulkan-utils/descriptor_set_updater.hpp"
+#include "vulkan-utils/pipeline_layout_builder.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <string>
+
+namespace
+{
+    // Batch index marking a cull_data entry which has no valid command
+    const uint32_t invalid_batch_index = UINT32_MAX;
+    // Must match local_size_x of workingdir/shaders/cull.comp
+    const uint32_t cull_group_size = 64;
+
+    // Gribb/Hartmann plane extraction, planes point inside and are normalized
+    std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4& m)
+    {
+        auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+        std::array<glm::vec4, 6> planes {
+                row(3) + row(0), // left
+                row(3) - row(0), // right
+                row(3) + row(1), // bottom
+                row(3) - row(1), // top
+                row(2),          // near (depth range 0 to 1)
+                row(3) - row(2), // far
+        };
+        for (auto& plane : planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return planes;
+    }
+}
+
+vengine::vulkan_utils::result<void> vengine::indirect_renderer::enable_culling(::vengine::vengine& engine, VkShaderModule cull_shader)
+{
+    if (culling_enabled())
+    {
+        return {};
+    }
+    m_device = engine.vulkan_device();
+    auto frames = engine.frames_in_flight();
+    auto buffer_slots = engine.current_frame_data().mesh_buffer_size;
+
+    auto descriptor_pool_result = vulkan_utils::descriptor_pool_builder(m_device, frames)
+            .add_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 * frames)
+            .build();
+    if (!descriptor_pool_result)
+    {
+        destroy();
+        return descriptor_pool_result;
+    }
+    m_descriptor_pool = descriptor_pool_result.value();
+
+    auto descriptor_set_layout_result = vulkan_utils::descriptor_set_layout_builder(m_device)
+            .add_layout_binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+            .add_layout_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+            .add_layout_binding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+            .add_layout_binding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+            .add_layout_binding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+    if (!descriptor_set_layout_result)
+    {
+        destroy();
+        return descriptor_set_layout_result;
+    }
+    m_descriptor_set_layout = descriptor_set_layout_result.value();
+
+    auto pipeline_layout_result = vulkan_utils::pipeline_layout_builder(m_device)
+            .add_push_constant_range(sizeof(gpu_cull_constants), 0, VK_SHADER_STAGE_COMPUTE_BIT)
+            .add_descriptor_set_layout(m_descriptor_set_layout)
+            .build();
+    if (!pipeline_layout_result)
+    {
+        destroy();
+        return pipeline_layout_result;
+    }
+    m_cull_pipeline_layout = pipeline_layout_result.value();
+
+    auto pipeline_result = vulkan_utils::compute_pipeline_builder(m_device, m_cull_pipeline_layout)
+            .set_shader(cull_shader)
+            .set_pipeline_cache(engine.vulkan_pipeline_cache())
+            .build();
+    if (!pipeline_result)
+    {
+        destroy();
+        return pipeline_result;
+    }
+    m_cull_pipeline = pipeline_result.value();
+
+    m_culling_frames.resize(frames);
+    for (auto& culling_frame : m_culling_frames)
+    {
+        auto cull_buffer_result = vulkan_utils::buffer_builder(engine.allocator(), sizeof(gpu_cull_data) * buffer_slots)
+                .set_buffer_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_CPU_TO_GPU)
+                .set_persistently_mapped()
+                .build();
+        if (!cull_buffer_result)
+        {
+            destroy();
+            return cull_buffer_result;
+        }
+        culling_frame.cull_buffer = cull_buffer_result.value();
+
+        auto output_buffer_result = vulkan_utils::buffer_builder(engine.allocator(), sizeof(VkDrawIndexedIndirectCommand) * buffer_slots)
+                .set_buffer_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                .build();
+        if (!output_buffer_result)
+        {
+            destroy();
+            return output_buffer_result;
+        }
+        culling_frame.output_buffer = output_buffer_result.value();
+
+        // Every batch holds at least one draw, hence batch and chunk counts together need at most two entries per slot
+        auto count_buffer_result = vulkan_utils::buffer_builder(engine.allocator(), sizeof(uint32_t) * buffer_slots * 2)
+                .set_buffer_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                .build();
+        if (!count_buffer_result)
+        {
+            destroy();
+            return count_buffer_result;
+        }
+        culling_frame.count_buffer = count_buffer_result.value();
+
+        VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptor_set_allocate_info.pNext = nullptr;
+        descriptor_set_allocate_info.descriptorPool = m_descriptor_pool;
+        descriptor_set_allocate_info.descriptorSetCount = 1;
+        descriptor_set_allocate_info.pSetLayouts = &m_descriptor_set_layout;
+        auto descriptor_sets_result = vkAllocateDescriptorSets(m_device, &descriptor_set_allocate_info, &culling_frame.descriptor_set);
+        if (descriptor_sets_result != VK_SUCCESS)
+        {
+            auto message = std::string("Failed to create descriptor set (").append(vulkan_utils::stringify::data(descriptor_sets_result)).append(").");
+            log::error("vengine::indirect_renderer::enable_culling(vengine&, VkShaderModule)", message);
+            destroy();
+            return { descriptor_sets_result, message };
+        }
+        // Frame buffers are only known once the frame comes around, see cull()
+        culling_frame.descriptor_set_written = false;
+    }
+    return {};
+}
+
+void vengine::indirect_renderer::destroy()
+{
+    for (auto& culling_frame : m_culling_frames)
+    {
+        if (culling_frame.cull_buffer.uploaded())
+        {
+            culling_frame.cull_buffer.destroy();
+        }
+        if (culling_frame.output_buffer.uploaded())
+        {
+            culling_frame.output_buffer.destroy();
+        }
+        if (culling_frame.count_buffer.uploaded())
+        {
+            culling_frame.count_buffer.destroy();
+        }
+    }
+    m_culling_frames.clear();
+    if (m_cull_pipeline)
+    {
+        vkDestroyPipeline(m_device, m_cull_pipeline, nullptr);
+        m_cull_pipeline = VK_NULL_HANDLE;
+    }
+    if (m_cull_pipeline_layout)
+    {
+        vkDestroyPipelineLayout(m_device, m_cull_pipeline_layout, nullptr);
+        m_cull_pipeline_layout = VK_NULL_HANDLE;
+    }
+    if (m_descriptor_set_layout)
+    {
+        vkDestroyDescriptorSetLayout(m_device, m_descriptor_set_layout, nullptr);
+        m_descriptor_set_layout = VK_NULL_HANDLE;
+    }
+    if (m_descriptor_pool)
+    {
+        // Frees the descriptor sets too
+        vkDestroyDescriptorPool(m_device, m_descriptor_pool, nullptr);
+        m_descriptor_pool = VK_NULL_HANDLE;
+    }
+}
+
+size_t vengine::indirect_renderer::build(entt::registry& registry, ::vengine::vengine::frame_data& frame)
+{
+    m_batches.clear();
+    m_draw_count = 0;
+    auto view = registry.view<const ecs::position, const ecs::rotation, const ecs::renderable>();
+
+    auto find_batch = [&](const ::vengine::mesh* mesh) {
+        return std::find_if(m_batches.begin(), m_batches.end(), [&](auto& b) {
+            return b.pool == mesh->geometry.pool && b.format == mesh->geometry.format && b.index_type == mesh->geometry.index_type;
+        });
+    };
+
+    // Count the entities per batch, so every batch gets a consecutive range of commands
+    for (auto entity : view)
+    {
+        auto& renderable = view.get<const ecs::renderable>(entity);
+        if (!renderable.mesh || !renderable.mesh->uploaded())
+        {
+            continue;
+        }
+        auto it = find_batch(renderable.mesh);
+        if (it == m_batches.end())
+        {
+            auto& geometry = renderable.mesh->geometry;
+            m_batches.push_back({ geometry.pool, geometry.format, geometry.index_type, 0, 1, 0 });
+        }
+        else
+        {
+            it->command_count++;
+        }
+    }
+
+    // Reserve the ranges, the chunk counts follow the per batch counts in the count buffer
+    std::vector<uint32_t> cursors;
+    cursors.reserve(m_batches.size());
+    m_count_entries = (uint32_t)m_batches.size();
+    for (auto& b : m_batches)
+    {
+        auto available = std::min(
+                frame.indirect_allocator.capacity() - frame.indirect_allocator.size(),
+                frame.mesh_allocator.capacity() - frame.mesh_allocator.size());
+        if (available < b.command_count)
+        {
+            log::warning("vengine::indirect_renderer::build(entt::registry&, frame_data&)", "Frame buffers exhausted, skipping draws.");
+            b.command_count = (uint32_t)available;
+        }
+        b.first_command = (uint32_t)frame.indirect_allocator.size();
+        if (b.command_count > 0)
+        {
+            (void)frame.indirect_allocator.allocate(b.command_count);
+        }
+        b.first_chunk_count = m_count_entries;
+        m_count_entries += chunk_count(b.command_count);
+        cursors.push_back(0);
+    }
+
+    // Write the mesh data, the commands and (if culling) the bounding spheres
+    auto commands = frame.indirect_buffer.mapped_as<VkDrawIndexedIndirectCommand>();
+    auto cull_data = culling_enabled() ? m_culling_frames[frame.index].cull_buffer.mapped_as<gpu_cull_data>() : nullptr;
+    for (auto [entity, pos, rot, renderable] : view.each())
+    {
+        if (!renderable.mesh || !renderable.mesh->uploaded())
+        {
+            continue;
+        }
+        auto index = (size_t)(find_batch(renderable.mesh) - m_batches.begin());
+        auto& b = m_batches[index];
+        if (cursors[index] == b.command_count)
+        {
+            continue;
+        }
+
+        auto scale = glm::scale(glm::mat4 { 1.0f }, renderable.scale);
+        auto rotate = glm::mat4_cast(rot.data);
+        auto translate = glm::translate(glm::mat4 { 1.0f }, pos.data);
+        auto render_index = frame.mesh_allocator.push({ translate * rotate * scale });
+        if (!render_index.has_value())
+        {
+            continue;
+        }
+
+        auto command_index = b.first_command + cursors[index]++;
+        auto& command = commands[command_index];
+        auto& geometry = renderable.mesh->geometry;
+        command.indexCount = geometry.index_count;
+        command.instanceCount = 1;
+        command.firstIndex = geometry.first_index;
+        command.vertexOffset = (int32_t)geometry.first_vertex;
+        command.firstInstance = render_index.value();
+        if (cull_data)
+        {
+            cull_data[command_index] = { renderable.mesh->bounding_sphere, (uint32_t)index, b.first_command, b.first_chunk_count, 0 };
+        }
+        m_draw_count++;
+    }
+
+    // Shrink batches to what actually got written
+    for (size_t i = 0; i < m_batches.size(); i++)
+    {
+        if (cull_data)
+        {
+            for (auto j = cursors[i]; j < m_batches[i].command_count; j++)
+            {
+                cull_data[m_batches[i].first_command + j].batch_index = invalid_batch_index;
+            }
+        }
+        m_batches[i].command_count = cursors[i];
+    }
+    return m_draw_count;
+}
+
+void vengine::indirect_renderer::cull(VkCommandBuffer command_buffer, ::vengine::vengine::frame_data& frame, const glm::mat4& view_projection)
+{
+    if (!culling_enabled() || m_batches.empty())
+    {
+        return;
+    }
+    auto& culling_frame = m_culling_frames[frame.index];
+    if (!culling_frame.descriptor_set_written)
+    {
+        auto update_descriptor_set_result = vulkan_utils::descriptor_set_updater(m_device)
+                .add_descriptor_set(culling_frame.descriptor_set, [&](auto& builder) {
+                    builder
+                            .add_descriptor_buffer_info(frame.mesh_buffer, 0)
+                            .set_binding_destination(0)
+                            .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+                })
+                .add_descriptor_set(culling_frame.descriptor_set, [&](auto& builder) {
+                    builder
+                            .add_descriptor_buffer_info(frame.indirect_buffer, 0)
+                            .set_binding_destination(1)
+                            .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+                })
+                .add_descriptor_set(culling_frame.descriptor_set, [&](auto& builder) {
+                    builder
+                            .add_descriptor_buffer_info(culling_frame.cull_buffer, 0)
+                            .set_binding_destination(2)
+                            .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+                })
+                .add_descriptor_set(culling_frame.descriptor_set, [&](auto& builder) {
+                    builder
+                            .add_descriptor_buffer_info(culling_frame.output_buffer, 0)
+                            .set_binding_destination(3)
+                            .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+                })
+                .add_descriptor_set(culling_frame.descriptor_set, [&](auto& builder) {
+                    builder
+                            .add_descriptor_buffer_info(culling_frame.count_buffer, 0)
+                            .set_binding_destination(4)
+                            .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+                })
+                .update();
+        if (!update_descriptor_set_result)
+        {
+            log::error("vengine::indirect_renderer::cull(VkCommandBuffer, frame_data&, const glm::mat4&)", "Failed to update descriptor set.");
+            return;
+        }
+        culling_frame.descriptor_set_written = true;
+    }
+
+    auto first_command = m_batches.front().first_command;
+    auto command_count = m_batches.back().first_command + m_batches.back().command_count - first_command;
+    culling_frame.cull_buffer.flush(first_command * sizeof(gpu_cull_data), command_count * sizeof(gpu_cull_data));
+
+    // Reset the per batch and per chunk draw counts
+    vkCmdFillBuffer(command_buffer, culling_frame.count_buffer.buffer, 0, m_count_entries * sizeof(uint32_t), 0);
+    {
+        VkMemoryBarrier memory_barrier = {};
+        memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.pNext = nullptr;
+        memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                1, &memory_barrier,
+                0, nullptr,
+                0, nullptr);
+    }
+
+    gpu_cull_constants constants = {};
+    auto planes = extract_frustum_planes(view_projection);
+    std::copy(planes.begin(), planes.end(), constants.frustum_planes);
+    constants.first_command = first_command;
+    constants.command_count = command_count;
+    constants.max_draw_count = m_max_draw_indirect_count;
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline_layout, 0, 1, &culling_frame.descriptor_set, 0, nullptr);
+    vkCmdPushConstants(command_buffer, m_cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(gpu_cull_constants), &constants);
+    vkCmdDispatch(command_buffer, (command_count + cull_group_size - 1) / cull_group_size, 1, 1);
+
+    // Make the compacted commands and counts visible to the indirect draws
+    {
+        VkMemoryBarrier memory_barrier = {};
+        memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.pNext = nullptr;
+        memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memory_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                0,
+                1, &memory_barrier,
+                0, nullptr,
+                0, nullptr);
+    }
+}
+
+void vengine::indirect_renderer::record(VkCommandBuffer command_buffer, const ::vengine::vengine::frame_data& frame, std::optional<vertex_format> format) const
+{
+    for (size_t i = 0; i < m_batches.size(); i++)
+    {
+        auto& b = m_batches[i];
+        if (b.command_count == 0 || (format.has_value() && b.format != format.value()))
+        {
+            continue;
+        }
+        b.pool->bind(command_buffer, b.format, b.index_type);
+
+        // Respect maxDrawIndirectCount by splitting into multiple calls
+        uint32_t recorded = 0;
+        uint32_t chunk = 0;
+        while (recorded < b.command_count)
+        {
+            auto count = std::min(b.command_count - recorded, m_max_draw_indirect_count);
+            if (culling_enabled())
+            {
+                // The GPU wrote the visible draws compacted to the start of the batch range, along with the count per chunk
+                vkCmdDrawIndexedIndirectCount(
+                        command_buffer,
+                        m_culling_frames[frame.index].output_buffer.buffer,
+                        (b.first_command + recorded) * sizeof(VkDrawIndexedIndirectCommand),
+                        m_culling_frames[frame.index].count_buffer.buffer,
+                        (b.first_chunk_count + chunk) * sizeof(uint32_t),
+                        count,
+                        sizeof(VkDrawIndexedIndirectCommand));
+            }
+            else
+            {
+                vkCmdDrawIndexedIndirect(
+                        command_buffer,
+                        frame.indirect_buffer.buffer,
+                        (b.first_command + recorded) * sizeof(VkDrawIndexedIndirectCommand),
+                        count,
+                        sizeof(VkDrawIndexedIndirectCommand));
+            }
+            recorded += count;
+            chunk++;
+        }
+    }
+}
@@ -0,0 +1,163 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_INDIRECT_RENDERER_HPP
+#define GAME_PROJ_INDIRECT_RENDERER_HPP
+
+#include "vengine.hpp"
+#include "mesh.hpp"
+#include "geometry_pool.hpp"
+#include "allocated_buffer.hpp"
+#include "vulkan-utils/result.hpp"
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace vengine
+{
+    /**
+     * Draws every ecs::renderable entity using indirect draw calls.
+     *
+     * build() writes one gpu_mesh_data and one VkDrawIndexedIndirectCommand per entity into the
+     * ring allocators of the frame, grouped by the geometry_pool buffers the meshes live in.
+     * record() then binds the buffers and issues one vkCmdDrawIndexedIndirect per group,
+     * hence the amount of recorded commands grows neither with the entity nor with the mesh count.
+     *
+     * If enable_culling() succeeded, cull() runs a compute pass testing the bounding sphere
+     * of every draw against the camera frustum and compacting the visible draws per mesh.
+     * record() then uses vkCmdDrawIndexedIndirectCount with the GPU written counts.
+     */
+    class indirect_renderer
+    {
+    public:
+        struct batch
+        {
+            // Every mesh of the batch shares these buffers
+            const geometry_pool* pool;
+            vertex_format format;
+            VkIndexType index_type;
+            // Index of the first VkDrawIndexedIndirectCommand inside of frame_data::indirect_buffer
+            uint32_t first_command;
+            uint32_t command_count;
+            // Index inside of the count buffer of the visible draws of the first chunk of maxDrawIndirectCount draws,
+            // further chunks follow (culling only)
+            uint32_t first_chunk_count;
+        };
+
+#pragma pack(push, 1)
+        // Layout must match workingdir/shaders/cull.comp (std430)
+        struct gpu_cull_data
+        {
+            // Model space bounding sphere of the mesh (xyz = center, w = radius)
+            glm::vec4 bounding_sphere;
+            uint32_t batch_index;
+            uint32_t batch_first_command;
+            uint32_t batch_first_chunk_count;
+            uint32_t padding;
+        };
+        struct gpu_cull_constants
+        {
+            // left, right, bottom, top, near, far (xyz = normal pointing inside, w = distance)
+            glm::vec4 frustum_planes[6];
+            uint32_t first_command;
+            uint32_t command_count;
+            // Draws per chunk, every chunk is drawn by its own vkCmdDrawIndexedIndirectCount
+            uint32_t max_draw_count;
+            uint32_t padding;
+        };
+#pragma pack(pop)
+    private:
+        struct culling_frame
+        {
+            // Persistently mapped, indexed like frame_data::indirect_buffer
+            allocated_buffer cull_buffer;
+            // Compacted commands, indexed like frame_data::indirect_buffer
+            allocated_buffer output_buffer;
+            // One uint32_t visible draw count per batch, followed by the counts per chunk (see batch::first_chunk_count)
+            allocated_buffer count_buffer;
+            VkDescriptorSet descriptor_set;
+            bool descriptor_set_written;
+        };
+
+        std::vector<batch> m_batches;
+        uint32_t m_max_draw_indirect_count;
+        size_t m_draw_count;
+        // Used entries of the count buffer
+        uint32_t m_count_entries;
+
+        VkDevice m_device;
+        VkDescriptorPool m_descriptor_pool;
+        VkDescriptorSetLayout m_descriptor_set_layout;
+        VkPipelineLayout m_cull_pipeline_layout;
+        VkPipeline m_cull_pipeline;
+        std::vector<culling_frame> m_culling_frames;
+
+        [[nodiscard]] bool culling_enabled() const { return m_cull_pipeline != VK_NULL_HANDLE; }
+        /**
+         * @returns The draw calls record() splits command_count commands into. maxDrawIndirectCount
+         *          commonly is UINT32_MAX, hence no rounding up via addition.
+         */
+        [[nodiscard]] uint32_t chunk_count(uint32_t command_count) const
+        {
+            return command_count / m_max_draw_indirect_count + (command_count % m_max_draw_indirect_count != 0 ? 1 : 0);
+        }
+    public:
+        explicit indirect_renderer(const ::vengine::vengine& engine)
+                : m_max_draw_indirect_count(engine.physical_device_properties().limits.maxDrawIndirectCount),
+                m_draw_count(0),
+                m_count_entries(0),
+                m_device(VK_NULL_HANDLE),
+                m_descriptor_pool(VK_NULL_HANDLE),
+                m_descriptor_set_layout(VK_NULL_HANDLE),
+                m_cull_pipeline_layout(VK_NULL_HANDLE),
+                m_cull_pipeline(VK_NULL_HANDLE)
+        {
+        }
+
+        /**
+         * Creates the GPU frustum culling pass.
+         * If this is never called (or fails), every draw is submitted without culling.
+         *
+         * @param cull_shader Shader module of cull.comp
+         */
+        vulkan_utils::result<void> enable_culling(::vengine::vengine& engine, VkShaderModule cull_shader);
+
+        /**
+         * Releases the resources created by enable_culling. The device must be idle.
+         */
+        void destroy();
+
+        /**
+         * Gathers all renderable entities of registry into the indirect and mesh buffers of frame.
+         * Must be called once per frame before cull() and record().
+         *
+         * @returns The amount of draws written. Entities not fitting into the frame buffers are skipped.
+         */
+        size_t build(entt::registry& registry, ::vengine::vengine::frame_data& frame);
+
+        /**
+         * Records the culling compute pass into command_buffer, which must be outside of the render pass.
+         * Does nothing if culling is not enabled.
+         *
+         * @param view_projection The matrix the draws get rendered with.
+         */
+        void cull(VkCommandBuffer command_buffer, ::vengine::vengine::frame_data& frame, const glm::mat4& view_projection);
+
+        /**
+         * Records the draws gathered by build(). Expects the pipeline and descriptor sets to be bound.
+         * May be called for several command buffers in parallel (see vengine::record_parallel).
+         *
+         * @param format If set, only meshes of this vertex format are drawn (pipelines are bound per vertex format).
+         */
+        void record(VkCommandBuffer command_buffer, const ::vengine::vengine::frame_data& frame, std::optional<vertex_format> format = { }) const;
+
+        [[nodiscard]] const std::vector<batch>& batches() const { return m_batches; }
+        [[nodiscard]] size_t draw_count() const { return m_draw_count; }
+    };
+}
+
+#endif //GAME_PROJ_INDIRECT_RENDERER_HPP
@@ -107,4 +107,24 @@ size_t vengine::io::bom_skip_length(const char* begin, const char* end)
     file.read(reinterpret_cast<char*>(data.data()), fileSize);
     file.close();
     return true;
-}
\ No newline at end of file
+}
+
+[[maybe_unused]] bool vengine::io::write_file_to_disk(const std::filesystem::path& path, std::span<const uint8_t> data)
+{
+    std::ofstream file(path, std::ios::trunc | std::ios::binary);
+
+    if (!file.is_open())
+    {
+        vengine::log::error("vengine::io::write_file_to_disk(const std::filesystem::path&, std::span<const uint8_t>)", "Failed to open file: " + path.string());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    file.close();
+    if (file.fail())
+    {
+        vengine::log::error("vengine::io::write_file_to_disk(const std::filesystem::path&, std::span<const uint8_t>)", "Failed to write file: " + path.string());
+        return false;
+    }
+    return true;
+}
@@ -8,6 +8,8 @@
 #include <array>
 #include <filesystem>
 #include <string_view>
+#include <span>
+#include <cstdint>
 namespace vengine::io
 {
     [[maybe_unused]] size_t bom_skip_length(const char* begin, const char* end);
@@ -16,6 +18,8 @@ namespace vengine::io
     [[maybe_unused]] inline size_t bom_skip_length(std::array<char, size> data) { return bom_skip_length(data.data(), size); }
 
     [[maybe_unused]] bool read_file_from_disk(const std::filesystem::path& path, std::vector<uint8_t>& in_data);
+    // Creates or truncates the file at path
+    [[maybe_unused]] bool write_file_to_disk(const std::filesystem::path& path, std::span<const uint8_t> data);
 }
 
 #endif //GAME_PROJ_IO_HPP
@@ -0,0 +1,83 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "ktx2.hpp"
+#include "image_utils.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+bool vengine::ktx2::is_supported_format(VkFormat format)
+{
+    return image_utils::bc_block_size(format) != 0
+           || format == VK_FORMAT_R8G8B8A8_UNORM
+           || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+bool vengine::ktx2::is_ktx2(std::span<const uint8_t> data)
+{
+    return data.size() >= sizeof(identifier) && std::memcmp(data.data(), identifier, sizeof(identifier)) == 0;
+}
+
+std::optional<vengine::ktx2::result> vengine::ktx2::parse(std::span<const uint8_t> data)
+{
+    const char* source = "vengine::ktx2::parse(std::span<const uint8_t>)";
+    if (!is_ktx2(data) || data.size() < sizeof(file_header))
+    {
+        log::warning(source, "Data is not a KTX2 file.");
+        return { };
+    }
+    file_header header;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    auto format = (VkFormat)header.vk_format;
+    if (!is_supported_format(format))
+    {
+        log::warning(source, "KTX2 file uses an unsupported format.");
+        return { };
+    }
+    if (header.supercompression_scheme != 0)
+    {
+        log::warning(source, "KTX2 file is supercompressed, which is not supported.");
+        return { };
+    }
+    if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 1
+        || header.layer_count > 1 || header.face_count != 1)
+    {
+        log::warning(source, "KTX2 file is not a plain 2D texture.");
+        return { };
+    }
+
+    auto level_count = std::max(header.level_count, 1u);
+    if (level_count > image_utils::mip_level_count(header.pixel_width, header.pixel_height)
+        || data.size() < sizeof(file_header) + (size_t)level_count * sizeof(file_level))
+    {
+        log::warning(source, "KTX2 file has a malformed level index.");
+        return { };
+    }
+
+    result result;
+    result.format = format;
+    result.generate_mip_levels = header.level_count == 0;
+    result.levels.reserve(level_count);
+    auto width = header.pixel_width;
+    auto height = header.pixel_height;
+    for (uint32_t i = 0; i < level_count; i++)
+    {
+        file_level file_level;
+        std::memcpy(&file_level, data.data() + sizeof(file_header) + i * sizeof(file_level), sizeof(file_level));
+        auto expected_length = image_utils::level_size(format, width, height);
+        if (file_level.byte_offset > data.size() || data.size() - file_level.byte_offset < file_level.byte_length
+            || file_level.byte_length < expected_length)
+        {
+            log::warning(source, "KTX2 file has a level outside of the file or smaller than its extent.");
+            return { };
+        }
+        result.levels.push_back({ data.subspan(file_level.byte_offset, expected_length), width, height });
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_KTX2_HPP
+#define GAME_PROJ_KTX2_HPP
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * Reader for KTX2 texture containers (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html).
+ *
+ * Only plain 2D textures without supercompression are supported, with one of the
+ * formats accepted by is_supported_format. Level data is referenced in place and
+ * already has the layout vkCmdCopyBufferToImage expects.
+ */
+namespace vengine::ktx2
+{
+    const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+#pragma pack(push, 1)
+    struct file_header
+    {
+        uint8_t identifier[12];
+        uint32_t vk_format;
+        uint32_t type_size;
+        uint32_t pixel_width;
+        uint32_t pixel_height;
+        uint32_t pixel_depth;
+        uint32_t layer_count;
+        uint32_t face_count;
+        // 0 asks the loader to generate the mip chain
+        uint32_t level_count;
+        uint32_t supercompression_scheme;
+        uint32_t dfd_byte_offset;
+        uint32_t dfd_byte_length;
+        uint32_t kvd_byte_offset;
+        uint32_t kvd_byte_length;
+        uint64_t sgd_byte_offset;
+        uint64_t sgd_byte_length;
+    };
+
+    // Follows the header, one per level with level 0 (the largest) first
+    struct file_level
+    {
+        uint64_t byte_offset;
+        uint64_t byte_length;
+        uint64_t uncompressed_byte_length;
+    };
+#pragma pack(pop)
+
+    struct level
+    {
+        std::span<const uint8_t> data;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    struct result
+    {
+        VkFormat format;
+        // At least one, level 0 first
+        std::vector<level> levels;
+        // Set if the file only holds level 0 and asks for the others to be generated
+        bool generate_mip_levels;
+    };
+
+    /**
+     * BC1, BC3, BC5 and BC7 in both their UNORM and SRGB variants (where available) and RGBA8.
+     */
+    [[nodiscard]] bool is_supported_format(VkFormat format);
+
+    /**
+     * Whether data starts with the KTX2 identifier.
+     */
+    [[nodiscard]] bool is_ktx2(std::span<const uint8_t> data);
+
+    /**
+     * @returns The levels referencing data or an empty optional if data is malformed or not supported.
+     */
+    [[nodiscard]] std::optional<result> parse(std::span<const uint8_t> data);
+}
+
+#endif //GAME_PROJ_KTX2_HPP
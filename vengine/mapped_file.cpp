@@ -0,0 +1,186 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "mapped_file.hpp"
+#include "log.hpp"
+
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+vengine::mapped_file::mapped_file()
+        : m_data(nullptr),
+        m_size(0)
+#ifdef _WIN32
+        , m_file_handle(nullptr),
+        m_mapping_handle(nullptr)
+#endif
+{
+}
+
+vengine::mapped_file::mapped_file(mapped_file&& other) noexcept
+        : mapped_file()
+{
+    *this = std::move(other);
+}
+
+vengine::mapped_file& vengine::mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+#ifdef _WIN32
+        std::swap(m_file_handle, other.m_file_handle);
+        std::swap(m_mapping_handle, other.m_mapping_handle);
+#endif
+    }
+    return *this;
+}
+
+vengine::mapped_file::~mapped_file()
+{
+    close();
+}
+
+void vengine::mapped_file::close()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping_handle)
+    {
+        CloseHandle(m_mapping_handle);
+    }
+    if (m_file_handle)
+    {
+        CloseHandle(m_file_handle);
+    }
+    m_file_handle = nullptr;
+    m_mapping_handle = nullptr;
+#else
+    if (m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void vengine::mapped_file::advise(access_pattern pattern) const
+{
+#ifdef _WIN32
+    (void)pattern;
+#else
+    if (!m_data)
+    {
+        return;
+    }
+    int advice;
+    switch (pattern)
+    {
+        case access_pattern::sequential: advice = MADV_SEQUENTIAL; break;
+        case access_pattern::random: advice = MADV_RANDOM; break;
+        case access_pattern::will_need: advice = MADV_WILLNEED; break;
+        default: advice = MADV_NORMAL; break;
+    }
+    madvise(const_cast<uint8_t*>(m_data), m_size, advice);
+#endif
+}
+
+std::optional<vengine::mapped_file> vengine::mapped_file::open(const std::filesystem::path& path)
+{
+    const char* source = "vengine::mapped_file::open(const std::filesystem::path&)";
+    mapped_file file;
+#ifdef _WIN32
+    auto file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        log::error(source, "Failed to open file: " + path.string());
+        return { };
+    }
+    file.m_file_handle = file_handle;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size))
+    {
+        log::error(source, "Failed to query file size: " + path.string());
+        return { };
+    }
+    if (file_size.QuadPart == 0)
+    {
+        return file;
+    }
+
+    auto mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle)
+    {
+        log::error(source, "Failed to create file mapping: " + path.string());
+        return { };
+    }
+    file.m_mapping_handle = mapping_handle;
+
+    auto view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        log::error(source, "Failed to map view of file: " + path.string());
+        return { };
+    }
+    file.m_data = static_cast<const uint8_t*>(view);
+    file.m_size = (size_t)file_size.QuadPart;
+#else
+    auto descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        log::error(source, "Failed to open file: " + path.string());
+        return { };
+    }
+
+    struct stat file_stat { };
+    if (fstat(descriptor, &file_stat) != 0)
+    {
+        ::close(descriptor);
+        log::error(source, "Failed to query file size: " + path.string());
+        return { };
+    }
+    if (!S_ISREG(file_stat.st_mode))
+    {
+        ::close(descriptor);
+        log::error(source, "Cannot map non-regular files: " + path.string());
+        return { };
+    }
+    if (file_stat.st_size == 0)
+    {
+        ::close(descriptor);
+        return file;
+    }
+
+    auto view = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps its own reference to the file
+    ::close(descriptor);
+    if (view == MAP_FAILED)
+    {
+        log::error(source, "Failed to map file: " + path.string());
+        return { };
+    }
+    file.m_data = static_cast<const uint8_t*>(view);
+    file.m_size = (size_t)file_stat.st_size;
+#endif
+    return file;
+}
@@ -0,0 +1,74 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_MAPPED_FILE_HPP
+#define GAME_PROJ_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace vengine
+{
+    /**
+     * Read-only memory mapping of a whole file.
+     *
+     * Pages are loaded by the OS on first access, hence opening is cheap regardless of
+     * the file size and data never gets copied into a heap buffer.
+     */
+    class mapped_file
+    {
+    public:
+        // Expected access of the mapped pages, forwarded to the OS as a paging hint
+        enum class access_pattern
+        {
+            normal,
+            // Read ahead aggressively and drop pages once passed, eg. for parsing
+            sequential,
+            // Disable read ahead
+            random,
+            // Start reading the whole file in the background right away
+            will_need,
+        };
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+#ifdef _WIN32
+        void* m_file_handle;
+        void* m_mapping_handle;
+#endif
+
+        void close();
+    public:
+        mapped_file();
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        mapped_file(mapped_file&& other) noexcept;
+        mapped_file& operator=(mapped_file&& other) noexcept;
+        ~mapped_file();
+
+        [[nodiscard]] const uint8_t* data() const { return m_data; }
+        [[nodiscard]] size_t size() const { return m_size; }
+        [[nodiscard]] const uint8_t* begin() const { return m_data; }
+        [[nodiscard]] const uint8_t* end() const { return m_data + m_size; }
+        [[nodiscard]] std::span<const uint8_t> span() const { return { m_data, m_size }; }
+
+        /**
+         * Hints the OS how the mapping is going to be read (madvise). Only a hint, hence failures are ignored.
+         * No-op on windows.
+         */
+        void advise(access_pattern pattern) const;
+
+        /**
+         * Maps the file at path. Empty files are mapped to an empty span.
+         *
+         * @returns The mapping or an empty optional if the file could not be opened or mapped.
+         */
+        [[nodiscard]] static std::optional<mapped_file> open(const std::filesystem::path& path);
+    };
+}
+
+#endif //GAME_PROJ_MAPPED_FILE_HPP
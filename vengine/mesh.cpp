@@ -3,149 +3,500 @@
 //
 
 #include "mesh.hpp"
+#include "baked_mesh.hpp"
+#include "io.hpp"
+#include "obj_parser.hpp"
 #include "log.hpp"
 #include "vulkan-utils/stringify.hpp"
-#include "vulkan-utils/buffer_builder.hpp"
 #include "vengine.hpp"
 
 
-#include <tiny_obj_loader.h>
 #include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
 
 
-std::optional<vengine::mesh> vengine::mesh::from_obj(const ram_file& obj_file, const ram_file& mtl_file)
+namespace
 {
-    // Move ram_files into string
-    std::string data(obj_file.begin(), obj_file.end());
-    std::string mtl_text(mtl_file.begin(), mtl_file.end());
+    // IEEE 754 binary16, round to nearest even
+    uint16_t float_to_half(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        if (((bits >> 23) & 0xFF) == 0xFF)
+        {
+            // Inf / NaN
+            return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+        }
+        if (exponent >= 0x1F)
+        {
+            // Overflow to inf
+            return (uint16_t)(sign | 0x7C00);
+        }
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+            {
+                // Underflow to zero
+                return (uint16_t)sign;
+            }
+            // Subnormal
+            mantissa |= 0x800000;
+            auto shift = (uint32_t)(14 - exponent);
+            auto half_mantissa = mantissa >> shift;
+            auto remainder = mantissa & ((1u << shift) - 1);
+            auto halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+            {
+                half_mantissa++;
+            }
+            return (uint16_t)(sign | half_mantissa);
+        }
+        auto half = (uint32_t)(sign | ((uint32_t)exponent << 10) | (mantissa >> 13));
+        auto remainder = mantissa & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        {
+            // May carry into the exponent, which is the correct result
+            half++;
+        }
+        return (uint16_t)half;
+    }
 
-    //load the OBJ file
-    tinyobj::ObjReader obj_reader;
-    tinyobj::ObjReaderConfig obj_reader_config;
+    int16_t float_to_snorm16(float value)
+    {
+        value = std::clamp(value, -1.0f, 1.0f);
+        return (int16_t)std::lround(value * 32767.0f);
+    }
 
-    if (!obj_reader.ParseFromString(data, mtl_text, obj_reader_config))
+    uint8_t float_to_unorm8(float value)
     {
-        std::string message("Failed to read in object: ");
-        message.append(obj_reader.Error());
-        log::error("vengine::mesh::from_obj(const ram_file&, const ram_file&)", message);
-        return {};
+        value = std::clamp(value, 0.0f, 1.0f);
+        return (uint8_t)std::lround(value * 255.0f);
     }
-    if (!obj_reader.Warning().empty())
+}
+
+namespace
+{
+    // Center of the bounding box, not minimal but cheap and stable
+    template<typename TPositionOf>
+    glm::vec4 bounding_sphere_of(size_t count, TPositionOf position_of)
     {
-        std::string message("Warning was reported when reading in obj file: ");
-        message.append(obj_reader.Warning());
-        log::warning("vengine::mesh::from_obj(const ram_file&, const ram_file&)", message);
+        if (count == 0)
+        {
+            return { };
+        }
+        glm::vec3 min = position_of(0);
+        glm::vec3 max = min;
+        for (size_t i = 1; i < count; i++)
+        {
+            min = glm::min(min, position_of(i));
+            max = glm::max(max, position_of(i));
+        }
+        auto center = (min + max) * 0.5f;
+        float radius_squared = 0.0f;
+        for (size_t i = 0; i < count; i++)
+        {
+            auto delta = position_of(i) - center;
+            radius_squared = std::max(radius_squared, glm::dot(delta, delta));
+        }
+        return glm::vec4(center, std::sqrt(radius_squared));
     }
 
-    auto shapes = obj_reader.GetShapes();
-    auto attrib = obj_reader.GetAttrib();
+    uint64_t align_section(uint64_t offset)
+    {
+        return (offset + vengine::baked_mesh::section_alignment - 1) & ~(vengine::baked_mesh::section_alignment - 1);
+    }
 
-    mesh out_mesh;
-    for (auto & shape : shapes) {
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++) {
-            auto num_face_vertices = shape.mesh.num_face_vertices[f];
+    // Size and write time stored in baked_mesh::file_header, false if source cannot be stat'ed
+    bool source_stamp(const std::filesystem::path& source, uint64_t& size, int64_t& write_time)
+    {
+        std::error_code error_code;
+        auto file_size = std::filesystem::file_size(source, error_code);
+        if (error_code)
+        {
+            return false;
+        }
+        auto file_write_time = std::filesystem::last_write_time(source, error_code);
+        if (error_code)
+        {
+            return false;
+        }
+        size = (uint64_t)file_size;
+        write_time = (int64_t)file_write_time.time_since_epoch().count();
+        return true;
+    }
 
-            for (size_t face_vertex_index = 0; face_vertex_index < num_face_vertices; face_vertex_index++) {
-                tinyobj::index_t indices = shape.mesh.indices[index_offset + face_vertex_index];
+    template<typename T>
+    bool indices_in_range(std::span<const uint8_t> index_data, uint32_t vertex_count)
+    {
+        auto indices = std::span<const T>(reinterpret_cast<const T*>(index_data.data()), index_data.size() / sizeof(T));
+        return std::all_of(indices.begin(), indices.end(), [vertex_count](T index) { return index < vertex_count; });
+    }
+}
+
+vengine::compact_vertex vengine::compact_vertex::from(const vertex& v)
+{
+    compact_vertex out { };
+    out.position[0] = float_to_half(v.position.x);
+    out.position[1] = float_to_half(v.position.y);
+    out.position[2] = float_to_half(v.position.z);
+    out.position[3] = float_to_half(1.0f);
 
-                // Positions
-                tinyobj::real_t vx = attrib.vertices[3 * indices.vertex_index + 0];
-                tinyobj::real_t vy = attrib.vertices[3 * indices.vertex_index + 1];
-                tinyobj::real_t vz = attrib.vertices[3 * indices.vertex_index + 2];
+    // Octahedral encoding: project onto the octahedron, fold the lower hemisphere
+    auto n = v.normal;
+    auto l1_norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    glm::vec2 encoded { 0.0f, 0.0f };
+    if (l1_norm > 0.0f)
+    {
+        encoded = glm::vec2(n.x, n.y) / l1_norm;
+        if (n.z < 0.0f)
+        {
+            encoded = glm::vec2(
+                    (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+                    (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+        }
+    }
+    out.normal[0] = float_to_snorm16(encoded.x);
+    out.normal[1] = float_to_snorm16(encoded.y);
 
-                // Normals
-                tinyobj::real_t nx = attrib.normals[3 * indices.normal_index + 0];
-                tinyobj::real_t ny = attrib.normals[3 * indices.normal_index + 1];
-                tinyobj::real_t nz = attrib.normals[3 * indices.normal_index + 2];
+    out.color[0] = float_to_unorm8(v.color.x);
+    out.color[1] = float_to_unorm8(v.color.y);
+    out.color[2] = float_to_unorm8(v.color.z);
+    out.color[3] = 255;
+    return out;
+}
 
-                vertex new_vert{ { vx, vy, vz },  {nx, ny, nz}, {}};
+std::optional<vengine::mesh> vengine::mesh::from_obj(const ram_file& obj_file, [[maybe_unused]] const ram_file& mtl_file, utils::worker_pool* workers)
+{
+    auto parsed = obj_parser::parse({ obj_file.data(), obj_file.size() }, workers);
+    if (!parsed.has_value())
+    {
+        log::error("vengine::mesh::from_obj(const ram_file&, const ram_file&, utils::worker_pool*)", "Failed to read in object.");
+        return {};
+    }
 
+    mesh out_mesh;
+    // Corners referencing the same position and normal share one vertex
+    std::unordered_map<uint64_t, uint32_t> unique_vertices;
+    unique_vertices.reserve(parsed->positions.size());
+    out_mesh.vertices.reserve(parsed->positions.size());
+    out_mesh.indices.reserve(parsed->corners.size());
+    for (auto& shape : parsed->shapes)
+    {
+        auto first_index = (uint32_t)out_mesh.indices.size();
+        for (size_t i = shape.first_triangle * 3; i < (shape.first_triangle + shape.triangle_count) * 3; i++)
+        {
+            auto& corner = parsed->corners[i];
+            auto key = (uint64_t)corner.position << 32 | corner.normal;
+            auto [it, inserted] = unique_vertices.try_emplace(key, (uint32_t)out_mesh.vertices.size());
+            if (inserted)
+            {
+                auto normal = corner.normal == obj_parser::missing_index ? glm::vec3 { } : parsed->normals[corner.normal];
                 // For debugging - Hardcode color to normal map
-                new_vert.color = new_vert.normal;
-
-                out_mesh.vertices.push_back(new_vert);
+                out_mesh.vertices.emplace_back(parsed->positions[corner.position], normal, normal);
             }
-            index_offset += num_face_vertices;
+            out_mesh.indices.push_back(it->second);
         }
+        out_mesh.submeshes.push_back({ first_index, (uint32_t)out_mesh.indices.size() - first_index, { } });
     }
+    log::info("vengine::mesh::from_obj(const ram_file&, const ram_file&, utils::worker_pool*)",
+              std::string("Deduplicated ").append(std::to_string(out_mesh.indices.size()))
+                      .append(" face vertices into ").append(std::to_string(out_mesh.vertices.size())).append(" vertices."));
 
     return out_mesh;
 }
 
-vengine::vulkan_utils::result<void> vengine::mesh::upload_to_cpu_writable_gpu_memory(VmaAllocator allocator)
+void vengine::mesh::compute_bounding_sphere()
 {
-    if (vertex_buffer.uploaded())
+    if (baked())
     {
-        log::warning("vengine::mesh::upload_to_cpu_writable_gpu_memory(VmaAllocator)", "Attempt was made to upload a mesh twice to the GPU.");
-        return { VK_SUCCESS, "Attempt was made to upload_to_cpu_writable_gpu_memory a mesh twice to the GPU." };
+        return;
     }
+    bounding_sphere = bounding_sphere_of(vertices.size(), [&](size_t i) { return vertices[i].position; });
+    for (auto& sub : submeshes)
+    {
+        sub.bounding_sphere = bounding_sphere_of(sub.index_count, [&](size_t i) { return vertices[indices[sub.first_index + i]].position; });
+    }
+}
 
-    auto buffer_builder_result = vulkan_utils::buffer_builder(allocator, size())
-            .set_buffer_usage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
-            .set_memory_usage(VMA_MEMORY_USAGE_CPU_TO_GPU)
-            .build();
-    if (!buffer_builder_result.good())
+std::vector<uint8_t> vengine::mesh::prepare_index_data()
+{
+    if (indices.empty())
     {
-        return buffer_builder_result;
+        indices.resize(vertices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            indices[i] = (uint32_t)i;
+        }
+    }
+    std::vector<uint8_t> data;
+    if (vertices.size() <= (size_t)UINT16_MAX + 1)
+    {
+        index_type = VK_INDEX_TYPE_UINT16;
+        data.resize(indices.size() * sizeof(uint16_t));
+        auto out = reinterpret_cast<uint16_t*>(data.data());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            out[i] = (uint16_t)indices[i];
+        }
     }
-    vertex_buffer = buffer_builder_result.value();
+    else
+    {
+        index_type = VK_INDEX_TYPE_UINT32;
+        data.resize(indices.size() * sizeof(uint32_t));
+        memcpy(data.data(), indices.data(), data.size());
+    }
+    return data;
+}
 
-    return vertex_buffer.with_mapped([&](auto& span) {
-        memcpy(span.data(), vertices.data(), vertices.size() * sizeof(vertex));
-    });
+std::vector<uint8_t> vengine::mesh::prepare_vertex_data() const
+{
+    std::vector<uint8_t> data(size());
+    if (format == vertex_format::compact)
+    {
+        auto out = reinterpret_cast<compact_vertex*>(data.data());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            out[i] = compact_vertex::from(vertices[i]);
+        }
+    }
+    else
+    {
+        memcpy(data.data(), vertices.data(), data.size());
+    }
+    return data;
 }
 
-vengine::vulkan_utils::result<void> vengine::mesh::upload_to_gpu_memory(::vengine::vengine& engine, VmaAllocator allocator)
+vengine::vulkan_utils::result<vengine::upload_manager::upload_token> vengine::mesh::upload_to_gpu_memory(::vengine::vengine& engine, VmaAllocator allocator)
 {
-    if (vertex_buffer.uploaded())
+    if (uploaded())
     {
         log::warning("vengine::mesh::upload_to_gpu_memory(vengine&, VmaAllocator)", "Attempt was made to upload a mesh twice to the GPU.");
-        return { VK_SUCCESS, "Attempt was made to upload a mesh twice to the GPU." };
+        return { upload_manager::upload_token { 0 } };
+    }
+    std::vector<uint8_t> vertex_storage;
+    std::vector<uint8_t> index_storage;
+    std::span<const uint8_t> vertex_data;
+    std::span<const uint8_t> index_data;
+    if (baked())
+    {
+        // Straight from the mapping, the pages are faulted in by the copy into staging memory
+        vertex_data = baked_vertex_data;
+        index_data = baked_index_data;
+    }
+    else
+    {
+        compute_bounding_sphere();
+        vertex_storage = prepare_vertex_data();
+        index_storage = prepare_index_data();
+        vertex_data = vertex_storage;
+        index_data = index_storage;
     }
 
-    auto cpu_writeable_buffer_builder_result = vulkan_utils::buffer_builder(allocator, size())
-            .set_buffer_usage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
-            .set_memory_usage(VMA_MEMORY_USAGE_CPU_TO_GPU)
-            .build();
-    if (!cpu_writeable_buffer_builder_result.good())
+    auto geometry_result = engine.geometry().allocate(format, (uint32_t)vertex_count(), index_type, (uint32_t)index_count());
+    if (!geometry_result.good())
     {
-        return cpu_writeable_buffer_builder_result;
+        return { geometry_result.vk_result(), std::string(geometry_result.message()) };
     }
-    auto tmp = cpu_writeable_buffer_builder_result.value();
+    geometry = geometry_result.value();
 
-    tmp.with_mapped([&](auto& span) {
-        memcpy(span.data(), vertices.data(), vertices.size() * sizeof(vertex));
-    });
+    // Both copies are batched with every other upload issued before the next flush
+    auto vertex_upload_result = engine.uploads().upload_buffer(
+            vertex_data,
+            engine.geometry().vertex_buffer(format),
+            geometry.first_vertex * vertex_stride(),
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    if (!vertex_upload_result.good())
+    {
+        destroy();
+        return vertex_upload_result;
+    }
+    // Batches land in order, the token of the later upload covers both
+    auto index_upload_result = engine.uploads().upload_buffer(
+            index_data,
+            engine.geometry().index_buffer(index_type),
+            geometry.first_index * index_stride(),
+            VK_ACCESS_INDEX_READ_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    if (!index_upload_result.good())
+    {
+        // The vertex copy may already be recorded, the range has to outlive it
+        engine.uploads().wait(vertex_upload_result.value());
+        destroy();
+        return index_upload_result;
+    }
+    return index_upload_result;
+}
 
+void vengine::mesh::destroy()
+{
+    if (geometry.pool)
+    {
+        geometry.pool->free(geometry);
+    }
+    geometry = { };
+}
 
-    auto gpu_buffer_builder_result = vulkan_utils::buffer_builder(allocator, size())
-            .set_buffer_usage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-            .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
-            .build();
-    if (!gpu_buffer_builder_result.good())
+bool vengine::mesh::bake(const std::filesystem::path& path, const std::filesystem::path& source_path)
+{
+    const char* source = "vengine::mesh::bake(const std::filesystem::path&, const std::filesystem::path&)";
+    if (baked())
     {
-        tmp.destroy();
-        return gpu_buffer_builder_result;
+        log::error(source, "Attempt was made to bake an already baked mesh, copy the file instead.");
+        return false;
     }
-    vertex_buffer = gpu_buffer_builder_result.value();
+    compute_bounding_sphere();
+    auto vertex_data = prepare_vertex_data();
+    auto index_data = prepare_index_data();
 
-    auto execute_result = engine.execute([&](auto& command_buffer) {
-        VkBufferCopy buffer_copy{};
-        buffer_copy.size = size();
-        vkCmdCopyBuffer(command_buffer, tmp.buffer, vertex_buffer.buffer, 1, &buffer_copy);
-    });
-    if (!execute_result.good())
+    baked_mesh::file_header header { };
+    memcpy(header.magic, baked_mesh::magic, sizeof(header.magic));
+    header.version = baked_mesh::version;
+    header.vertex_format = (uint32_t)format;
+    header.index_type = (uint32_t)(index_type == VK_INDEX_TYPE_UINT16 ? baked_mesh::index_type::uint16 : baked_mesh::index_type::uint32);
+    header.vertex_count = (uint32_t)vertices.size();
+    header.vertex_stride = (uint32_t)vertex_stride();
+    header.index_count = (uint32_t)indices.size();
+    header.submesh_count = (uint32_t)submeshes.size();
+    memcpy(header.bounding_sphere, &bounding_sphere, sizeof(header.bounding_sphere));
+    header.vertex_data_offset = align_section(sizeof(baked_mesh::file_header));
+    header.index_data_offset = align_section(header.vertex_data_offset + vertex_data.size());
+    header.submesh_data_offset = align_section(header.index_data_offset + index_data.size());
+    if (!source_path.empty())
     {
-        tmp.destroy();
-        vertex_buffer.destroy();
-        return execute_result;
+        // Packed members cannot be bound to references
+        uint64_t source_size;
+        int64_t source_write_time;
+        if (!source_stamp(source_path, source_size, source_write_time))
+        {
+            log::error(source, "Failed to read size and write time of the source file: " + source_path.string());
+            return false;
+        }
+        header.source_size = source_size;
+        header.source_write_time = source_write_time;
     }
-    tmp.destroy();
-    return {};
+
+    std::vector<uint8_t> file(header.submesh_data_offset + submeshes.size() * sizeof(baked_mesh::file_submesh));
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(file.data() + header.vertex_data_offset, vertex_data.data(), vertex_data.size());
+    memcpy(file.data() + header.index_data_offset, index_data.data(), index_data.size());
+    for (size_t i = 0; i < submeshes.size(); i++)
+    {
+        baked_mesh::file_submesh record { };
+        record.first_index = submeshes[i].first_index;
+        record.index_count = submeshes[i].index_count;
+        memcpy(record.bounding_sphere, &submeshes[i].bounding_sphere, sizeof(record.bounding_sphere));
+        memcpy(file.data() + header.submesh_data_offset + i * sizeof(record), &record, sizeof(record));
+    }
+    return io::write_file_to_disk(path, file);
 }
 
-void vengine::mesh::destroy()
+std::optional<vengine::mesh> vengine::mesh::from_baked(const std::filesystem::path& path, const std::filesystem::path& source_path)
 {
-    vertex_buffer.destroy();
+    const char* source = "vengine::mesh::from_baked(const std::filesystem::path&, const std::filesystem::path&)";
+    auto mapped_file_opt = mapped_file::open(path);
+    if (!mapped_file_opt.has_value())
+    {
+        return {};
+    }
+    auto file = std::make_shared<const mapped_file>(std::move(mapped_file_opt.value()));
+
+    baked_mesh::file_header header { };
+    if (file->size() < sizeof(header))
+    {
+        log::error(source, "File is too small to be a baked mesh: " + path.string());
+        return {};
+    }
+    memcpy(&header, file->data(), sizeof(header));
+    if (memcmp(header.magic, baked_mesh::magic, sizeof(header.magic)) != 0)
+    {
+        log::error(source, "File is not a baked mesh: " + path.string());
+        return {};
+    }
+    if (header.version != baked_mesh::version)
+    {
+        log::error(source, std::string("Baked mesh version ").append(std::to_string(header.version))
+                .append(" is not supported (expected ").append(std::to_string(baked_mesh::version)).append("), rebake: ").append(path.string()));
+        return {};
+    }
+    if (header.vertex_format > (uint32_t)vertex_format::compact
+        || header.index_type > (uint32_t)baked_mesh::index_type::uint32)
+    {
+        log::error(source, "Baked mesh has an unknown vertex format or index type: " + path.string());
+        return {};
+    }
+    // A missing source is fine, the baked file may be shipped on its own
+    uint64_t source_size;
+    int64_t source_write_time;
+    if (!source_path.empty()
+        && source_stamp(source_path, source_size, source_write_time)
+        && (source_size != header.source_size || source_write_time != header.source_write_time))
+    {
+        log::info(source, "Baked mesh is out of date with " + source_path.string() + ", rebake: " + path.string());
+        return {};
+    }
+
+    mesh out_mesh;
+    out_mesh.format = (vertex_format)header.vertex_format;
+    out_mesh.index_type = header.index_type == (uint32_t)baked_mesh::index_type::uint16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    if (header.vertex_stride != out_mesh.vertex_stride())
+    {
+        log::error(source, "Baked mesh vertex stride does not match its vertex format: " + path.string());
+        return {};
+    }
+
+    // 64 bit math, the counts are 32 bit hence none of the products can overflow
+    auto vertex_data_size = (uint64_t)header.vertex_count * header.vertex_stride;
+    auto index_data_size = (uint64_t)header.index_count * out_mesh.index_stride();
+    auto submesh_data_size = (uint64_t)header.submesh_count * sizeof(baked_mesh::file_submesh);
+    auto fits = [&](uint64_t offset, uint64_t size) { return offset <= file->size() && size <= file->size() - offset; };
+    if (header.vertex_data_offset % baked_mesh::section_alignment != 0
+        || header.index_data_offset % baked_mesh::section_alignment != 0)
+    {
+        log::error(source, "Baked mesh sections are misaligned: " + path.string());
+        return {};
+    }
+    if (!fits(header.vertex_data_offset, vertex_data_size)
+        || !fits(header.index_data_offset, index_data_size)
+        || !fits(header.submesh_data_offset, submesh_data_size))
+    {
+        log::error(source, "Baked mesh is truncated: " + path.string());
+        return {};
+    }
+
+    memcpy(&out_mesh.bounding_sphere, header.bounding_sphere, sizeof(header.bounding_sphere));
+    out_mesh.submeshes.reserve(header.submesh_count);
+    for (uint32_t i = 0; i < header.submesh_count; i++)
+    {
+        baked_mesh::file_submesh record { };
+        memcpy(&record, file->data() + header.submesh_data_offset + i * sizeof(record), sizeof(record));
+        if ((uint64_t)record.first_index + record.index_count > header.index_count)
+        {
+            log::error(source, "Baked mesh submesh exceeds the index stream: " + path.string());
+            return {};
+        }
+        submesh sub { record.first_index, record.index_count, { } };
+        memcpy(&sub.bounding_sphere, record.bounding_sphere, sizeof(record.bounding_sphere));
+        out_mesh.submeshes.push_back(sub);
+    }
+    out_mesh.baked_vertex_data = file->span().subspan(header.vertex_data_offset, vertex_data_size);
+    out_mesh.baked_index_data = file->span().subspan(header.index_data_offset, index_data_size);
+    // Out of range indices would fetch vertices out of bounds on the GPU
+    if (out_mesh.index_type == VK_INDEX_TYPE_UINT16
+        ? !indices_in_range<uint16_t>(out_mesh.baked_index_data, header.vertex_count)
+        : !indices_in_range<uint32_t>(out_mesh.baked_index_data, header.vertex_count))
+    {
+        log::error(source, "Baked mesh index exceeds the vertex stream: " + path.string());
+        return {};
+    }
+    out_mesh.baked_file = std::move(file);
+    return out_mesh;
 }
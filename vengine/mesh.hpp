@@ -8,11 +8,17 @@
 #include "vulkan-utils/result.hpp"
 #include "allocated_buffer.hpp"
 #include "ram_file.hpp"
+#include "upload_manager.hpp"
+#include "mapped_file.hpp"
+#include "worker_pool.hpp"
 
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <vector>
+#include <memory>
+#include <span>
+#include <filesystem>
 #include "vk_mem_alloc.h"
 
 namespace vengine
@@ -72,8 +78,85 @@ namespace vengine
             return description;
         }
     };
+
+    /**
+     * Compact vertex layout, 16 bytes instead of the 36 of vertex.
+     *
+     * position: half floats (w unused), read as a vec3 like vertex::position.
+     * normal: octahedral encoded snorm16, read as a vec2. Shaders using it have to decode it:
+     *     vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+     *     if (n.z < 0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+     *     n = normalize(n);
+     * color: unorm8 (a unused), components outside of [0, 1] are clamped.
+     */
+    struct compact_vertex
+    {
+        uint16_t position[4];
+        int16_t normal[2];
+        uint8_t color[4];
+
+        [[nodiscard]] static compact_vertex from(const vertex& v);
+
+        static vertex_input_description get_vertex_input_description()
+        {
+            vertex_input_description description;
+
+            VkVertexInputBindingDescription mainBinding = {};
+            mainBinding.binding = 0;
+            mainBinding.stride = sizeof(compact_vertex);
+            mainBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            description.binding_descriptions.push_back(mainBinding);
+
+            VkVertexInputAttributeDescription position_input_attribute_description = {};
+            position_input_attribute_description.binding = 0;
+            position_input_attribute_description.location = 0;
+            position_input_attribute_description.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+            position_input_attribute_description.offset = offsetof(compact_vertex, position);
+            description.attribute_descriptions.push_back(position_input_attribute_description);
+
+            VkVertexInputAttributeDescription normal_input_attribute_description = {};
+            normal_input_attribute_description.binding = 0;
+            normal_input_attribute_description.location = 1;
+            normal_input_attribute_description.format = VK_FORMAT_R16G16_SNORM;
+            normal_input_attribute_description.offset = offsetof(compact_vertex, normal);
+            description.attribute_descriptions.push_back(normal_input_attribute_description);
+
+            VkVertexInputAttributeDescription color_input_attribute_description = {};
+            color_input_attribute_description.binding = 0;
+            color_input_attribute_description.location = 2;
+            color_input_attribute_description.format = VK_FORMAT_R8G8B8A8_UNORM;
+            color_input_attribute_description.offset = offsetof(compact_vertex, color);
+
+            description.attribute_descriptions.push_back(color_input_attribute_description);
+            return description;
+        }
+    };
 #pragma pack(pop)
 
+    enum class vertex_format
+    {
+        // vertex
+        standard,
+        // compact_vertex
+        compact,
+    };
+
+    class geometry_pool;
+    // Range of a mesh inside of the buffers of a geometry_pool
+    struct geometry_range
+    {
+        geometry_pool* pool;
+        vertex_format format;
+        VkIndexType index_type;
+        // In vertices, to be used as vertexOffset
+        uint32_t first_vertex;
+        uint32_t vertex_count;
+        // In indices, to be used as firstIndex
+        uint32_t first_index;
+        uint32_t index_count;
+    };
+
     struct mesh {
 #pragma pack(push, 1)
         struct push_constant
@@ -82,20 +165,92 @@ namespace vengine
             glm::mat4 matrix;
         };
 #pragma pack(pop)
+        // Contiguous range of indices, eg. one per shape of an OBJ file
+        struct submesh
+        {
+            uint32_t first_index;
+            uint32_t index_count;
+            // Model space, see compute_bounding_sphere
+            glm::vec4 bounding_sphere;
+        };
         std::vector<vertex> vertices;
+        // Triangle list indexing vertices. If empty when uploading, sequential indices are generated.
+        std::vector<uint32_t> indices;
+        // Partition of indices, may be empty
+        std::vector<submesh> submeshes;
+
+        // Set by from_baked. Vertices and indices stay inside of the mapped file, already in the layout
+        // given by format and index_type, and are copied into staging memory as is when uploading.
+        std::shared_ptr<const mapped_file> baked_file;
+        std::span<const uint8_t> baked_vertex_data;
+        std::span<const uint8_t> baked_index_data;
 
-        allocated_buffer vertex_buffer;
+        // Set when uploading, the vertices and indices live inside of the shared buffers of the engine geometry_pool
+        geometry_range geometry{};
+        // Picked when uploading, VK_INDEX_TYPE_UINT16 if all vertices can be addressed with it
+        VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+        // Layout of the uploaded vertices, vertices are converted when uploading
+        vertex_format format = vertex_format::standard;
+        // Model space bounding sphere (xyz = center, w = radius), see compute_bounding_sphere
+        glm::vec4 bounding_sphere{};
 
         mesh() = default;
         mesh(std::initializer_list<vertex> vertexes) : vertices(vertexes.begin(), vertexes.end()) {}
 
 
-        [[nodiscard]] vulkan_utils::result<void> upload_to_cpu_writable_gpu_memory(VmaAllocator allocator);
-        [[nodiscard]] vulkan_utils::result<void> upload_to_gpu_memory(::vengine::vengine& engine, VmaAllocator allocator);
-        [[nodiscard]] bool uploaded() const { return vertex_buffer.uploaded(); }
+        /**
+         * Allocates the mesh inside of engine.geometry() and queues the copies on engine.uploads().
+         * The mesh may be drawn once the returned token completed.
+         */
+        [[nodiscard]] vulkan_utils::result<upload_manager::upload_token> upload_to_gpu_memory(::vengine::vengine& engine, VmaAllocator allocator);
+        [[nodiscard]] bool uploaded() const { return geometry.pool != nullptr; }
+        [[nodiscard]] bool baked() const { return baked_file != nullptr; }
+        /**
+         * Updates bounding_sphere and the bounding spheres of submeshes from vertices.
+         * Called when uploading and baking, baked meshes keep the bounds stored in their file.
+         */
+        void compute_bounding_sphere();
+        /**
+         * Returns the range of the mesh to the geometry_pool. The GPU must be done with it.
+         */
         void destroy();
-        [[nodiscard]] static std::optional<mesh> from_obj(const ram_file& obj_file, const ram_file& mtl_file);
-        [[nodiscard]] size_t size() const { return vertices.size() * sizeof(vertex); }
+        /**
+         * Parses an OBJ file (see obj_parser), one submesh is created per shape.
+         * Materials are not supported yet, mtl_file is ignored.
+         *
+         * @param workers If not null, large files are parsed in parallel on it.
+         */
+        [[nodiscard]] static std::optional<mesh> from_obj(const ram_file& obj_file, const ram_file& mtl_file, utils::worker_pool* workers = nullptr);
+        /**
+         * Maps a file written by bake. Nothing is parsed besides the header, the submesh table and the
+         * index stream, which is validated. Vertices and indices are left empty and the streams are read
+         * from the mapping when uploading.
+         *
+         * @param source If given and existing, the file is rejected unless it was baked from source at its current size and write time.
+         */
+        [[nodiscard]] static std::optional<mesh> from_baked(const std::filesystem::path& path, const std::filesystem::path& source = {});
+        /**
+         * Writes the mesh in the baked format (see baked_mesh.hpp) in its current format,
+         * generating indices and picking index_type like uploading does.
+         *
+         * @param source File the mesh was loaded from, its size and write time are stored for from_baked.
+         */
+        [[nodiscard]] bool bake(const std::filesystem::path& path, const std::filesystem::path& source = {});
+        [[nodiscard]] size_t vertex_stride() const { return format == vertex_format::compact ? sizeof(compact_vertex) : sizeof(vertex); }
+        [[nodiscard]] size_t index_stride() const { return index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+        [[nodiscard]] size_t vertex_count() const { return baked() ? baked_vertex_data.size() / vertex_stride() : vertices.size(); }
+        [[nodiscard]] size_t size() const { return vertex_count() * vertex_stride(); }
+        [[nodiscard]] size_t index_count() const { return baked() ? baked_index_data.size() / index_stride() : indices.size(); }
+        [[nodiscard]] size_t index_size() const { return index_count() * index_stride(); }
+        [[nodiscard]] static vertex_input_description get_vertex_input_description(vertex_format format)
+        {
+            return format == vertex_format::compact ? compact_vertex::get_vertex_input_description() : vertex::get_vertex_input_description();
+        }
+    private:
+        // Generates missing indices, picks index_type and returns the indices in that format
+        [[nodiscard]] std::vector<uint8_t> prepare_index_data();
+        // Returns the vertices in the layout of format
+        [[nodiscard]] std::vector<uint8_t> prepare_vertex_data() const;
     };
 }
 
@@ -0,0 +1,418 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "mesh_optimizer.hpp"
+#include "log.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <cstdio>
+
+namespace
+{
+    const uint32_t invalid_index = UINT32_MAX;
+
+    // Tuning values from the Forsyth paper
+    const size_t forsyth_cache_size = 32;
+    const float forsyth_cache_decay_power = 1.5f;
+    const float forsyth_last_triangle_score = 0.75f;
+    const float forsyth_valence_boost_scale = 2.0f;
+    const float forsyth_valence_boost_power = 0.5f;
+
+    // Cache size used to find the cluster boundaries of the overdraw pass
+    const size_t overdraw_cache_size = 16;
+
+    float forsyth_vertex_score(int cache_position, uint32_t remaining_triangles)
+    {
+        if (remaining_triangles == 0)
+        {
+            // No triangle needs this vertex anymore
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cache_position >= 0)
+        {
+            if (cache_position < 3)
+            {
+                // Used by the last triangle, fixed score to not favour any of its edges
+                score = forsyth_last_triangle_score;
+            }
+            else
+            {
+                auto scaler = 1.0f / (float)(forsyth_cache_size - 3);
+                score = std::pow(1.0f - (float)(cache_position - 3) * scaler, forsyth_cache_decay_power);
+            }
+        }
+        // Boost vertices with few triangles left, to get rid of lone triangles
+        score += forsyth_valence_boost_scale * std::pow((float)remaining_triangles, -forsyth_valence_boost_power);
+        return score;
+    }
+
+    struct adjacency
+    {
+        // Triangles using vertex v are triangles[offsets[v]] to triangles[offsets[v] + counts[v]]
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> triangles;
+
+        adjacency(std::span<const uint32_t> indices, size_t vertex_count)
+                : offsets(vertex_count, 0), counts(vertex_count, 0), triangles(indices.size())
+        {
+            for (auto index : indices)
+            {
+                counts[index]++;
+            }
+            uint32_t offset = 0;
+            for (size_t v = 0; v < vertex_count; v++)
+            {
+                offsets[v] = offset;
+                offset += counts[v];
+            }
+            std::vector<uint32_t> fill(vertex_count, 0);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                auto v = indices[i];
+                triangles[offsets[v] + fill[v]++] = (uint32_t)(i / 3);
+            }
+        }
+    };
+
+    glm::vec3 triangle_normal(const std::span<const vengine::vertex>& vertices, const uint32_t* triangle)
+    {
+        auto& a = vertices[triangle[0]].position;
+        auto& b = vertices[triangle[1]].position;
+        auto& c = vertices[triangle[2]].position;
+        // Not normalized, length is twice the area
+        return glm::cross(b - a, c - a);
+    }
+}
+
+vengine::mesh_optimizer::statistics vengine::mesh_optimizer::analyze_vertex_cache(
+        std::span<const uint32_t> indices,
+        size_t vertex_count,
+        size_t cache_size)
+{
+    if (indices.empty() || vertex_count == 0)
+    {
+        return { 0.0f, 0.0f };
+    }
+    // A vertex is cached if less than cache_size misses happened since it got loaded
+    std::vector<size_t> load_time(vertex_count, 0);
+    size_t misses = 0;
+    for (auto index : indices)
+    {
+        if (load_time[index] == 0 || misses + 1 - load_time[index] > cache_size)
+        {
+            misses++;
+            load_time[index] = misses;
+        }
+    }
+    return {
+            (float)misses / (float)(indices.size() / 3),
+            (float)misses / (float)vertex_count
+    };
+}
+
+void vengine::mesh_optimizer::optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count)
+{
+    auto triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+    adjacency adj(indices, vertex_count);
+
+    std::vector<int> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        vertex_scores[v] = forsyth_vertex_score(-1, adj.counts[v]);
+    }
+    std::vector<float> triangle_scores(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        triangle_scores[t] = vertex_scores[indices[t * 3 + 0]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+    }
+    std::vector<bool> emitted(triangle_count, false);
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(forsyth_cache_size + 3);
+    next_cache.reserve(forsyth_cache_size + 3);
+
+    size_t scan_cursor = 0;
+    auto best_triangle = (uint32_t)invalid_index;
+    for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+    {
+        if (best_triangle == invalid_index)
+        {
+            // Dead end, no cached vertex has triangles left. Continue with the next one in input order,
+            // searching for the best scoring one instead would be quadratic on meshes with many parts.
+            while (emitted[scan_cursor])
+            {
+                scan_cursor++;
+            }
+            best_triangle = (uint32_t)scan_cursor;
+        }
+
+        auto triangle = &indices[best_triangle * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best_triangle] = true;
+
+        // Remove the triangle from the adjacency of its vertices
+        for (size_t i = 0; i < 3; i++)
+        {
+            auto v = triangle[i];
+            auto begin = adj.triangles.begin() + adj.offsets[v];
+            auto end = begin + adj.counts[v];
+            auto it = std::find(begin, end, best_triangle);
+            std::iter_swap(it, end - 1);
+            adj.counts[v]--;
+        }
+
+        // Move the triangle vertices to the front of the cache
+        next_cache.clear();
+        next_cache.insert(next_cache.end(), triangle, triangle + 3);
+        for (auto v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                next_cache.push_back(v);
+            }
+        }
+
+        // Update the scores of all vertices that were or are cached
+        for (size_t i = 0; i < next_cache.size(); i++)
+        {
+            auto v = next_cache[i];
+            cache_positions[v] = i < forsyth_cache_size ? (int)i : -1;
+            vertex_scores[v] = forsyth_vertex_score(cache_positions[v], adj.counts[v]);
+        }
+
+        // Update the triangles of those vertices and pick the next best triangle among them
+        best_triangle = invalid_index;
+        float best_score = -1.0f;
+        for (auto v : next_cache)
+        {
+            for (uint32_t i = 0; i < adj.counts[v]; i++)
+            {
+                auto t = adj.triangles[adj.offsets[v] + i];
+                auto score = vertex_scores[indices[t * 3 + 0]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+                triangle_scores[t] = score;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best_triangle = t;
+                }
+            }
+        }
+
+        if (next_cache.size() > forsyth_cache_size)
+        {
+            next_cache.resize(forsyth_cache_size);
+        }
+        std::swap(cache, next_cache);
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void vengine::mesh_optimizer::optimize_overdraw(std::span<uint32_t> indices, std::span<const vertex> vertices, float threshold)
+{
+    auto triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    // Hard boundaries: triangles where all three vertices miss the cache (start of a new strip)
+    std::vector<size_t> clusters;
+    {
+        std::vector<size_t> load_time(vertices.size(), 0);
+        size_t misses = 0;
+        for (size_t t = 0; t < triangle_count; t++)
+        {
+            size_t triangle_misses = 0;
+            for (size_t i = 0; i < 3; i++)
+            {
+                auto index = indices[t * 3 + i];
+                if (load_time[index] == 0 || misses + 1 - load_time[index] > overdraw_cache_size)
+                {
+                    misses++;
+                    triangle_misses++;
+                    load_time[index] = misses;
+                }
+            }
+            if (t == 0 || triangle_misses == 3)
+            {
+                clusters.push_back(t);
+            }
+        }
+    }
+
+    // Soft boundaries: split clusters further wherever the ACMR stays below threshold
+    std::vector<size_t> split_clusters;
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        auto begin = clusters[c];
+        auto end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+        auto cluster_indices = indices.subspan(begin * 3, (end - begin) * 3);
+        auto cluster_acmr = analyze_vertex_cache(cluster_indices, vertices.size(), overdraw_cache_size).acmr;
+
+        split_clusters.push_back(begin);
+        std::vector<size_t> load_time(vertices.size(), 0);
+        size_t misses = 0;
+        size_t split_start = begin;
+        size_t split_misses = 0;
+        for (auto t = begin; t < end; t++)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                auto index = indices[t * 3 + i];
+                if (load_time[index] == 0 || misses + 1 - load_time[index] > overdraw_cache_size)
+                {
+                    misses++;
+                    split_misses++;
+                    load_time[index] = misses;
+                }
+            }
+            auto split_triangles = t + 1 - split_start;
+            if (t + 1 < end && (float)split_misses / (float)split_triangles <= cluster_acmr * threshold)
+            {
+                split_clusters.push_back(t + 1);
+                split_start = t + 1;
+                split_misses = 0;
+                // Clusters may end up anywhere after sorting, hence every cluster starts with a cold cache
+                misses += overdraw_cache_size;
+            }
+        }
+    }
+
+    // Sort the clusters so that the ones pointing away from the mesh center come first
+    glm::vec3 mesh_centroid { 0.0f };
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        auto triangle = &indices[t * 3];
+        mesh_centroid += (vertices[triangle[0]].position + vertices[triangle[1]].position + vertices[triangle[2]].position) / 3.0f;
+    }
+    mesh_centroid /= (float)triangle_count;
+
+    struct cluster_sort
+    {
+        size_t begin;
+        size_t end;
+        float key;
+    };
+    std::vector<cluster_sort> sorted;
+    sorted.reserve(split_clusters.size());
+    for (size_t c = 0; c < split_clusters.size(); c++)
+    {
+        auto begin = split_clusters[c];
+        auto end = c + 1 < split_clusters.size() ? split_clusters[c + 1] : triangle_count;
+        glm::vec3 centroid { 0.0f };
+        glm::vec3 normal { 0.0f };
+        float area = 0.0f;
+        for (auto t = begin; t < end; t++)
+        {
+            auto triangle = &indices[t * 3];
+            auto triangle_normal_area = triangle_normal(vertices, triangle);
+            auto triangle_area = glm::length(triangle_normal_area);
+            centroid += (vertices[triangle[0]].position + vertices[triangle[1]].position + vertices[triangle[2]].position) / 3.0f * triangle_area;
+            normal += triangle_normal_area;
+            area += triangle_area;
+        }
+        if (area > 0.0f)
+        {
+            centroid /= area;
+        }
+        auto normal_length = glm::length(normal);
+        if (normal_length > 0.0f)
+        {
+            normal /= normal_length;
+        }
+        sorted.push_back({ begin, end, glm::dot(centroid - mesh_centroid, normal) });
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](auto& left, auto& right) { return left.key > right.key; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (auto& cluster : sorted)
+    {
+        output.insert(output.end(), indices.begin() + (ptrdiff_t)cluster.begin * 3, indices.begin() + (ptrdiff_t)cluster.end * 3);
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void vengine::mesh_optimizer::optimize_vertex_fetch(std::vector<vertex>& vertices, std::span<uint32_t> indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), invalid_index);
+    std::vector<vertex> output;
+    output.reserve(vertices.size());
+    for (auto& index : indices)
+    {
+        if (remap[index] == invalid_index)
+        {
+            remap[index] = (uint32_t)output.size();
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices = std::move(output);
+}
+
+vengine::mesh_optimizer::statistics vengine::mesh_optimizer::optimize(mesh& m, const options& opts)
+{
+    if (m.uploaded())
+    {
+        log::warning("vengine::mesh_optimizer::optimize(mesh&, const options&)", "Mesh already got uploaded, optimizing it has no effect.");
+    }
+    if (m.baked())
+    {
+        log::warning("vengine::mesh_optimizer::optimize(mesh&, const options&)", "Baked meshes are optimized when baking, skipping.");
+        return { };
+    }
+    if (m.indices.empty())
+    {
+        m.indices.resize(m.vertices.size());
+        for (size_t i = 0; i < m.indices.size(); i++)
+        {
+            m.indices[i] = (uint32_t)i;
+        }
+    }
+    auto before = analyze_vertex_cache(m.indices, m.vertices.size());
+    // Triangles must not move between submeshes
+    std::vector<std::span<uint32_t>> ranges;
+    if (m.submeshes.empty())
+    {
+        ranges.emplace_back(m.indices);
+    }
+    for (auto& sub : m.submeshes)
+    {
+        ranges.push_back(std::span<uint32_t>(m.indices).subspan(sub.first_index, sub.index_count));
+    }
+    for (auto range : ranges)
+    {
+        if (opts.vertex_cache)
+        {
+            optimize_vertex_cache(range, m.vertices.size());
+        }
+        if (opts.overdraw)
+        {
+            optimize_overdraw(range, m.vertices, opts.overdraw_threshold);
+        }
+    }
+    if (opts.vertex_fetch)
+    {
+        optimize_vertex_fetch(m.vertices, m.indices);
+    }
+    auto after = analyze_vertex_cache(m.indices, m.vertices.size());
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", before.acmr, after.acmr, before.atvr, after.atvr);
+    log::info("vengine::mesh_optimizer::optimize(mesh&, const options&)", buffer);
+    return after;
+}
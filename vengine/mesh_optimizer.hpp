@@ -0,0 +1,63 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_MESH_OPTIMIZER_HPP
+#define GAME_PROJ_MESH_OPTIMIZER_HPP
+
+#include "mesh.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace vengine::mesh_optimizer
+{
+    struct statistics
+    {
+        // Average cache miss ratio, vertex shader invocations per triangle (0.5 best, 3.0 worst)
+        float acmr;
+        // Average transformed vertex ratio, vertex shader invocations per vertex (1.0 best)
+        float atvr;
+    };
+
+    struct options
+    {
+        bool vertex_cache = true;
+        // Reorders the triangle clusters produced by the vertex cache pass front to back
+        bool overdraw = false;
+        // Allowed ACMR degradation of the overdraw pass (1.05 = 5% worse)
+        float overdraw_threshold = 1.05f;
+        bool vertex_fetch = true;
+    };
+
+    /**
+     * Simulates a FIFO post-transform cache of cache_size entries.
+     */
+    [[nodiscard]] statistics analyze_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count, size_t cache_size = 16);
+
+    /**
+     * Reorders the triangles for post-transform cache locality (Forsyth, "Linear-Speed Vertex Cache Optimisation").
+     */
+    void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count);
+
+    /**
+     * Splits the triangles into clusters at cache flushes and sorts the clusters so that the
+     * ones facing outwards are drawn first (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+     * Expects indices to be vertex cache optimized already.
+     */
+    void optimize_overdraw(std::span<uint32_t> indices, std::span<const vertex> vertices, float threshold = 1.05f);
+
+    /**
+     * Reorders vertices into the order they are first referenced by indices and drops unreferenced vertices.
+     * Must run last, as it renumbers indices.
+     */
+    void optimize_vertex_fetch(std::vector<vertex>& vertices, std::span<uint32_t> indices);
+
+    /**
+     * Runs the selected passes on m (which must not be uploaded yet) and logs ACMR/ATVR before and after.
+     */
+    statistics optimize(mesh& m, const options& opts = { });
+}
+
+#endif //GAME_PROJ_MESH_OPTIMIZER_HPP
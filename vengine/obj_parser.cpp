@@ -0,0 +1,519 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "obj_parser.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VENGINE_OBJ_PARSER_SSE2
+#endif
+
+namespace
+{
+    using vengine::obj_parser::corner;
+    using vengine::obj_parser::missing_index;
+
+    // Smaller files are not worth the thread round-trip
+    const size_t min_chunk_size = 1024 * 1024;
+    // Marks indices relative to the first element of the chunk (see chunk::corners)
+    const uint32_t chunk_local_flag = 0x80000000u;
+
+    const double powers_of_ten[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    struct shape_start
+    {
+        std::string name;
+        // Into chunk::corners
+        size_t first_corner;
+    };
+
+    // Negative index reaching in front of the chunk, resolved once the preceding chunks are known
+    struct index_fixup
+    {
+        size_t corner;
+        // 0 = position, 1 = texcoord, 2 = normal
+        int component;
+        // Relative to the first element of the chunk, always negative
+        int64_t offset;
+    };
+
+    struct chunk
+    {
+        const char* begin;
+        const char* end;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texcoords;
+        std::vector<glm::vec3> normals;
+        // Absolute indices, or chunk local ones with chunk_local_flag set
+        std::vector<corner> corners;
+        std::vector<index_fixup> fixups;
+        std::vector<shape_start> shape_starts;
+        // Start of the first malformed line
+        const char* error = nullptr;
+    };
+
+    inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    const char* skip_spaces(const char* p, const char* end)
+    {
+        while (p != end && is_space(*p))
+        {
+            p++;
+        }
+        return p;
+    }
+
+    const char* find_newline(const char* begin, const char* end)
+    {
+#ifdef VENGINE_OBJ_PARSER_SSE2
+        auto newline = _mm_set1_epi8('\n');
+        while (end - begin >= 16)
+        {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+            if (mask != 0)
+            {
+                return begin + std::countr_zero(mask);
+            }
+            begin += 16;
+        }
+#endif
+        auto found = static_cast<const char*>(memchr(begin, '\n', (size_t)(end - begin)));
+        return found ? found : end;
+    }
+
+    // strtof on a terminated copy, handles everything the fast path does not (inf, nan, huge exponents)
+    const char* parse_float_slow(const char* p, const char* end, float& out)
+    {
+        char buffer[64];
+        size_t length = 0;
+        while (p + length != end && !is_space(p[length]) && length < sizeof(buffer) - 1)
+        {
+            buffer[length] = p[length];
+            length++;
+        }
+        buffer[length] = '\0';
+        char* parsed_end;
+        out = strtof(buffer, &parsed_end);
+        if (parsed_end == buffer)
+        {
+            return nullptr;
+        }
+        return p + (parsed_end - buffer);
+    }
+
+    // Up to 19 significant digits are accumulated exactly and scaled by one exact power of ten
+    const char* parse_float(const char* p, const char* end, float& out)
+    {
+        auto start = p;
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+        uint64_t mantissa = 0;
+        int significant_digits = 0;
+        int exponent = 0;
+        bool any_digit = false;
+        for (; p != end && is_digit(*p); p++)
+        {
+            any_digit = true;
+            if (significant_digits < 19)
+            {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                significant_digits += mantissa != 0;
+            }
+            else
+            {
+                exponent++;
+            }
+        }
+        if (p != end && *p == '.')
+        {
+            for (p++; p != end && is_digit(*p); p++)
+            {
+                any_digit = true;
+                if (significant_digits < 19)
+                {
+                    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                    significant_digits += mantissa != 0;
+                    exponent--;
+                }
+            }
+        }
+        if (!any_digit)
+        {
+            return parse_float_slow(start, end, out);
+        }
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            auto q = p + 1;
+            bool negative_exponent = false;
+            if (q != end && (*q == '-' || *q == '+'))
+            {
+                negative_exponent = *q == '-';
+                q++;
+            }
+            if (q != end && is_digit(*q))
+            {
+                int exponent_value = 0;
+                for (; q != end && is_digit(*q); q++)
+                {
+                    exponent_value = std::min(exponent_value * 10 + (*q - '0'), 10000);
+                }
+                exponent += negative_exponent ? -exponent_value : exponent_value;
+                p = q;
+            }
+        }
+        if (exponent < -22 || exponent > 22)
+        {
+            return parse_float_slow(start, end, out);
+        }
+        auto value = (double)mantissa;
+        value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+        out = (float)(negative ? -value : value);
+        return p;
+    }
+
+    const char* parse_int(const char* p, const char* end, int64_t& out)
+    {
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+        if (p == end || !is_digit(*p))
+        {
+            return nullptr;
+        }
+        int64_t value = 0;
+        for (; p != end && is_digit(*p); p++)
+        {
+            value = std::min<int64_t>(value * 10 + (*p - '0'), INT64_MAX / 10);
+        }
+        out = negative ? -value : value;
+        return p;
+    }
+
+    template<size_t count, typename T>
+    const char* parse_floats(const char* p, const char* end, T& out)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            p = skip_spaces(p, end);
+            p = parse_float(p, end, out[(typename T::length_type)i]);
+            if (!p)
+            {
+                return nullptr;
+            }
+        }
+        return p;
+    }
+
+    // Converts an OBJ index (1 based or negative) into corner storage, see chunk::corners.
+    // Indices in front of the chunk are recorded in fixups with corner as given.
+    bool resolve_index(int64_t index, size_t local_count, int component, size_t corner, std::vector<index_fixup>& fixups, uint32_t& out)
+    {
+        if (index > 0)
+        {
+            if (index > (int64_t)chunk_local_flag)
+            {
+                return false;
+            }
+            out = (uint32_t)(index - 1);
+            return true;
+        }
+        if (index == 0)
+        {
+            return false;
+        }
+        auto local = (int64_t)local_count + index;
+        if (local >= 0)
+        {
+            out = chunk_local_flag | (uint32_t)local;
+            return true;
+        }
+        fixups.push_back({ corner, component, local });
+        out = missing_index;
+        return true;
+    }
+
+    // f v, f v/vt, f v//vn or f v/vt/vn, any number of corners
+    const char* parse_face(chunk& c, const char* p, const char* end, std::vector<corner>& polygon, std::vector<index_fixup>& polygon_fixups)
+    {
+        polygon.clear();
+        polygon_fixups.clear();
+        while (true)
+        {
+            p = skip_spaces(p, end);
+            if (p == end || *p == '#')
+            {
+                break;
+            }
+            corner out { missing_index, missing_index, missing_index };
+            int64_t index;
+            p = parse_int(p, end, index);
+            bool good = p && resolve_index(index, c.positions.size(), 0, polygon.size(), polygon_fixups, out.position);
+            if (good && p != end && *p == '/')
+            {
+                p++;
+                if (p != end && *p != '/')
+                {
+                    p = parse_int(p, end, index);
+                    good = p && resolve_index(index, c.texcoords.size(), 1, polygon.size(), polygon_fixups, out.texcoord);
+                }
+                if (good && p != end && *p == '/')
+                {
+                    p++;
+                    p = parse_int(p, end, index);
+                    good = p && resolve_index(index, c.normals.size(), 2, polygon.size(), polygon_fixups, out.normal);
+                }
+            }
+            if (!good || (p != end && !is_space(*p)))
+            {
+                return nullptr;
+            }
+            polygon.push_back(out);
+        }
+        // Fan triangulation
+        for (size_t i = 1; i + 1 < polygon.size(); i++)
+        {
+            for (auto polygon_corner : { (size_t)0, i, i + 1 })
+            {
+                for (auto& fixup : polygon_fixups)
+                {
+                    if (fixup.corner == polygon_corner)
+                    {
+                        c.fixups.push_back({ c.corners.size(), fixup.component, fixup.offset });
+                    }
+                }
+                c.corners.push_back(polygon[polygon_corner]);
+            }
+        }
+        return p;
+    }
+
+    void parse_chunk(chunk& c)
+    {
+        std::vector<corner> polygon;
+        std::vector<index_fixup> polygon_fixups;
+        auto line = c.begin;
+        while (line < c.end)
+        {
+            auto line_end = find_newline(line, c.end);
+            auto p = skip_spaces(line, line_end);
+            if (p != line_end)
+            {
+                auto keyword_end = p;
+                while (keyword_end != line_end && !is_space(*keyword_end))
+                {
+                    keyword_end++;
+                }
+                auto keyword_length = keyword_end - p;
+                auto args = keyword_end;
+                if (keyword_length == 1 && *p == 'v')
+                {
+                    glm::vec3 position;
+                    args = parse_floats<3>(args, line_end, position);
+                    c.positions.push_back(position);
+                }
+                else if (keyword_length == 2 && p[0] == 'v' && p[1] == 'n')
+                {
+                    glm::vec3 normal;
+                    args = parse_floats<3>(args, line_end, normal);
+                    c.normals.push_back(normal);
+                }
+                else if (keyword_length == 2 && p[0] == 'v' && p[1] == 't')
+                {
+                    // v is optional
+                    glm::vec2 texcoord { 0.0f, 0.0f };
+                    args = parse_floats<1>(args, line_end, texcoord);
+                    if (args && skip_spaces(args, line_end) != line_end)
+                    {
+                        args = parse_float(skip_spaces(args, line_end), line_end, texcoord.y);
+                    }
+                    c.texcoords.push_back(texcoord);
+                }
+                else if (keyword_length == 1 && *p == 'f')
+                {
+                    args = parse_face(c, args, line_end, polygon, polygon_fixups);
+                }
+                else if (keyword_length == 1 && (*p == 'o' || *p == 'g'))
+                {
+                    auto name_begin = skip_spaces(args, line_end);
+                    auto name_end = line_end;
+                    while (name_end != name_begin && is_space(name_end[-1]))
+                    {
+                        name_end--;
+                    }
+                    c.shape_starts.push_back({ std::string(name_begin, name_end), c.corners.size() });
+                }
+                if (!args)
+                {
+                    c.error = line;
+                    return;
+                }
+            }
+            line = line_end + 1;
+        }
+    }
+
+    bool resolve_chunk_index(uint32_t& index, uint32_t base, size_t count)
+    {
+        if (index == missing_index)
+        {
+            return true;
+        }
+        if (index & chunk_local_flag)
+        {
+            index = base + (index & ~chunk_local_flag);
+        }
+        return index < count;
+    }
+}
+
+std::optional<vengine::obj_parser::result> vengine::obj_parser::parse(std::span<const uint8_t> data, utils::worker_pool* workers)
+{
+    const char* source = "vengine::obj_parser::parse(std::span<const uint8_t>, utils::worker_pool*)";
+    auto begin = reinterpret_cast<const char*>(data.data());
+    auto end = begin + data.size();
+
+    size_t chunk_count = 1;
+    if (workers && workers->size() > 1)
+    {
+        chunk_count = std::clamp<size_t>(data.size() / min_chunk_size, 1, workers->size() * 4);
+    }
+    std::vector<chunk> chunks(chunk_count);
+    auto chunk_begin = begin;
+    for (size_t i = 0; i < chunk_count; i++)
+    {
+        auto chunk_end = end;
+        if (i + 1 < chunk_count)
+        {
+            auto nominal_end = std::max(chunk_begin, begin + data.size() * (i + 1) / chunk_count);
+            chunk_end = std::min(find_newline(nominal_end, end) + 1, end);
+        }
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+
+    auto for_each_chunk = [&](const std::function<void(size_t)>& func) {
+        if (chunk_count == 1)
+        {
+            func(0);
+            return;
+        }
+        workers->parallel_for(chunk_count, [&](size_t index, size_t) { func(index); });
+    };
+    for_each_chunk([&](size_t index) { parse_chunk(chunks[index]); });
+
+    for (auto& c : chunks)
+    {
+        if (c.error)
+        {
+            auto line_end = std::min(find_newline(c.error, end), c.error + 80);
+            log::error(source, std::string("Malformed statement at byte ").append(std::to_string(c.error - begin))
+                    .append(": ").append(c.error, line_end));
+            return { };
+        }
+    }
+
+    // Every chunk gets copied into the final arrays at the offsets of all chunks before it
+    struct chunk_bases
+    {
+        size_t position;
+        size_t texcoord;
+        size_t normal;
+        size_t corner;
+    };
+    std::vector<chunk_bases> bases(chunk_count);
+    chunk_bases totals { };
+    for (size_t i = 0; i < chunk_count; i++)
+    {
+        bases[i] = totals;
+        totals.position += chunks[i].positions.size();
+        totals.texcoord += chunks[i].texcoords.size();
+        totals.normal += chunks[i].normals.size();
+        totals.corner += chunks[i].corners.size();
+    }
+    if (totals.position >= chunk_local_flag || totals.texcoord >= chunk_local_flag || totals.normal >= chunk_local_flag)
+    {
+        log::error(source, "Too many vertex attributes.");
+        return { };
+    }
+
+    result out;
+    out.positions.resize(totals.position);
+    out.texcoords.resize(totals.texcoord);
+    out.normals.resize(totals.normal);
+    out.corners.resize(totals.corner);
+    std::vector<char> chunk_valid(chunk_count, 1);
+    for_each_chunk([&](size_t index) {
+        auto& c = chunks[index];
+        auto& base = bases[index];
+        std::copy(c.positions.begin(), c.positions.end(), out.positions.begin() + (ptrdiff_t)base.position);
+        std::copy(c.texcoords.begin(), c.texcoords.end(), out.texcoords.begin() + (ptrdiff_t)base.texcoord);
+        std::copy(c.normals.begin(), c.normals.end(), out.normals.begin() + (ptrdiff_t)base.normal);
+        for (auto& fixup : c.fixups)
+        {
+            auto& target = fixup.component == 0 ? c.corners[fixup.corner].position
+                                                : fixup.component == 1 ? c.corners[fixup.corner].texcoord : c.corners[fixup.corner].normal;
+            auto component_base = fixup.component == 0 ? base.position : fixup.component == 1 ? base.texcoord : base.normal;
+            auto absolute = (int64_t)component_base + fixup.offset;
+            target = absolute < 0 ? chunk_local_flag - 1 : (uint32_t)absolute;
+        }
+        auto output = out.corners.begin() + (ptrdiff_t)base.corner;
+        for (auto corner : c.corners)
+        {
+            if (!resolve_chunk_index(corner.position, (uint32_t)base.position, totals.position)
+                || !resolve_chunk_index(corner.texcoord, (uint32_t)base.texcoord, totals.texcoord)
+                || !resolve_chunk_index(corner.normal, (uint32_t)base.normal, totals.normal)
+                || corner.position == missing_index)
+            {
+                chunk_valid[index] = 0;
+                return;
+            }
+            *output++ = corner;
+        }
+    });
+    if (std::find(chunk_valid.begin(), chunk_valid.end(), 0) != chunk_valid.end())
+    {
+        log::error(source, "Face references a vertex attribute that does not exist.");
+        return { };
+    }
+
+    // Triangles before the first o or g belong to an unnamed shape
+    std::vector<shape_start> starts { { "", 0 } };
+    for (size_t i = 0; i < chunk_count; i++)
+    {
+        for (auto& start : chunks[i].shape_starts)
+        {
+            starts.push_back({ std::move(start.name), bases[i].corner + start.first_corner });
+        }
+    }
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        auto first_corner = starts[i].first_corner;
+        auto end_corner = i + 1 < starts.size() ? starts[i + 1].first_corner : totals.corner;
+        if (end_corner > first_corner)
+        {
+            out.shapes.push_back({ std::move(starts[i].name), first_corner / 3, (end_corner - first_corner) / 3 });
+        }
+    }
+    return out;
+}
@@ -0,0 +1,65 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_OBJ_PARSER_HPP
+#define GAME_PROJ_OBJ_PARSER_HPP
+
+#include "worker_pool.hpp"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * Wavefront OBJ parser working in place on the file contents.
+ *
+ * Large files are split into line aligned chunks which are parsed in parallel, relative
+ * (negative) indices are resolved once all chunks are done. Polygons are fan triangulated.
+ *
+ * Supported statements are v, vt, vn, f, o and g, everything else (materials, smoothing groups,
+ * lines, points, ...) is skipped.
+ */
+namespace vengine::obj_parser
+{
+    const uint32_t missing_index = UINT32_MAX;
+
+    // Zero based indices into result::positions, texcoords and normals, missing_index if not given
+    struct corner
+    {
+        uint32_t position;
+        uint32_t texcoord;
+        uint32_t normal;
+    };
+
+    // Started by an o or g statement, the triangles of a shape are contiguous
+    struct shape
+    {
+        std::string name;
+        size_t first_triangle;
+        size_t triangle_count;
+    };
+
+    struct result
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texcoords;
+        std::vector<glm::vec3> normals;
+        // Three per triangle
+        std::vector<corner> corners;
+        // Shapes without triangles are dropped
+        std::vector<shape> shapes;
+    };
+
+    /**
+     * @param workers If not null, large files are parsed in parallel on it. Must not be called from one of its threads.
+     * @returns The parsed data or an empty optional if data is malformed.
+     */
+    [[nodiscard]] std::optional<result> parse(std::span<const uint8_t> data, utils::worker_pool* workers = nullptr);
+}
+
+#endif //GAME_PROJ_OBJ_PARSER_HPP
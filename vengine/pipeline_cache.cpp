@@ -0,0 +1,143 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "pipeline_cache.hpp"
+#include "io.hpp"
+#include "log.hpp"
+#include "vulkan-utils/stringify.hpp"
+
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+bool vengine::pipeline_cache::matches(const file_header& header) const
+{
+    return std::memcmp(header.magic, magic, sizeof(magic)) == 0
+           && header.version == version
+           && header.vendor_id == m_properties.vendorID
+           && header.device_id == m_properties.deviceID
+           && header.driver_version == m_properties.driverVersion
+           && std::memcmp(header.pipeline_cache_uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+vengine::vulkan_utils::result<void> vengine::pipeline_cache::create()
+{
+    const char* source = "vengine::pipeline_cache::create()";
+    std::vector<uint8_t> file_data;
+    size_t initial_data_size = 0;
+    const uint8_t* initial_data = nullptr;
+    std::error_code error_code;
+    if (!m_path.empty() && std::filesystem::exists(m_path, error_code) && io::read_file_from_disk(m_path, file_data))
+    {
+        file_header header;
+        if (file_data.size() < sizeof(header))
+        {
+            log::warning(source, "Pipeline cache file is truncated, starting with an empty cache.");
+        }
+        else
+        {
+            std::memcpy(&header, file_data.data(), sizeof(header));
+            if (!matches(header))
+            {
+                log::info(source, "Pipeline cache file was written for another device or driver, starting with an empty cache.");
+            }
+            else if (header.data_size != file_data.size() - sizeof(header))
+            {
+                log::warning(source, "Pipeline cache file is truncated, starting with an empty cache.");
+            }
+            else
+            {
+                initial_data = file_data.data() + sizeof(header);
+                initial_data_size = header.data_size;
+            }
+        }
+    }
+
+    VkPipelineCacheCreateInfo pipeline_cache_create_info = { };
+    pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipeline_cache_create_info.pNext = nullptr;
+    pipeline_cache_create_info.initialDataSize = initial_data_size;
+    pipeline_cache_create_info.pInitialData = initial_data;
+    auto create_result = vkCreatePipelineCache(m_device, &pipeline_cache_create_info, nullptr, &m_pipeline_cache);
+    if (create_result != VK_SUCCESS && initial_data_size != 0)
+    {
+        // Drivers validate the blob themselves, a rejected one is no reason to fail
+        log::warning(source, "Pipeline cache file was rejected by the driver, starting with an empty cache.");
+        pipeline_cache_create_info.initialDataSize = 0;
+        pipeline_cache_create_info.pInitialData = nullptr;
+        create_result = vkCreatePipelineCache(m_device, &pipeline_cache_create_info, nullptr, &m_pipeline_cache);
+    }
+    if (create_result != VK_SUCCESS)
+    {
+        auto message = std::string("Failed to create pipeline cache (").append(vulkan_utils::stringify::data(create_result)).append(").");
+        log::error(source, message);
+        m_pipeline_cache = VK_NULL_HANDLE;
+        return { create_result, message };
+    }
+    return { };
+}
+
+bool vengine::pipeline_cache::save() const
+{
+    const char* source = "vengine::pipeline_cache::save()";
+    if (m_path.empty() || m_pipeline_cache == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    size_t data_size = 0;
+    auto get_size_result = vkGetPipelineCacheData(m_device, m_pipeline_cache, &data_size, nullptr);
+    if (get_size_result != VK_SUCCESS)
+    {
+        log::warning(source, "Failed to query the pipeline cache size.");
+        return false;
+    }
+    std::vector<uint8_t> file_data(sizeof(file_header) + data_size);
+    auto get_data_result = vkGetPipelineCacheData(m_device, m_pipeline_cache, &data_size, file_data.data() + sizeof(file_header));
+    if (get_data_result != VK_SUCCESS)
+    {
+        log::warning(source, "Failed to read the pipeline cache data.");
+        return false;
+    }
+    file_data.resize(sizeof(file_header) + data_size);
+
+    file_header header { };
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.vendor_id = m_properties.vendorID;
+    header.device_id = m_properties.deviceID;
+    header.driver_version = m_properties.driverVersion;
+    std::memcpy(header.pipeline_cache_uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.data_size = data_size;
+    std::memcpy(file_data.data(), &header, sizeof(header));
+
+    // A crash while writing must not leave a truncated cache behind
+    auto temporary_path = m_path;
+    temporary_path += ".tmp";
+    if (!io::write_file_to_disk(temporary_path, file_data))
+    {
+        log::warning(source, "Failed to write the pipeline cache file.");
+        return false;
+    }
+    std::error_code error_code;
+    std::filesystem::rename(temporary_path, m_path, error_code);
+    if (error_code)
+    {
+        log::warning(source, "Failed to replace the pipeline cache file.");
+        std::filesystem::remove(temporary_path, error_code);
+        return false;
+    }
+    return true;
+}
+
+void vengine::pipeline_cache::destroy()
+{
+    if (m_pipeline_cache == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
+    m_pipeline_cache = VK_NULL_HANDLE;
+}
@@ -0,0 +1,84 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_PIPELINE_CACHE_HPP
+#define GAME_PROJ_PIPELINE_CACHE_HPP
+
+#include "vulkan-utils/result.hpp"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+
+namespace vengine
+{
+    /**
+     * VkPipelineCache persisted between runs.
+     *
+     * The file is only used if it was written for the same device and driver, which is checked
+     * against a header of our own (vendor, device, driver version and pipeline cache UUID),
+     * everything else starts with an empty cache.
+     */
+    class pipeline_cache
+    {
+    public:
+#pragma pack(push, 1)
+        struct file_header
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t vendor_id;
+            uint32_t device_id;
+            uint32_t driver_version;
+            uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+            // Size of the vkGetPipelineCacheData blob following the header
+            uint64_t data_size;
+        };
+#pragma pack(pop)
+        static constexpr char magic[4] = { 'V', 'P', 'L', 'C' };
+        // Bump whenever file_header changes
+        static const uint32_t version = 1;
+    private:
+        VkDevice m_device;
+        VkPhysicalDeviceProperties m_properties;
+        std::filesystem::path m_path;
+        VkPipelineCache m_pipeline_cache;
+
+        [[nodiscard]] bool matches(const file_header& header) const;
+    public:
+        /**
+         * @param path File the cache is loaded from and saved to, empty to not persist the cache.
+         */
+        pipeline_cache(VkDevice device, const VkPhysicalDeviceProperties& properties, std::filesystem::path path)
+                : m_device(device),
+                m_properties(properties),
+                m_path(std::move(path)),
+                m_pipeline_cache(VK_NULL_HANDLE)
+        {
+        }
+        pipeline_cache(const pipeline_cache&) = delete;
+        pipeline_cache& operator=(const pipeline_cache&) = delete;
+        ~pipeline_cache() { destroy(); }
+
+        /**
+         * Creates the cache, filled with the contents of the file if it matches this device.
+         */
+        vulkan_utils::result<void> create();
+
+        /**
+         * Writes the cache to the file. The previous file is only replaced once the new one is complete.
+         */
+        bool save() const;
+
+        /**
+         * Destroys the cache without saving it.
+         */
+        void destroy();
+
+        [[nodiscard]] VkPipelineCache handle() const { return m_pipeline_cache; }
+    };
+}
+
+#endif //GAME_PROJ_PIPELINE_CACHE_HPP
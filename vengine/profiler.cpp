@@ -0,0 +1,506 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "profiler.hpp"
+#include "log.hpp"
+#include "vulkan-utils/stringify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    /**
+     * Zones of a single thread. The owning thread is the only writer of head, the collecting one of tail.
+     */
+    struct thread_buffer
+    {
+        static const size_t capacity = 4096;
+        std::array<vengine::profiler::zone, capacity> zones;
+        std::atomic<size_t> head{};
+        std::atomic<size_t> tail{};
+        std::atomic<size_t> dropped{};
+        // Set once the owning thread exited, the buffer is removed after it was collected
+        std::atomic<bool> retired{};
+        uint32_t thread_id = 0;
+    };
+
+    struct thread_registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<thread_buffer>> buffers;
+        std::unordered_map<uint32_t, std::string> names;
+        uint32_t next_thread_id = 1;
+    };
+
+    thread_registry& registry()
+    {
+        static thread_registry instance;
+        return instance;
+    }
+
+    struct thread_buffer_owner
+    {
+        std::shared_ptr<thread_buffer> buffer;
+        ~thread_buffer_owner()
+        {
+            if (buffer)
+            {
+                buffer->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_buffer& local_buffer()
+    {
+        thread_local thread_buffer_owner owner;
+        if (!owner.buffer)
+        {
+            owner.buffer = std::make_shared<thread_buffer>();
+            auto& threads = registry();
+            std::unique_lock lock(threads.mutex);
+            owner.buffer->thread_id = threads.next_thread_id++;
+            threads.buffers.push_back(owner.buffer);
+        }
+        return *owner.buffer;
+    }
+
+    /**
+     * Moves the zones recorded on every thread into zones.
+     *
+     * @returns The number of zones dropped as a ring buffer was full.
+     */
+    size_t collect_cpu_zones(std::vector<vengine::profiler::zone>& zones)
+    {
+        size_t dropped = 0;
+        auto& threads = registry();
+        std::unique_lock lock(threads.mutex);
+        for (auto& buffer : threads.buffers)
+        {
+            auto retired = buffer->retired.load(std::memory_order_acquire);
+            auto head = buffer->head.load(std::memory_order_acquire);
+            auto tail = buffer->tail.load(std::memory_order_relaxed);
+            for (auto i = tail; i != head; i++)
+            {
+                auto zone = buffer->zones[i % thread_buffer::capacity];
+                zone.thread_id = buffer->thread_id;
+                zones.push_back(zone);
+            }
+            buffer->tail.store(head, std::memory_order_release);
+            dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+            if (retired)
+            {
+                // Nothing is written after the owner exited, the buffer is empty now
+                buffer.reset();
+            }
+        }
+        threads.buffers.erase(std::remove(threads.buffers.begin(), threads.buffers.end(), nullptr), threads.buffers.end());
+        return dropped;
+    }
+
+    void write_json_string(std::ostream& stream, std::string_view value)
+    {
+        stream << '"';
+        for (auto c : value)
+        {
+            switch (c)
+            {
+                case '"': stream << "\\\""; break;
+                case '\\': stream << "\\\\"; break;
+                case '\n': stream << "\\n"; break;
+                case '\t': stream << "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+                        stream << escaped;
+                    }
+                    else
+                    {
+                        stream << c;
+                    }
+                    break;
+            }
+        }
+        stream << '"';
+    }
+
+    void write_complete_event(std::ostream& stream, const char* category, const vengine::profiler::zone& zone,
+                              uint32_t process_id, uint64_t origin)
+    {
+        // Trace timestamps are microseconds, zones before the origin are clamped to it
+        auto begin = std::max(zone.begin, origin);
+        auto end = std::max(zone.end, begin);
+        char times[96];
+        std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f",
+                      (double)(begin - origin) / 1000.0, (double)(end - begin) / 1000.0);
+        stream << ",\n{\"name\":";
+        write_json_string(stream, zone.name ? zone.name : "");
+        stream << ",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":" << process_id
+               << ",\"tid\":" << zone.thread_id << "," << times << "}";
+    }
+}
+
+uint64_t vengine::profiler::frame::gpu_time() const
+{
+    if (gpu_zones.empty())
+    {
+        return 0;
+    }
+    uint64_t begin = std::numeric_limits<uint64_t>::max();
+    uint64_t end = 0;
+    for (auto& zone : gpu_zones)
+    {
+        begin = std::min(begin, zone.begin);
+        end = std::max(end, zone.end);
+    }
+    return end - begin;
+}
+
+vengine::profiler::profiler(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t timestamp_valid_bits,
+                            size_t frames_in_flight, size_t zones_per_frame, size_t history)
+        : m_device(device),
+        m_timestamp_period(properties.limits.timestampPeriod),
+        m_timestamp_valid_bits(timestamp_valid_bits),
+        m_zones_per_frame(std::max<size_t>(zones_per_frame, 1)),
+        // Frames wait frames_in_flight frames for their GPU zones, which must not push them out right away
+        m_history(std::max(history, frames_in_flight + 1)),
+        m_gpu_slots(timestamp_valid_bits != 0 ? frames_in_flight : 0),
+        m_current_slot(nullptr),
+        m_gpu_frame_active(false),
+        m_dropped_gpu_zones(0),
+        m_gpu_offset(0),
+        m_gpu_offset_valid(false),
+        m_open_frame(),
+        m_frame_open(false),
+        m_capturing(false)
+{
+}
+
+vengine::vulkan_utils::result<void> vengine::profiler::create()
+{
+    if (m_gpu_slots.empty())
+    {
+        log::warning("vengine::profiler::create()", "Graphics queue does not support timestamps, GPU zones are not recorded.");
+        return { };
+    }
+    for (auto& slot : m_gpu_slots)
+    {
+        VkQueryPoolCreateInfo query_pool_create_info = { };
+        query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_create_info.pNext = nullptr;
+        query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_create_info.queryCount = (uint32_t)(m_zones_per_frame * 2);
+
+        auto create_query_pool_result = vkCreateQueryPool(m_device, &query_pool_create_info, nullptr, &slot.query_pool);
+        if (create_query_pool_result != VK_SUCCESS)
+        {
+            auto message = std::string("Failed to create timestamp query pool (").append(vulkan_utils::stringify::data(create_query_pool_result)).append(")");
+            log::error("vengine::profiler::create()", message);
+            return { create_query_pool_result, message };
+        }
+        slot.names.resize(m_zones_per_frame);
+    }
+    return { };
+}
+
+void vengine::profiler::destroy()
+{
+    for (auto& slot : m_gpu_slots)
+    {
+        if (slot.query_pool)
+        {
+            vkDestroyQueryPool(m_device, slot.query_pool, nullptr);
+            slot.query_pool = VK_NULL_HANDLE;
+        }
+        slot.submitted = false;
+    }
+    m_current_slot = nullptr;
+    m_gpu_frame_active = false;
+}
+
+uint64_t vengine::profiler::now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void vengine::profiler::thread_name(std::string name)
+{
+    auto thread_id = local_buffer().thread_id;
+    auto& threads = registry();
+    std::unique_lock lock(threads.mutex);
+    threads.names[thread_id] = std::move(name);
+}
+
+void vengine::profiler::record(const char* name, uint64_t begin, uint64_t end)
+{
+    auto& buffer = local_buffer();
+    auto head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= thread_buffer::capacity)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.zones[head % thread_buffer::capacity] = { name, begin, end, 0 };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void vengine::profiler::complete(const frame& completed)
+{
+    m_frames.push_back(completed);
+    while (m_frames.size() > m_history)
+    {
+        m_frames.pop_front();
+    }
+    if (m_capturing)
+    {
+        m_captured_frames.push_back(completed);
+    }
+}
+
+void vengine::profiler::begin_frame(size_t frame_number)
+{
+    auto time = now();
+    if (m_frame_open)
+    {
+        m_open_frame.end = time;
+        m_open_frame.dropped_zones += collect_cpu_zones(m_open_frame.cpu_zones);
+        if (m_open_frame.gpu_pending)
+        {
+            m_pending_frames.push_back(std::move(m_open_frame));
+        }
+        else
+        {
+            complete(m_open_frame);
+        }
+        m_open_frame = { };
+        m_frame_open = false;
+    }
+    else
+    {
+        // Zones still ending after the profiler got disabled
+        std::vector<zone> discarded;
+        collect_cpu_zones(discarded);
+    }
+
+    if (!enabled())
+    {
+        return;
+    }
+    m_open_frame.frame_number = frame_number;
+    m_open_frame.begin = time;
+    m_open_frame.end = time;
+    m_open_frame.thread_id = local_buffer().thread_id;
+    m_open_frame.dropped_zones = 0;
+    m_open_frame.gpu_pending = false;
+    m_frame_open = true;
+}
+
+void vengine::profiler::begin_gpu_frame(size_t slot_index)
+{
+    m_current_slot = nullptr;
+    m_gpu_frame_active = false;
+    if (slot_index >= m_gpu_slots.size() || !m_gpu_slots[slot_index].query_pool)
+    {
+        return;
+    }
+    auto& slot = m_gpu_slots[slot_index];
+    auto zone_count = std::min<size_t>(slot.next_zone.load(std::memory_order_relaxed), m_zones_per_frame);
+    if (slot.submitted)
+    {
+        auto pending = std::find_if(m_pending_frames.begin(), m_pending_frames.end(), [&slot](const frame& pending_frame) {
+            return pending_frame.frame_number == slot.frame_number && pending_frame.gpu_pending;
+        });
+        if (pending != m_pending_frames.end() && zone_count > 0)
+        {
+            std::vector<uint64_t> ticks(zone_count * 2);
+            // The frame is known to be done, no need to wait or ask for availability
+            auto query_results_result = vkGetQueryPoolResults(
+                    m_device,
+                    slot.query_pool,
+                    0,
+                    (uint32_t)ticks.size(),
+                    ticks.size() * sizeof(uint64_t),
+                    ticks.data(),
+                    sizeof(uint64_t),
+                    VK_QUERY_RESULT_64_BIT);
+            if (query_results_result == VK_SUCCESS)
+            {
+                auto mask = m_timestamp_valid_bits >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << m_timestamp_valid_bits) - 1;
+                auto to_nano_seconds = [&](uint64_t tick) { return (int64_t)((double)(tick & mask) * m_timestamp_period); };
+                int64_t first = std::numeric_limits<int64_t>::max();
+                for (size_t i = 0; i < zone_count; i++)
+                {
+                    first = std::min(first, to_nano_seconds(ticks[i * 2]));
+                }
+                // Nothing of the frame runs before it was submitted
+                auto lower_bound = (int64_t)slot.submit_time - first;
+                if (!m_gpu_offset_valid || lower_bound > m_gpu_offset)
+                {
+                    m_gpu_offset = lower_bound;
+                    m_gpu_offset_valid = true;
+                }
+                pending->gpu_zones.reserve(zone_count);
+                for (size_t i = 0; i < zone_count; i++)
+                {
+                    auto begin = to_nano_seconds(ticks[i * 2]) + m_gpu_offset;
+                    auto end = std::max(to_nano_seconds(ticks[i * 2 + 1]) + m_gpu_offset, begin);
+                    pending->gpu_zones.push_back({ slot.names[i], (uint64_t)begin, (uint64_t)end, 0 });
+                }
+            }
+            else
+            {
+                log::warning("vengine::profiler::begin_gpu_frame(size_t)",
+                             std::string("Failed to read timestamp queries (").append(vulkan_utils::stringify::data(query_results_result)).append(")"));
+            }
+        }
+        if (pending != m_pending_frames.end())
+        {
+            pending->gpu_pending = false;
+        }
+    }
+    // Frames complete in order
+    while (!m_pending_frames.empty() && !m_pending_frames.front().gpu_pending)
+    {
+        complete(m_pending_frames.front());
+        m_pending_frames.pop_front();
+    }
+
+    slot.submitted = false;
+    slot.next_zone.store(0, std::memory_order_relaxed);
+    m_current_slot = &slot;
+}
+
+void vengine::profiler::record_reset(VkCommandBuffer command_buffer)
+{
+    if (!m_current_slot || !enabled())
+    {
+        return;
+    }
+    vkCmdResetQueryPool(command_buffer, m_current_slot->query_pool, 0, (uint32_t)(m_zones_per_frame * 2));
+    m_gpu_frame_active = true;
+}
+
+void vengine::profiler::end_gpu_frame(size_t frame_number, uint64_t submit_time)
+{
+    if (!m_current_slot || !m_gpu_frame_active)
+    {
+        return;
+    }
+    m_gpu_frame_active = false;
+    m_current_slot->frame_number = frame_number;
+    m_current_slot->submit_time = submit_time;
+    m_current_slot->submitted = true;
+    if (m_frame_open && m_open_frame.frame_number == frame_number)
+    {
+        m_open_frame.gpu_pending = m_current_slot->next_zone.load(std::memory_order_relaxed) > 0;
+        m_open_frame.dropped_zones += m_dropped_gpu_zones.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t vengine::profiler::begin_gpu_zone(VkCommandBuffer command_buffer, const char* name)
+{
+    if (!m_gpu_frame_active)
+    {
+        return invalid_zone;
+    }
+    auto zone = m_current_slot->next_zone.fetch_add(1, std::memory_order_relaxed);
+    if (zone >= m_zones_per_frame)
+    {
+        m_dropped_gpu_zones.fetch_add(1, std::memory_order_relaxed);
+        return invalid_zone;
+    }
+    m_current_slot->names[zone] = name;
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_current_slot->query_pool, zone * 2);
+    return zone;
+}
+
+void vengine::profiler::end_gpu_zone(VkCommandBuffer command_buffer, uint32_t zone)
+{
+    if (zone == invalid_zone || !m_gpu_frame_active)
+    {
+        return;
+    }
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_current_slot->query_pool, zone * 2 + 1);
+}
+
+void vengine::profiler::begin_capture()
+{
+    m_captured_frames.clear();
+    m_capturing = true;
+}
+
+bool vengine::profiler::end_capture(const std::filesystem::path& path)
+{
+    m_capturing = false;
+    auto frames = std::move(m_captured_frames);
+    m_captured_frames = { };
+    frames.insert(frames.end(), m_pending_frames.begin(), m_pending_frames.end());
+    return write_chrome_trace(path, frames);
+}
+
+bool vengine::profiler::write_chrome_trace(const std::filesystem::path& path, std::span<const frame> frames)
+{
+    const char* source = "vengine::profiler::write_chrome_trace(const std::filesystem::path&, std::span<const frame>)";
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.good())
+    {
+        log::error(source, std::string("Failed to open ").append(path.string()).append(" for writing."));
+        return false;
+    }
+
+    std::unordered_map<uint32_t, std::string> names;
+    {
+        auto& threads = registry();
+        std::unique_lock lock(threads.mutex);
+        names = threads.names;
+    }
+    uint64_t origin = frames.empty() ? 0 : frames.front().begin;
+    for (auto& frame : frames)
+    {
+        origin = std::min(origin, frame.begin);
+    }
+
+    // Process 0 holds the CPU threads, process 1 the graphics queue
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+           << R"({"name":"process_name","ph":"M","pid":0,"args":{"name":"CPU"}})" << ",\n"
+           << R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"GPU"}})" << ",\n"
+           << R"({"name":"thread_name","ph":"M","pid":1,"tid":0,"args":{"name":"Graphics queue"}})";
+    for (auto& [thread_id, name] : names)
+    {
+        stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread_id << ",\"args\":{\"name\":";
+        write_json_string(stream, name);
+        stream << "}}";
+    }
+    for (auto& frame : frames)
+    {
+        auto frame_name = std::string("Frame ").append(std::to_string(frame.frame_number));
+        write_complete_event(stream, "frame", { frame_name.c_str(), frame.begin, frame.end, frame.thread_id }, 0, origin);
+        for (auto& zone : frame.cpu_zones)
+        {
+            write_complete_event(stream, "cpu", zone, 0, origin);
+        }
+        for (auto& zone : frame.gpu_zones)
+        {
+            write_complete_event(stream, "gpu", zone, 1, origin);
+        }
+    }
+    stream << "\n]}\n";
+    stream.flush();
+    if (!stream.good())
+    {
+        log::error(source, std::string("Failed to write ").append(path.string()).append("."));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,250 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_PROFILER_HPP
+#define GAME_PROJ_PROFILER_HPP
+
+#include "vulkan-utils/result.hpp"
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#define VENGINE_PROFILER_CONCAT_IMPL(a, b) a##b
+#define VENGINE_PROFILER_CONCAT(a, b) VENGINE_PROFILER_CONCAT_IMPL(a, b)
+// Defining VENGINE_PROFILER_DISABLED compiles every zone and the query resets out,
+// only the frame bookkeeping (begin_frame, begin_gpu_frame and end_gpu_frame) is left.
+#ifndef VENGINE_PROFILER_DISABLED
+// Times the enclosing scope on the calling thread, name must be a string literal.
+#define VENGINE_PROFILE_ZONE(name) ::vengine::profiler::cpu_zone VENGINE_PROFILER_CONCAT(vengine_profile_zone_, __LINE__)(name)
+// Times the commands recorded to command_buffer until the end of the enclosing scope, name must be a string literal.
+#define VENGINE_PROFILE_GPU_ZONE(instance, command_buffer, name) ::vengine::profiler::gpu_zone VENGINE_PROFILER_CONCAT(vengine_profile_gpu_zone_, __LINE__)(instance, command_buffer, name)
+// For GPU zones not bound to a scope, see profiler::begin_gpu_zone, end_gpu_zone and record_reset.
+#define VENGINE_PROFILE_GPU_ZONE_BEGIN(instance, command_buffer, name) (instance).begin_gpu_zone(command_buffer, name)
+#define VENGINE_PROFILE_GPU_ZONE_END(instance, command_buffer, zone) (instance).end_gpu_zone(command_buffer, zone)
+#define VENGINE_PROFILE_GPU_RESET(instance, command_buffer) (instance).record_reset(command_buffer)
+#else
+#define VENGINE_PROFILE_ZONE(name)
+#define VENGINE_PROFILE_GPU_ZONE(instance, command_buffer, name)
+#define VENGINE_PROFILE_GPU_ZONE_BEGIN(instance, command_buffer, name) ::vengine::profiler::invalid_zone
+#define VENGINE_PROFILE_GPU_ZONE_END(instance, command_buffer, zone) ((void)(zone))
+#define VENGINE_PROFILE_GPU_RESET(instance, command_buffer) ((void)0)
+#endif
+
+namespace vengine
+{
+    /**
+     * Per frame CPU and GPU timings, exportable as Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+     *
+     * CPU zones go into a ring buffer of the recording thread without locking and are collected by begin_frame.
+     * GPU zones are timestamp queries in a pool per frame in flight, read back once the GPU finished the frame.
+     * The GPU clock is mapped onto the CPU one assuming no frame starts on the GPU before it was submitted,
+     * GPU zones may hence appear slightly early until the queue ran idle once.
+     */
+    class profiler
+    {
+    public:
+        struct zone
+        {
+            // String literal given to the zone
+            const char* name;
+            // Nanoseconds of std::chrono::steady_clock
+            uint64_t begin;
+            uint64_t end;
+            // Of the recording thread, 0 for GPU zones
+            uint32_t thread_id;
+        };
+        struct frame
+        {
+            size_t frame_number;
+            uint64_t begin;
+            uint64_t end;
+            // Thread calling begin_frame
+            uint32_t thread_id;
+            // Zones that ended during the frame, on any thread
+            std::vector<zone> cpu_zones;
+            std::vector<zone> gpu_zones;
+            // Lost as a thread ring buffer or the query pool was full
+            size_t dropped_zones;
+            // Set until the GPU zones were read back
+            bool gpu_pending;
+
+            [[nodiscard]] uint64_t cpu_time() const { return end - begin; }
+            /**
+             * @returns Nanoseconds from the first GPU zone starting to the last one ending.
+             */
+            [[nodiscard]] uint64_t gpu_time() const;
+        };
+
+        /**
+         * Records the lifetime of itself if the profiler is enabled, see VENGINE_PROFILE_ZONE.
+         */
+        class cpu_zone
+        {
+            const char* m_name;
+            uint64_t m_begin;
+        public:
+            explicit cpu_zone(const char* name) : m_name(name), m_begin(enabled() ? now() : 0) {}
+            cpu_zone(const cpu_zone&) = delete;
+            cpu_zone& operator=(const cpu_zone&) = delete;
+            ~cpu_zone()
+            {
+                if (m_begin != 0)
+                {
+                    record(m_name, m_begin, now());
+                }
+            }
+        };
+
+        /**
+         * Writes a timestamp when created and when destroyed, see VENGINE_PROFILE_GPU_ZONE.
+         * The command buffer must be recorded between begin_gpu_frame and end_gpu_frame.
+         */
+        class gpu_zone
+        {
+            profiler& m_profiler;
+            VkCommandBuffer m_command_buffer;
+            uint32_t m_zone;
+        public:
+            gpu_zone(profiler& profiler, VkCommandBuffer command_buffer, const char* name)
+                    : m_profiler(profiler),
+                    m_command_buffer(command_buffer),
+                    m_zone(profiler.begin_gpu_zone(command_buffer, name))
+            {
+            }
+            gpu_zone(const gpu_zone&) = delete;
+            gpu_zone& operator=(const gpu_zone&) = delete;
+            ~gpu_zone() { m_profiler.end_gpu_zone(m_command_buffer, m_zone); }
+        };
+        static const uint32_t invalid_zone = ~(uint32_t)0;
+    private:
+        struct gpu_slot
+        {
+            VkQueryPool query_pool = VK_NULL_HANDLE;
+            // Next free zone, two queries each
+            std::atomic<uint32_t> next_zone{};
+            std::vector<const char*> names;
+            // Of the frame submitted last, pending until read back
+            size_t frame_number = 0;
+            uint64_t submit_time = 0;
+            bool submitted = false;
+        };
+        static inline std::atomic<bool> s_enabled{};
+
+        VkDevice m_device;
+        double m_timestamp_period;
+        uint32_t m_timestamp_valid_bits;
+        size_t m_zones_per_frame;
+        size_t m_history;
+        std::vector<gpu_slot> m_gpu_slots;
+        gpu_slot* m_current_slot;
+        // Reset was recorded, GPU zones may be written this frame
+        bool m_gpu_frame_active;
+        std::atomic<size_t> m_dropped_gpu_zones;
+        // Added to GPU nanoseconds to get CPU ones, the largest lower bound the submits seen so far give
+        int64_t m_gpu_offset;
+        bool m_gpu_offset_valid;
+        frame m_open_frame;
+        bool m_frame_open;
+        // Closed but waiting for their GPU zones, oldest first
+        std::deque<frame> m_pending_frames;
+        std::deque<frame> m_frames;
+        bool m_capturing;
+        std::vector<frame> m_captured_frames;
+
+        static void record(const char* name, uint64_t begin, uint64_t end);
+        void complete(const frame& completed);
+    public:
+        /**
+         * @param timestamp_valid_bits Of the queue family GPU zones are recorded on, 0 disables GPU zones.
+         * @param zones_per_frame GPU zones a single frame may record, further zones are dropped.
+         * @param history Number of completed frames kept (see frames).
+         */
+        profiler(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t timestamp_valid_bits,
+                 size_t frames_in_flight, size_t zones_per_frame, size_t history);
+        profiler(const profiler&) = delete;
+        profiler& operator=(const profiler&) = delete;
+        ~profiler() { destroy(); }
+
+        /**
+         * Creates the timestamp query pools, does nothing if the queue does not support timestamps.
+         */
+        vulkan_utils::result<void> create();
+        void destroy();
+
+        [[nodiscard]] static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+        /**
+         * Starts or stops recording zones, on every thread. Takes effect on the GPU with the next frame.
+         */
+        static void enabled(bool enable) { s_enabled.store(enable, std::memory_order_relaxed); }
+        [[nodiscard]] bool gpu_supported() const { return m_timestamp_valid_bits != 0; }
+
+        /**
+         * Names the calling thread in exported traces.
+         */
+        static void thread_name(std::string name);
+        [[nodiscard]] static uint64_t now();
+
+        /**
+         * Closes the current frame, collecting the CPU zones of every thread, and opens the next one.
+         */
+        void begin_frame(size_t frame_number);
+        /**
+         * Reads back the GPU zones of the frame that used slot last and makes slot the one recorded to.
+         * The GPU must be done with that frame.
+         */
+        void begin_gpu_frame(size_t slot);
+        /**
+         * Resets the queries of the current slot, must be recorded before any GPU zone of the frame
+         * and outside of a render pass.
+         */
+        void record_reset(VkCommandBuffer command_buffer);
+        /**
+         * Marks the GPU zones of the current slot as submitted, call once the frame was submitted.
+         *
+         * @param submit_time Taken via now() right before the submit.
+         */
+        void end_gpu_frame(size_t frame_number, uint64_t submit_time);
+
+        /**
+         * Writes the begin timestamp of a GPU zone, thread safe.
+         *
+         * @returns The zone to pass to end_gpu_zone, invalid_zone if nothing was written.
+         */
+        uint32_t begin_gpu_zone(VkCommandBuffer command_buffer, const char* name);
+        /**
+         * Writes the end timestamp, command_buffer may differ from the one the zone began in
+         * as long as both are submitted together, in order.
+         */
+        void end_gpu_zone(VkCommandBuffer command_buffer, uint32_t zone);
+
+        /**
+         * @returns The last completed frames, oldest first. Frames whose GPU zones are still pending are not included.
+         */
+        [[nodiscard]] const std::deque<frame>& frames() const { return m_frames; }
+
+        /**
+         * Keeps every frame completed from now on until end_capture.
+         */
+        void begin_capture();
+        /**
+         * Writes the frames captured since begin_capture as Chrome trace JSON to path. Frames still waiting
+         * for the GPU are written without GPU zones.
+         */
+        bool end_capture(const std::filesystem::path& path);
+        [[nodiscard]] bool capturing() const { return m_capturing; }
+
+        /**
+         * Writes frames as Chrome trace JSON, CPU threads and the GPU queue show up as separate processes.
+         */
+        static bool write_chrome_trace(const std::filesystem::path& path, std::span<const frame> frames);
+    };
+}
+
+#endif //GAME_PROJ_PROFILER_HPP
@@ -13,5 +13,16 @@ std::optional<vengine::ram_file> vengine::ram_file::from_disk(const std::filesys
     {
         return {};
     }
-    return vengine::ram_file(data.begin(), data.end());
+    return vengine::ram_file(std::move(data));
+}
+
+std::optional<vengine::ram_file> vengine::ram_file::map_from_disk(const std::filesystem::path& path, mapped_file::access_pattern pattern)
+{
+    auto mapping = mapped_file::open(path);
+    if (!mapping.has_value())
+    {
+        return {};
+    }
+    mapping->advise(pattern);
+    return vengine::ram_file(std::move(mapping.value()));
 }
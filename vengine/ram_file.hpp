@@ -5,18 +5,26 @@
 #ifndef GAME_PROJ_RAM_FILE_HPP
 #define GAME_PROJ_RAM_FILE_HPP
 
+#include "mapped_file.hpp"
+
 #include <cstdint>
 #include <vector>
 #include <filesystem>
 #include <optional>
+#include <memory>
 
 namespace vengine
 {
+    /**
+     * Read-only file contents, either owned in memory or backed by a mapped_file.
+     * Copies of a mapped ram_file share the mapping.
+     */
     class ram_file
     {
     public:
     private:
         std::vector<uint8_t> m_data;
+        std::shared_ptr<const mapped_file> m_mapping;
     public:
         template<typename T>
         [[maybe_unused]] ram_file(T begin, T end)
@@ -25,15 +33,29 @@ namespace vengine
             m_data.resize(size);
             std::copy(begin, end, m_data.begin());
         }
-        [[maybe_unused]] [[nodiscard]] const uint8_t* data() const { return m_data.data(); }
-        [[maybe_unused]] [[nodiscard]] size_t size() const { return m_data.size(); }
+        [[maybe_unused]] explicit ram_file(std::vector<uint8_t>&& data) : m_data(std::move(data)) {}
+        [[maybe_unused]] explicit ram_file(mapped_file&& mapping) : m_mapping(std::make_shared<const mapped_file>(std::move(mapping))) {}
+        [[maybe_unused]] [[nodiscard]] const uint8_t* data() const { return m_mapping ? m_mapping->data() : m_data.data(); }
+        [[maybe_unused]] [[nodiscard]] size_t size() const { return m_mapping ? m_mapping->size() : m_data.size(); }
+        [[maybe_unused]] [[nodiscard]] bool mapped() const { return m_mapping != nullptr; }
 
 
-        [[maybe_unused]] [[nodiscard]] const uint8_t* begin() const { return m_data.data(); }
-        [[maybe_unused]] [[nodiscard]] const uint8_t* end() const { return m_data.data() + m_data.size(); }
+        [[maybe_unused]] [[nodiscard]] const uint8_t* begin() const { return data(); }
+        [[maybe_unused]] [[nodiscard]] const uint8_t* end() const { return data() + size(); }
 
 
+        /**
+         * Reads the whole file into memory.
+         */
         [[maybe_unused]] static std::optional<vengine::ram_file> from_disk(const std::filesystem::path& path);
+        /**
+         * Maps the file instead of reading it, pages are loaded on first access.
+         * Preferable for large assets that are parsed or uploaded once.
+         *
+         * @param pattern How the contents are going to be read, see mapped_file::advise.
+         */
+        [[maybe_unused]] static std::optional<vengine::ram_file> map_from_disk(const std::filesystem::path& path,
+                                                                               mapped_file::access_pattern pattern = mapped_file::access_pattern::sequential);
     };
 }
 
@@ -0,0 +1,119 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_RING_ALLOCATOR_HPP
+#define GAME_PROJ_RING_ALLOCATOR_HPP
+
+#include "allocated_buffer.hpp"
+#include "log.hpp"
+
+#include <span>
+#include <optional>
+#include <cstdint>
+
+namespace vengine
+{
+    template<typename T>
+    struct ring_allocation
+    {
+        std::span<T> data;
+        // Index of data.front() inside of the buffer (eg. to be used as firstInstance)
+        uint32_t index;
+        // Byte offset of data.front() inside of the buffer (eg. to be used as dynamic offset)
+        size_t offset;
+    };
+
+    /**
+     * Typed linear allocator on top of a persistently mapped allocated_buffer.
+     *
+     * Every frame_data owns one of these per dynamic buffer. As the frame_data
+     * structures are cycled through in ring order, and the allocator is only reset once
+     * the GPU is done with the frame, writes never race with the GPU reading them.
+     *
+     * Allocations hand out spans directly into mapped memory; no map calls happen.
+     */
+    template<typename T>
+    class ring_allocator
+    {
+        allocated_buffer m_buffer;
+        size_t m_capacity;
+        size_t m_head;
+        // Set once an allocation failed, the warning is logged only once per frame
+        bool m_exhausted;
+    public:
+        ring_allocator() : m_buffer(), m_capacity(0), m_head(0), m_exhausted(false) {}
+        explicit ring_allocator(allocated_buffer buffer)
+                : m_buffer(buffer), m_capacity(buffer.size / sizeof(T)), m_head(0), m_exhausted(false)
+        {
+            if (!buffer.persistently_mapped())
+            {
+                log::error("vengine::ring_allocator::ring_allocator(allocated_buffer)", "Buffer passed is not persistently mapped.");
+                m_capacity = 0;
+            }
+        }
+
+        /**
+         * Allocates count consecutive elements.
+         *
+         * @returns The allocation or an empty optional if the buffer is exhausted for this frame.
+         *          Only the first failure until reset() is logged.
+         */
+        [[nodiscard]] std::optional<ring_allocation<T>> allocate(size_t count = 1)
+        {
+            if (m_head + count > m_capacity)
+            {
+                if (!m_exhausted)
+                {
+                    m_exhausted = true;
+                    log::warning("vengine::ring_allocator::allocate(size_t)", "Ring allocator is exhausted for this frame.");
+                }
+                return { };
+            }
+            auto begin = m_buffer.mapped_as<T>() + m_head;
+            ring_allocation<T> allocation{ std::span<T>{ begin, count }, (uint32_t)m_head, m_head * sizeof(T) };
+            m_head += count;
+            return allocation;
+        }
+
+        /**
+         * Writes value into the next free slot.
+         *
+         * @returns The index of the slot written or an empty optional if the buffer is exhausted for this frame.
+         */
+        [[nodiscard]] std::optional<uint32_t> push(const T& value)
+        {
+            auto allocation = allocate(1);
+            if (!allocation.has_value())
+            {
+                return { };
+            }
+            allocation->data.front() = value;
+            return allocation->index;
+        }
+
+        /**
+         * Makes everything allocated this frame visible to the device.
+         */
+        vulkan_utils::result<void> flush() const
+        {
+            if (m_head == 0)
+            {
+                return {};
+            }
+            return m_buffer.flush(0, m_head * sizeof(T));
+        }
+
+        void reset()
+        {
+            m_head = 0;
+            m_exhausted = false;
+        }
+
+        [[nodiscard]] size_t size() const { return m_head; }
+        [[nodiscard]] size_t capacity() const { return m_capacity; }
+        [[nodiscard]] const allocated_buffer& buffer() const { return m_buffer; }
+    };
+}
+
+#endif //GAME_PROJ_RING_ALLOCATOR_HPP
@@ -14,16 +14,20 @@ namespace vengine
     {
         vengine &m_engine;
         vengine::on_render_pass_event::event_id m_on_render_pass_event_id;
+        vengine::on_before_render_pass_event::event_id m_on_before_render_pass_event_id;
         entt::registry m_ecs{};
     protected:
         virtual void render_pass(::vengine::vengine::on_render_pass_event_args &args) = 0;
 
+        virtual void before_render_pass(::vengine::vengine::on_before_render_pass_event_args &args) { }
+
         virtual void load_scene() = 0;
 
         virtual void unload_scene() = 0;
 
     public:
-        explicit scene(vengine &engine) : m_engine(engine), m_on_render_pass_event_id(vengine::on_render_pass_event::event_id_invalid)
+        explicit scene(vengine &engine) : m_engine(engine), m_on_render_pass_event_id(vengine::on_render_pass_event::event_id_invalid),
+                                            m_on_before_render_pass_event_id(vengine::on_before_render_pass_event::event_id_invalid)
         {
 
         }
@@ -37,6 +41,11 @@ namespace vengine
 
         void load()
         {
+            m_on_before_render_pass_event_id = m_engine.on_before_render_pass.subscribe(
+                    [&](auto &sender, auto &args)
+                    {
+                        before_render_pass(args);
+                    });
             m_on_render_pass_event_id = m_engine.on_render_pass.subscribe(
                     [&](auto &sender, auto &args)
                     {
@@ -49,6 +58,10 @@ namespace vengine
         {
             engine().on_render_pass.unsubscribe(m_on_render_pass_event_id);
             m_on_render_pass_event_id = vengine::on_render_pass_event::event_id_invalid;
+            engine().on_before_render_pass.unsubscribe(m_on_before_render_pass_event_id);
+            m_on_before_render_pass_event_id = vengine::on_before_render_pass_event::event_id_invalid;
+            // Frames still in flight may reference scene resources
+            engine().wait_idle();
             unload_scene();
         }
 
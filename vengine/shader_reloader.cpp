@@ -0,0 +1,265 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "shader_reloader.hpp"
+#include "vengine.hpp"
+#include "log.hpp"
+#include "ram_file.hpp"
+#include "vulkan-utils/stringify.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <system_error>
+
+namespace
+{
+    std::filesystem::path canonical_or_self(const std::filesystem::path& path)
+    {
+        std::error_code error_code;
+        auto canonical = std::filesystem::weakly_canonical(path, error_code);
+        return error_code ? path : canonical;
+    }
+}
+
+vengine::vulkan_utils::result<VkShaderModule> vengine::shader_reloader::create_module(const std::filesystem::path& path) const
+{
+    const char* source = "vengine::shader_reloader::create_module(const std::filesystem::path&)";
+    auto file = ram_file::from_disk(path);
+    if (!file.has_value() || file->size() == 0 || file->size() % sizeof(uint32_t) != 0)
+    {
+        auto message = std::string("Failed to read SPIR-V from ").append(path.string()).append(".");
+        log::error(source, message);
+        return { VK_ERROR_INITIALIZATION_FAILED, message };
+    }
+
+    VkShaderModuleCreateInfo create_info = { };
+    create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    create_info.pNext = nullptr;
+    create_info.codeSize = file->size();
+    create_info.pCode = reinterpret_cast<const uint32_t*>(file->data());
+
+    VkShaderModule module;
+    auto create_result = vkCreateShaderModule(m_engine.vulkan_device(), &create_info, nullptr, &module);
+    if (create_result != VK_SUCCESS)
+    {
+        auto message = std::string("Failed to create shader module from ").append(path.string()).append(" (")
+                .append(vulkan_utils::stringify::data(create_result)).append(").");
+        log::error(source, message);
+        return { create_result, message };
+    }
+    return { module };
+}
+
+vengine::vulkan_utils::result<vengine::shader_reloader::shader_handle>
+vengine::shader_reloader::add_shader(const std::filesystem::path& path)
+{
+    auto module_result = create_module(path);
+    if (!module_result.good())
+    {
+        return { module_result.vk_result(), std::string(module_result.message()) };
+    }
+    auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    if (!m_watcher.watch(directory))
+    {
+        log::warning("vengine::shader_reloader::add_shader(const std::filesystem::path&)",
+                     std::string("Failed to watch ").append(directory.string()).append(", ").append(path.string())
+                             .append(" will not be reloaded."));
+    }
+    m_shaders.push_back({ path, canonical_or_self(path), module_result.value() });
+    return { shader_handle { (uint32_t)m_shaders.size() - 1 } };
+}
+
+vengine::vulkan_utils::result<vengine::shader_reloader::pipeline_handle>
+vengine::shader_reloader::add_pipeline(std::span<const shader_handle> shaders, pipeline_factory factory)
+{
+    reloadable_pipeline added { };
+    std::vector<VkShaderModule> modules;
+    for (auto shader : shaders)
+    {
+        added.shaders.push_back(shader.index);
+        modules.push_back(m_shaders[shader.index].module);
+    }
+    auto pipeline_result = factory(modules);
+    if (!pipeline_result.good())
+    {
+        log::error("vengine::shader_reloader::add_pipeline(std::span<const shader_handle>, pipeline_factory)",
+                   std::string("Failed to create pipeline (").append(pipeline_result.message()).append(")."));
+        return { pipeline_result.vk_result(), std::string(pipeline_result.message()) };
+    }
+    added.factory = std::move(factory);
+    added.handle = pipeline_result.value();
+    m_pipelines.push_back(std::move(added));
+    return { pipeline_handle { (uint32_t)m_pipelines.size() - 1 } };
+}
+
+vengine::shader_reloader::rebuild vengine::shader_reloader::run_rebuild(const rebuild_job& job) const
+{
+    rebuild rebuilt { };
+    rebuilt.good = true;
+    for (auto& [index, path] : job.shaders)
+    {
+        auto module_result = create_module(path);
+        if (!module_result.good())
+        {
+            rebuilt.good = false;
+            return rebuilt;
+        }
+        rebuilt.modules.emplace_back(index, module_result.value());
+    }
+    for (auto& pipeline_job : job.pipelines)
+    {
+        auto modules = pipeline_job.modules;
+        for (size_t i = 0; i < modules.size(); i++)
+        {
+            for (auto& [index, module] : rebuilt.modules)
+            {
+                if (pipeline_job.shaders[i] == index)
+                {
+                    modules[i] = module;
+                }
+            }
+        }
+        auto pipeline_result = pipeline_job.factory(modules);
+        if (!pipeline_result.good())
+        {
+            log::error("vengine::shader_reloader::run_rebuild(const rebuild_job&)",
+                       std::string("Failed to rebuild pipeline (").append(pipeline_result.message()).append(")."));
+            rebuilt.good = false;
+            return rebuilt;
+        }
+        rebuilt.pipelines.emplace_back(pipeline_job.index, pipeline_result.value());
+    }
+    return rebuilt;
+}
+
+void vengine::shader_reloader::apply(const rebuild& rebuilt)
+{
+    // Pipelines keep their own copy of the code, old modules are not needed by any frame
+    for (auto& [index, module] : rebuilt.modules)
+    {
+        vkDestroyShaderModule(m_engine.vulkan_device(), m_shaders[index].module, nullptr);
+        m_shaders[index].module = module;
+    }
+    for (auto& [index, pipeline] : rebuilt.pipelines)
+    {
+        m_retired.push_back({ m_pipelines[index].handle, m_engine.frame_count() });
+        m_pipelines[index].handle = pipeline;
+    }
+}
+
+void vengine::shader_reloader::discard(const rebuild& rebuilt)
+{
+    for (auto& [index, module] : rebuilt.modules)
+    {
+        vkDestroyShaderModule(m_engine.vulkan_device(), module, nullptr);
+    }
+    for (auto& [index, pipeline] : rebuilt.pipelines)
+    {
+        vkDestroyPipeline(m_engine.vulkan_device(), pipeline, nullptr);
+    }
+}
+
+void vengine::shader_reloader::update()
+{
+    const char* source = "vengine::shader_reloader::update()";
+
+    // Same rule as texture_streamer::update, the fence of the frame frames_in_flight frames ago was waited on
+    auto frame = m_engine.frame_count();
+    std::erase_if(m_retired, [&](const retired_pipeline& retired) {
+        if (frame < retired.frame + m_engine.frames_in_flight())
+        {
+            return false;
+        }
+        vkDestroyPipeline(m_engine.vulkan_device(), retired.pipeline, nullptr);
+        return true;
+    });
+
+    if (m_rebuild.valid())
+    {
+        if (m_rebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
+        auto rebuilt = m_rebuild.get();
+        if (rebuilt.good)
+        {
+            log::info(source, std::string("Swapped in ").append(std::to_string(rebuilt.modules.size())).append(" shaders and ")
+                    .append(std::to_string(rebuilt.pipelines.size())).append(" pipelines."));
+            apply(rebuilt);
+        }
+        else
+        {
+            log::warning(source, "Reloading shaders failed, keeping the previous pipelines.");
+            discard(rebuilt);
+        }
+    }
+
+    for (auto& changed : m_watcher.take_changes())
+    {
+        auto canonical = canonical_or_self(changed);
+        for (uint32_t i = 0; i < m_shaders.size(); i++)
+        {
+            if (m_shaders[i].canonical_path == canonical
+                && std::find(m_dirty_shaders.begin(), m_dirty_shaders.end(), i) == m_dirty_shaders.end())
+            {
+                m_dirty_shaders.push_back(i);
+            }
+        }
+    }
+    if (m_dirty_shaders.empty())
+    {
+        return;
+    }
+
+    rebuild_job job { };
+    for (auto index : m_dirty_shaders)
+    {
+        log::info(source, std::string("Reloading ").append(m_shaders[index].path.string()));
+        job.shaders.emplace_back(index, m_shaders[index].path);
+    }
+    for (uint32_t i = 0; i < m_pipelines.size(); i++)
+    {
+        auto& pipeline = m_pipelines[i];
+        auto depends_on_dirty = std::any_of(pipeline.shaders.begin(), pipeline.shaders.end(), [&](uint32_t shader) {
+            return std::find(m_dirty_shaders.begin(), m_dirty_shaders.end(), shader) != m_dirty_shaders.end();
+        });
+        if (!depends_on_dirty)
+        {
+            continue;
+        }
+        rebuild_job::pipeline_job pipeline_job { i, pipeline.shaders, { }, pipeline.factory };
+        for (auto shader : pipeline.shaders)
+        {
+            pipeline_job.modules.push_back(m_shaders[shader].module);
+        }
+        job.pipelines.push_back(std::move(pipeline_job));
+    }
+    m_dirty_shaders.clear();
+    m_rebuild = m_rebuild_pool.submit([this, job = std::move(job)]() { return run_rebuild(job); });
+}
+
+void vengine::shader_reloader::destroy()
+{
+    if (m_rebuild.valid())
+    {
+        discard(m_rebuild.get());
+    }
+    for (auto& retired : m_retired)
+    {
+        vkDestroyPipeline(m_engine.vulkan_device(), retired.pipeline, nullptr);
+    }
+    for (auto& pipeline : m_pipelines)
+    {
+        vkDestroyPipeline(m_engine.vulkan_device(), pipeline.handle, nullptr);
+    }
+    for (auto& shader : m_shaders)
+    {
+        vkDestroyShaderModule(m_engine.vulkan_device(), shader.module, nullptr);
+    }
+    m_retired.clear();
+    m_pipelines.clear();
+    m_shaders.clear();
+    m_dirty_shaders.clear();
+}
@@ -0,0 +1,141 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_SHADER_RELOADER_HPP
+#define GAME_PROJ_SHADER_RELOADER_HPP
+
+#include "file_watcher.hpp"
+#include "worker_pool.hpp"
+#include "vulkan-utils/result.hpp"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace vengine
+{
+    class vengine;
+
+    /**
+     * Owns shader modules and the pipelines built from them, rebuilding both whenever a shader
+     * file changed on disk.
+     *
+     * Changes are picked up by a file_watcher on the directories of the shaders. Reading the
+     * SPIR-V, creating the modules and running the pipeline factories happens on a background
+     * thread, hence the frame never stalls on pipeline compilation. Once every rebuild of a
+     * change finished, update swaps all new modules and pipelines in together at the frame
+     * boundary; if any of them failed, none is swapped and the old ones stay in use.
+     * Replaced modules are destroyed right away, replaced pipelines once no frame in flight may use them anymore.
+     *
+     * Not thread safe, the factories are invoked on the background thread.
+     */
+    class shader_reloader
+    {
+    public:
+        struct shader_handle
+        {
+            uint32_t index;
+        };
+        struct pipeline_handle
+        {
+            uint32_t index;
+        };
+        /**
+         * Builds a pipeline from the modules of the shaders passed to add_pipeline, in the same order.
+         */
+        using pipeline_factory = std::function<vulkan_utils::result<VkPipeline>(std::span<const VkShaderModule> modules)>;
+    private:
+        struct watched_shader
+        {
+            std::filesystem::path path;
+            // weakly_canonical of path, compared against the changes reported
+            std::filesystem::path canonical_path;
+            VkShaderModule module;
+        };
+        struct reloadable_pipeline
+        {
+            std::vector<uint32_t> shaders;
+            pipeline_factory factory;
+            VkPipeline handle;
+        };
+        // Snapshot of everything a rebuild needs, the background thread never touches the members
+        struct rebuild_job
+        {
+            struct pipeline_job
+            {
+                uint32_t index;
+                std::vector<uint32_t> shaders;
+                // Current modules of shaders, replaced by the rebuilt ones
+                std::vector<VkShaderModule> modules;
+                pipeline_factory factory;
+            };
+            std::vector<std::pair<uint32_t, std::filesystem::path>> shaders;
+            std::vector<pipeline_job> pipelines;
+        };
+        struct rebuild
+        {
+            std::vector<std::pair<uint32_t, VkShaderModule>> modules;
+            std::vector<std::pair<uint32_t, VkPipeline>> pipelines;
+            bool good;
+        };
+        struct retired_pipeline
+        {
+            VkPipeline pipeline;
+            size_t frame;
+        };
+
+        ::vengine::vengine& m_engine;
+        std::vector<watched_shader> m_shaders;
+        std::vector<reloadable_pipeline> m_pipelines;
+        std::vector<retired_pipeline> m_retired;
+        // Changed shaders not yet handed to a rebuild
+        std::vector<uint32_t> m_dirty_shaders;
+        file_watcher m_watcher;
+        // Single thread, rebuilds never compete with the frame for the engine worker_pool
+        utils::worker_pool m_rebuild_pool;
+        std::future<rebuild> m_rebuild;
+
+        [[nodiscard]] vulkan_utils::result<VkShaderModule> create_module(const std::filesystem::path& path) const;
+        [[nodiscard]] rebuild run_rebuild(const rebuild_job& job) const;
+        void apply(const rebuild& rebuilt);
+        void discard(const rebuild& rebuilt);
+    public:
+        explicit shader_reloader(::vengine::vengine& engine) : m_engine(engine), m_rebuild_pool(1) {}
+        shader_reloader(const shader_reloader&) = delete;
+        shader_reloader& operator=(const shader_reloader&) = delete;
+        ~shader_reloader() { destroy(); }
+
+        /**
+         * Creates the module from the SPIR-V at path and watches its directory for changes.
+         */
+        [[nodiscard]] vulkan_utils::result<shader_handle> add_shader(const std::filesystem::path& path);
+
+        /**
+         * Builds the pipeline through factory now and again whenever any of shaders changed.
+         */
+        [[nodiscard]] vulkan_utils::result<pipeline_handle> add_pipeline(std::span<const shader_handle> shaders, pipeline_factory factory);
+
+        /**
+         * Swaps in finished rebuilds, destroys objects no frame uses anymore and starts rebuilding
+         * changed shaders. Call once per frame, after the frame fence was waited on and before
+         * the handles are used for recording.
+         */
+        void update();
+
+        /**
+         * Waits for a running rebuild and destroys all modules and pipelines. The GPU must be done with them.
+         */
+        void destroy();
+
+        [[nodiscard]] VkShaderModule module(shader_handle shader) const { return m_shaders[shader.index].module; }
+        [[nodiscard]] VkPipeline pipeline(pipeline_handle pipeline) const { return m_pipelines[pipeline.index].handle; }
+    };
+}
+
+#endif //GAME_PROJ_SHADER_RELOADER_HPP
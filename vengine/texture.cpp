@@ -4,6 +4,8 @@
 
 #include "log.hpp"
 #include "texture.hpp"
+#include "image_utils.hpp"
+#include "ktx2.hpp"
 
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,14 +18,30 @@
 #include "vengine.hpp"
 
 
-#include <tiny_obj_loader.h>
 #include <vulkan/vulkan.h>
+#include <cstring>
+
+namespace
+{
+    bool supports_mip_blits(::vengine::vengine& engine, VkFormat format)
+    {
+        const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT
+                                                   | VK_FORMAT_FEATURE_BLIT_DST_BIT
+                                                   | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (engine.format_properties(format).optimalTilingFeatures & blit_features) == blit_features;
+    }
+}
 
 std::optional<vengine::texture> vengine::texture::from_ram_file(const ram_file &file)
 {
     const char *source = "vengine::texture::from_ram_file(const ram_file&)";
     const size_t rgba_size = 4;
 
+    if (ktx2::is_ktx2({ file.data(), file.size() }))
+    {
+        return from_ktx2(file);
+    }
+
     if (file.size() > INT32_MAX)
     {
         const char *message = "Cannot load ram_file as size exceeded INT32_MAX.";
@@ -46,15 +64,68 @@ std::optional<vengine::texture> vengine::texture::from_ram_file(const ram_file &
     texture result;
     result.width = width;
     result.height = height;
-    result.rgba_data.resize(image_size);
-    result.rgba_data.insert(result.rgba_data.begin(), pixels, pixels + image_size);
+    result.data.assign(pixels, pixels + image_size);
+    stbi_image_free(pixels);
+    return result;
+}
 
+std::optional<vengine::texture> vengine::texture::from_ktx2(const ram_file& file)
+{
+    auto parse_result = ktx2::parse({ file.data(), file.size() });
+    if (!parse_result.has_value())
+    {
+        log::warning("vengine::texture::from_ktx2(const ram_file&)", "Failed to load texture from KTX2 file.");
+        return { };
+    }
+
+    texture result;
+    result.format = parse_result->format;
+    result.width = parse_result->levels.front().width;
+    result.height = parse_result->levels.front().height;
+    // Formats without blit support end up with a single level instead of an incomplete chain
+    bool keep_levels = !parse_result->generate_mip_levels || image_utils::bc_block_size(result.format) != 0;
+    size_t size = 0;
+    for (auto& level : parse_result->levels)
+    {
+        size += level.data.size();
+    }
+    result.data.reserve(size);
+    for (auto& level : parse_result->levels)
+    {
+        if (keep_levels)
+        {
+            result.levels.push_back({ result.data.size(), { level.width, level.height, 1 } });
+        }
+        result.data.insert(result.data.end(), level.data.begin(), level.data.end());
+    }
+    return result;
+}
 
-    return std::optional<texture>();
+vengine::vulkan_utils::result<void> vengine::texture::decode_to_rgba8()
+{
+    auto decoded_format = image_utils::decoded_format(format);
+    size_t decoded_size;
+    auto decoded_levels = image_utils::mip_chain_layout_rgba8((uint32_t)width, (uint32_t)height, (uint32_t)levels.size(), decoded_size);
+    std::vector<uint8_t> decoded(decoded_size);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        auto level_data = std::span<const uint8_t>(data).subspan(levels[i].offset);
+        if (!image_utils::decode_bc_rgba8(format, level_data, levels[i].extent.width, levels[i].extent.height,
+                                          decoded.data() + decoded_levels[i].offset))
+        {
+            auto message = "Texture format is neither supported by the device nor decodable on the CPU.";
+            log::error("vengine::texture::decode_to_rgba8()", message);
+            return { VK_ERROR_FORMAT_NOT_SUPPORTED, message };
+        }
+    }
+    data = std::move(decoded);
+    levels = std::move(decoded_levels);
+    format = decoded_format;
+    return { };
 }
 
 
-vengine::vulkan_utils::result<void>
+vengine::vulkan_utils::result<vengine::upload_manager::upload_token>
 vengine::texture::upload_to_gpu_memory(::vengine::vengine &engine, VmaAllocator allocator)
 {
     const char *source = "vengine::texture::upload_to_gpu_memory(::vengine::vengine, VmaAllocator)";
@@ -62,140 +133,195 @@ vengine::texture::upload_to_gpu_memory(::vengine::vengine &engine, VmaAllocator
     {
         const char *message = "Attempt was made to upload an image twice to the GPU.";
         log::warning(source, message);
-        return { VK_SUCCESS, message };
+        return { upload_manager::upload_token { 0 } };
     }
 
-    auto cpu_writeable_buffer_builder_result = vulkan_utils::buffer_builder(allocator, size()).set_buffer_usage(
-                                                                                                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
-                                                                                              .set_memory_usage(
-                                                                                                      VMA_MEMORY_USAGE_CPU_TO_GPU)
-                                                                                              .build();
-    if (!cpu_writeable_buffer_builder_result.good())
+    if (!levels.empty() && (engine.format_properties(format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+    {
+        auto decode_result = decode_to_rgba8();
+        if (!decode_result.good())
+        {
+            return { decode_result.vk_result(), std::string(decode_result.message()) };
+        }
+    }
+    bool blit_mip_levels = levels.empty() && supports_mip_blits(engine, format);
+    mip_levels = levels.empty() ? image_utils::mip_level_count((uint32_t)width, (uint32_t)height) : (uint32_t)levels.size();
+    if (levels.empty() && !blit_mip_levels)
     {
-        return cpu_writeable_buffer_builder_result;
+        // Level 0 stays in place, the chain is appended
+        size_t chain_size;
+        levels = image_utils::mip_chain_layout_rgba8((uint32_t)width, (uint32_t)height, mip_levels, chain_size);
+        data.resize(chain_size);
+        image_utils::generate_mip_chain_rgba8(data, levels);
     }
-    auto tmp = cpu_writeable_buffer_builder_result.value();
 
-    tmp.with_mapped(
-            [&](auto &span)
-            {
-                memcpy(span.data(), rgba_data.data(), size());
-            });
+    auto create_image_result = create_image(allocator, blit_mip_levels);
+    if (!create_image_result.good())
+    {
+        return { create_image_result.vk_result(), std::string(create_image_result.message()) };
+    }
 
+    // Copy is batched with every other upload issued before the next flush
+    auto upload_result = blit_mip_levels
+                         ? engine.uploads().upload_image(
+                    data,
+                    image_buffer.image,
+                    extent3d(),
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    mip_levels)
+                         : engine.uploads().upload_image_levels(
+                    data,
+                    image_buffer.image,
+                    levels,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    if (!upload_result.good())
+    {
+        image_buffer.destroy();
+        return upload_result;
+    }
+    return upload_result;
+}
 
-    // Create Image
+vengine::vulkan_utils::result<void> vengine::texture::create_image(VmaAllocator allocator, bool blit_mip_levels)
+{
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (blit_mip_levels)
+    {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    auto gpu_image_builder_result = vulkan_utils::image_builder(
+            allocator, extent3d()).set_image_usage(usage)
+                                  .set_format(format)
+                                  .set_mip_level(mip_levels)
+                                  .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                                  .build();
+    if (!gpu_image_builder_result.good())
     {
-        auto gpu_image_builder_result = vulkan_utils::image_builder(
-                allocator, extent3d()).set_image_usage(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT)
-                                      .set_format(VK_FORMAT_R8G8B8A8_SRGB)
-                                      .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
-                                      .build();
-        if (!gpu_image_builder_result.good())
+        return { gpu_image_builder_result.vk_result(), std::string(gpu_image_builder_result.message()) };
+    }
+    image_buffer = gpu_image_builder_result.value();
+    return { };
+}
+
+std::vector<std::optional<std::pair<vengine::texture, vengine::upload_manager::upload_token>>>
+vengine::texture::decode_to_gpu_memory(::vengine::vengine& engine, std::span<const ram_file> files)
+{
+    const char* source = "vengine::texture::decode_to_gpu_memory(::vengine::vengine&, std::span<const ram_file>)";
+    struct decode_job
+    {
+        size_t file_index;
+        std::span<uint8_t> staging;
+        // Of a chain generated on the CPU, empty if the levels are blitted
+        std::vector<upload_manager::image_level> levels;
+    };
+    std::vector<std::optional<std::pair<texture, upload_manager::upload_token>>> results(files.size());
+    std::vector<decode_job> jobs;
+
+    // Staging memory of reserved jobs must be written before anything flushes the uploads
+    auto run_jobs = [&]() {
+        if (jobs.empty())
         {
-            tmp.destroy();
-            return gpu_image_builder_result;
+            return;
         }
-        image_buffer = gpu_image_builder_result.value();
-    }
-    auto execute_result = engine.execute(
-            [&](auto &command_buffer)
+        engine.worker_pool().parallel_for(jobs.size(), [&](size_t index, size_t) {
+            auto& job = jobs[index];
+            auto& file = files[job.file_index];
+            int width, height, texture_channels;
+            stbi_uc* pixels = stbi_load_from_memory(
+                    file.data(), (int32_t)file.size(), &width, &height, &texture_channels, STBI_rgb_alpha);
+            auto level_size = (size_t)width * (size_t)height * 4;
+            if (!pixels || level_size > job.staging.size())
             {
-                {
-                    VkImageSubresourceRange image_subresource_range = { };
-                    image_subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                    image_subresource_range.baseMipLevel = 0;
-                    image_subresource_range.levelCount = 1;
-                    image_subresource_range.baseArrayLayer = 0;
-                    image_subresource_range.layerCount = 1;
-
-                    VkImageMemoryBarrier transfer_image_memory_barrier = { };
-                    transfer_image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-
-                    transfer_image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                    transfer_image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                    transfer_image_memory_barrier.image = image_buffer.image;
-                    transfer_image_memory_barrier.subresourceRange = image_subresource_range;
-
-                    transfer_image_memory_barrier.srcAccessMask = 0;
-                    transfer_image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-                    // Barrier the image into the transfer-receive layout
-                    vkCmdPipelineBarrier(
-                            command_buffer,
-                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            0,
-                            0,
-                            nullptr,
-                            0,
-                            nullptr,
-                            1,
-                            &transfer_image_memory_barrier);
-                }
-                {
-                    VkBufferImageCopy buffer_image_copy = { };
-                    buffer_image_copy.bufferOffset = 0;
-                    buffer_image_copy.bufferRowLength = 0;
-                    buffer_image_copy.bufferImageHeight = 0;
-
-                    buffer_image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                    buffer_image_copy.imageSubresource.mipLevel = 0;
-                    buffer_image_copy.imageSubresource.baseArrayLayer = 0;
-                    buffer_image_copy.imageSubresource.layerCount = 1;
-                    buffer_image_copy.imageExtent = extent3d();
-
-                    // Copy the data inside the buffer into the image
-                    vkCmdCopyBufferToImage(
-                            command_buffer,
-                            tmp.buffer,
-                            image_buffer.image,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            1,
-                            &buffer_image_copy);
-                }
-
-                {
-                    VkImageSubresourceRange image_subresource_range = { };
-                    image_subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                    image_subresource_range.baseMipLevel = 0;
-                    image_subresource_range.levelCount = 1;
-                    image_subresource_range.baseArrayLayer = 0;
-                    image_subresource_range.layerCount = 1;
-
-                    VkImageMemoryBarrier readable_image_memory_barrier = { };
-                    readable_image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-
-                    readable_image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                    readable_image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                    readable_image_memory_barrier.image = image_buffer.image;
-                    readable_image_memory_barrier.subresourceRange = image_subresource_range;
-
-                    readable_image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                    readable_image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                    //barrier the image into the shader readable layout
-                    vkCmdPipelineBarrier(
-                            command_buffer,
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                            0,
-                            0,
-                            nullptr,
-                            0,
-                            nullptr,
-                            1,
-                            &readable_image_memory_barrier);
-                }
-
-            });
-    if (!execute_result.good())
-    {
-        tmp.destroy();
-        image_buffer.destroy();
-        return execute_result;
+                // The copy is queued already, it uploads transparent black instead
+                log::warning(source, "Decoding an image failed after its header was read.");
+                std::memset(job.staging.data(), 0, job.staging.size());
+                stbi_image_free(pixels);
+                return;
+            }
+            std::memcpy(job.staging.data(), pixels, level_size);
+            stbi_image_free(pixels);
+            if (!job.levels.empty())
+            {
+                image_utils::generate_mip_chain_rgba8(job.staging, job.levels);
+            }
+        });
+        jobs.clear();
+    };
+
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        auto& file = files[i];
+        if (ktx2::is_ktx2({ file.data(), file.size() }))
+        {
+            // Nothing to decode, takes the regular path which may flush
+            run_jobs();
+            auto loaded = from_ktx2(file);
+            if (!loaded.has_value())
+            {
+                continue;
+            }
+            auto upload_result = loaded->upload_to_gpu_memory(engine, engine.allocator());
+            if (upload_result.good())
+            {
+                loaded->data.clear();
+                results[i] = std::make_pair(std::move(*loaded), upload_result.value());
+            }
+            continue;
+        }
+
+        int width, height, texture_channels;
+        if (file.size() > INT32_MAX
+            || !stbi_info_from_memory(file.data(), (int32_t)file.size(), &width, &height, &texture_channels))
+        {
+            log::warning(source, "Attempt was made to load a texture from a ram_file but reading the image header failed.");
+            continue;
+        }
+        texture result;
+        result.width = width;
+        result.height = height;
+        result.mip_levels = image_utils::mip_level_count((uint32_t)width, (uint32_t)height);
+        bool blit_mip_levels = supports_mip_blits(engine, result.format);
+        size_t staging_size;
+        auto levels = image_utils::mip_chain_layout_rgba8((uint32_t)width, (uint32_t)height,
+                                                          blit_mip_levels ? 1 : result.mip_levels, staging_size);
+        auto create_image_result = result.create_image(engine.allocator(), blit_mip_levels);
+        if (!create_image_result.good())
+        {
+            continue;
+        }
+
+        auto reserve = [&](bool may_flush) {
+            return engine.uploads().reserve_image_levels(
+                    result.image_buffer.image,
+                    levels,
+                    staging_size,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    result.mip_levels,
+                    may_flush);
+        };
+        auto reserve_result = reserve(jobs.empty());
+        if (!reserve_result && reserve_result.vk_result() == VK_NOT_READY)
+        {
+            // Ring is full, decode what fits so the open batch may be flushed
+            run_jobs();
+            reserve_result = reserve(true);
+        }
+        if (!reserve_result)
+        {
+            result.destroy();
+            continue;
+        }
+        jobs.push_back({ i, reserve_result.value().data, blit_mip_levels ? std::vector<upload_manager::image_level>() : levels });
+        results[i] = std::make_pair(std::move(result), reserve_result.value().token);
     }
-    tmp.destroy();
-    return { };
+    run_jobs();
+    return results;
 }
 
 void vengine::texture::destroy()
@@ -8,12 +8,16 @@
 #include "vulkan-utils/result.hpp"
 #include "allocated_image.hpp"
 #include "ram_file.hpp"
+#include "upload_manager.hpp"
 
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <vector>
 #include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
 #include "vk_mem_alloc.h"
 
 
@@ -22,20 +26,58 @@ namespace vengine
     class vengine;
     struct texture
     {
-        std::vector<uint8_t> rgba_data;
+        // Tightly packed texels of format, level 0 followed by the levels given in levels
+        std::vector<uint8_t> data;
+        VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+        // Prebaked mip levels inside of data, empty if data only holds level 0 and the chain is generated on upload
+        std::vector<upload_manager::image_level> levels;
         size_t width;
         size_t height;
+        // Of image_buffer, set once it is created
+        uint32_t mip_levels = 1;
 
         allocated_image image_buffer;
 
         texture() = default;
+        /**
+         * Loads KTX2 files through from_ktx2, anything else is decoded to RGBA8 by stb_image.
+         */
         [[nodiscard]] static std::optional<texture> from_ram_file(const ram_file& file);
+        /**
+         * Keeps the block compressed data and prebaked levels of a KTX2 file as they are.
+         */
+        [[nodiscard]] static std::optional<texture> from_ktx2(const ram_file& file);
 
-        [[nodiscard]] vulkan_utils::result<void> upload_to_cpu_writable_gpu_memory(VmaAllocator allocator);
-        [[nodiscard]] vulkan_utils::result<void> upload_to_gpu_memory(::vengine::vengine& engine, VmaAllocator allocator);
+        /**
+         * Replaces the block compressed data and levels with their RGBA8 decoding.
+         */
+        [[nodiscard]] vulkan_utils::result<void> decode_to_rgba8();
+
+        /**
+         * Loads all files straight into GPU memory, decoding them in parallel on engine.worker_pool().
+         * Texels are decoded right into reserved staging memory, a mip chain generated on the CPU included,
+         * hence the returned textures hold no data. KTX2 files take the upload_to_gpu_memory path.
+         *
+         * @returns One entry per file, empty if it could not be loaded. A texture may be sampled once its token completed.
+         */
+        [[nodiscard]] static std::vector<std::optional<std::pair<texture, upload_manager::upload_token>>>
+        decode_to_gpu_memory(::vengine::vengine& engine, std::span<const ram_file> files);
+
+        /**
+         * Creates the device local image with a full mip chain and queues the copy on engine.uploads().
+         * The texture may be sampled once the returned token completed.
+         *
+         * Without prebaked levels, the chain is blitted on the GPU if the format supports it, else generated on the CPU
+         * before the copy. Block compressed formats the device cannot sample are decoded to RGBA8 first.
+         */
+        [[nodiscard]] vulkan_utils::result<upload_manager::upload_token> upload_to_gpu_memory(::vengine::vengine& engine, VmaAllocator allocator);
+        /**
+         * Creates image_buffer with mip_levels levels of format.
+         */
+        [[nodiscard]] vulkan_utils::result<void> create_image(VmaAllocator allocator, bool blit_mip_levels);
         [[nodiscard]] bool uploaded() const { return image_buffer.uploaded(); }
         void destroy();
-        [[nodiscard]] size_t size() const { return rgba_data.size(); }
+        [[nodiscard]] size_t size() const { return data.size(); }
         [[nodiscard]] VkExtent3D extent3d() const {
             VkExtent3D data;
             data.width = static_cast<uint32_t>(width);
@@ -0,0 +1,444 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "texture_streamer.hpp"
+#include "image_utils.hpp"
+#include "ktx2.hpp"
+#include "log.hpp"
+#include "vengine.hpp"
+#include "vulkan-utils/image_builder.hpp"
+#include "vulkan-utils/image_view_builder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+vengine::vulkan_utils::result<vengine::texture_streamer::handle> vengine::texture_streamer::add(const std::filesystem::path& path)
+{
+    const char* source = "vengine::texture_streamer::add(const std::filesystem::path&)";
+    auto file = ram_file::map_from_disk(path, mapped_file::access_pattern::random);
+    if (!file.has_value())
+    {
+        auto message = "Failed to map texture file.";
+        log::error(source, message);
+        return { message };
+    }
+    auto parse_result = ktx2::parse({ file->data(), file->size() });
+    if (!parse_result.has_value())
+    {
+        auto message = "Failed to parse KTX2 file.";
+        log::error(source, message);
+        return { message };
+    }
+
+    // Generated chains and decoded levels live in memory instead of the mapping
+    auto features = m_engine.format_properties(parse_result->format).optimalTilingFeatures;
+    if (parse_result->generate_mip_levels || (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+    {
+        auto loaded = texture::from_ktx2(*file);
+        if (!loaded.has_value())
+        {
+            auto message = "Failed to load KTX2 file.";
+            log::error(source, message);
+            return { message };
+        }
+        return add(std::move(*loaded));
+    }
+
+    streamed_texture streamed { };
+    streamed.format = parse_result->format;
+    for (auto& level : parse_result->levels)
+    {
+        streamed.levels.push_back({ level.data, level.width, level.height });
+    }
+    // Moving keeps the mapping and hence the level spans valid
+    streamed.file = std::move(file);
+    return add(std::move(streamed));
+}
+
+vengine::vulkan_utils::result<vengine::texture_streamer::handle> vengine::texture_streamer::add(texture&& source)
+{
+    if (source.levels.empty())
+    {
+        size_t chain_size;
+        auto mip_levels = image_utils::mip_level_count((uint32_t)source.width, (uint32_t)source.height);
+        source.levels = image_utils::mip_chain_layout_rgba8((uint32_t)source.width, (uint32_t)source.height, mip_levels, chain_size);
+        source.data.resize(chain_size);
+        image_utils::generate_mip_chain_rgba8(source.data, source.levels);
+    }
+    if ((m_engine.format_properties(source.format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+    {
+        auto decode_result = source.decode_to_rgba8();
+        if (!decode_result.good())
+        {
+            return { decode_result.vk_result(), std::string(decode_result.message()) };
+        }
+    }
+
+    streamed_texture streamed { };
+    streamed.format = source.format;
+    streamed.data = std::move(source.data);
+    for (auto& level : source.levels)
+    {
+        auto size = image_utils::level_size(streamed.format, level.extent.width, level.extent.height);
+        streamed.levels.push_back({ std::span<const uint8_t>(streamed.data).subspan(level.offset, size), level.extent.width, level.extent.height });
+    }
+    return add(std::move(streamed));
+}
+
+vengine::vulkan_utils::result<vengine::texture_streamer::handle> vengine::texture_streamer::add(streamed_texture&& streamed)
+{
+    streamed.tail_level = (uint32_t)streamed.levels.size() - 1;
+    for (uint32_t level = 0; level < streamed.levels.size(); level++)
+    {
+        if (std::max(streamed.levels[level].width, streamed.levels[level].height) <= resident_size)
+        {
+            streamed.tail_level = level;
+            break;
+        }
+    }
+    streamed.alive = true;
+
+    uint32_t index;
+    if (m_free_indices.empty())
+    {
+        index = (uint32_t)m_textures.size();
+        m_textures.push_back(std::move(streamed));
+    }
+    else
+    {
+        index = m_free_indices.back();
+        m_free_indices.pop_back();
+        m_textures[index] = std::move(streamed);
+    }
+
+    // The tail goes up right away, everything above it once requested
+    auto& added = m_textures[index];
+    auto stream_result = stream(added, added.tail_level);
+    if (!stream_result.good())
+    {
+        added = { };
+        m_free_indices.push_back(index);
+        return { stream_result.vk_result(), std::string(stream_result.message()) };
+    }
+    return { handle { index } };
+}
+
+void vengine::texture_streamer::remove(handle texture)
+{
+    auto& streamed = m_textures[texture.index];
+    if (streamed.resident.has_value())
+    {
+        retire(*streamed.resident);
+        streamed.resident.reset();
+    }
+    streamed.alive = false;
+    // A pending upload still references its image, the slot is freed once it landed (see update)
+    if (!streamed.pending.has_value())
+    {
+        streamed = { };
+        m_free_indices.push_back(texture.index);
+    }
+}
+
+void vengine::texture_streamer::request(handle texture, float screen_size)
+{
+    auto& streamed = m_textures[texture.index];
+    streamed.screen_size = std::max(streamed.screen_size, screen_size);
+}
+
+VkDeviceSize vengine::texture_streamer::residency_size(const streamed_texture& streamed, uint32_t first_level) const
+{
+    VkDeviceSize size = 0;
+    for (auto level = first_level; level < streamed.levels.size(); level++)
+    {
+        size += image_utils::level_size(streamed.format, streamed.levels[level].width, streamed.levels[level].height);
+    }
+    return size;
+}
+
+VkDeviceSize vengine::texture_streamer::query_budget() const
+{
+    if (m_budget != 0)
+    {
+        return m_budget;
+    }
+    // Without VK_EXT_memory_budget, VMA estimates the budget from the heap sizes
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetBudget(m_engine.allocator(), budgets);
+    const VkPhysicalDeviceMemoryProperties* memory_properties;
+    vmaGetMemoryProperties(m_engine.allocator(), &memory_properties);
+    VkDeviceSize device_budget = 0;
+    for (uint32_t heap = 0; heap < memory_properties->memoryHeapCount; heap++)
+    {
+        if (memory_properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            device_budget += budgets[heap].budget;
+        }
+    }
+    return (VkDeviceSize)((double)device_budget * m_budget_fraction);
+}
+
+vengine::vulkan_utils::result<void> vengine::texture_streamer::stream(streamed_texture& streamed, uint32_t first_level)
+{
+    // The levels are adjacent in their source but not necessarily ordered (KTX2 stores the smallest first)
+    auto begin = streamed.levels[first_level].data.data();
+    auto end = begin + streamed.levels[first_level].data.size();
+    for (auto level = first_level; level < streamed.levels.size(); level++)
+    {
+        begin = std::min(begin, streamed.levels[level].data.data());
+        end = std::max(end, streamed.levels[level].data.data() + streamed.levels[level].data.size());
+    }
+    std::vector<upload_manager::image_level> levels;
+    levels.reserve(streamed.levels.size() - first_level);
+    for (auto level = first_level; level < streamed.levels.size(); level++)
+    {
+        auto& source_level = streamed.levels[level];
+        levels.push_back({ (VkDeviceSize)(source_level.data.data() - begin), { source_level.width, source_level.height, 1 } });
+    }
+
+    residency residency { };
+    residency.first_level = first_level;
+    residency.size = residency_size(streamed, first_level);
+    {
+        auto image_builder_result = vulkan_utils::image_builder(m_engine.allocator(), levels.front().extent)
+                .set_image_usage(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+                .set_format(streamed.format)
+                .set_mip_level(levels.size())
+                .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                .build();
+        if (!image_builder_result.good())
+        {
+            return { image_builder_result.vk_result(), std::string(image_builder_result.message()) };
+        }
+        residency.image = image_builder_result.value();
+    }
+    {
+        auto image_view_builder_result = vulkan_utils::image_view_builder(m_engine.vulkan_device(), residency.image.image)
+                .set_format(streamed.format)
+                .set_mip_level(levels.size())
+                .set_image_aspect(VK_IMAGE_ASPECT_COLOR_BIT)
+                .set_image_usage(VK_IMAGE_USAGE_SAMPLED_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                .build();
+        if (!image_view_builder_result.good())
+        {
+            residency.image.destroy();
+            return { image_view_builder_result.vk_result(), std::string(image_view_builder_result.message()) };
+        }
+        residency.view = image_view_builder_result.value();
+    }
+
+    auto upload_result = m_engine.uploads().upload_image_levels(
+            { begin, (size_t)(end - begin) },
+            residency.image.image,
+            levels,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    if (!upload_result.good())
+    {
+        destroy(residency);
+        return { upload_result.vk_result(), std::string(upload_result.message()) };
+    }
+    streamed.pending = residency;
+    streamed.pending_token = upload_result.value();
+    return { };
+}
+
+void vengine::texture_streamer::retire(residency& residency)
+{
+    m_retired.push_back({ residency, m_engine.frame_count() });
+}
+
+void vengine::texture_streamer::destroy(residency& residency)
+{
+    vkDestroyImageView(m_engine.vulkan_device(), residency.view, nullptr);
+    residency.image.destroy();
+}
+
+vengine::vulkan_utils::result<void> vengine::texture_streamer::update()
+{
+    // update runs after render waited for the frame frames_in_flight frames ago, which covers every
+    // frame up to and including the one an image was retired in
+    auto frame = m_engine.frame_count();
+    std::erase_if(m_retired, [&](retired_residency& retired) {
+        if (frame < retired.frame + m_engine.frames_in_flight())
+        {
+            return false;
+        }
+        destroy(retired.image);
+        return true;
+    });
+
+    for (uint32_t index = 0; index < m_textures.size(); index++)
+    {
+        auto& streamed = m_textures[index];
+        if (!streamed.pending.has_value() || !m_engine.uploads().completed(streamed.pending_token))
+        {
+            continue;
+        }
+        if (!streamed.alive)
+        {
+            retire(*streamed.pending);
+            streamed = { };
+            m_free_indices.push_back(index);
+            continue;
+        }
+        if (streamed.resident.has_value())
+        {
+            retire(*streamed.resident);
+        }
+        streamed.resident = streamed.pending;
+        streamed.pending.reset();
+        streamed.generation++;
+    }
+
+    // Pick the level shown at about one texel per pixel
+    m_current_budget = query_budget();
+    std::vector<uint32_t> wanted_levels(m_textures.size(), 0);
+    VkDeviceSize wanted_bytes = 0;
+    for (uint32_t index = 0; index < m_textures.size(); index++)
+    {
+        auto& streamed = m_textures[index];
+        if (!streamed.alive)
+        {
+            continue;
+        }
+        auto wanted_level = streamed.tail_level;
+        if (streamed.screen_size > 0)
+        {
+            auto ratio = (float)std::max(streamed.levels.front().width, streamed.levels.front().height) / streamed.screen_size;
+            wanted_level = std::min(ratio > 1 ? (uint32_t)std::floor(std::log2(ratio)) : 0, streamed.tail_level);
+        }
+        wanted_levels[index] = wanted_level;
+        wanted_bytes += residency_size(streamed, wanted_level);
+    }
+
+    // Over budget, drop the largest wanted levels first as each saves three quarters of its residency
+    if (wanted_bytes > m_current_budget)
+    {
+        std::priority_queue<std::pair<VkDeviceSize, uint32_t>> largest;
+        for (uint32_t index = 0; index < m_textures.size(); index++)
+        {
+            auto& streamed = m_textures[index];
+            if (streamed.alive && wanted_levels[index] < streamed.tail_level)
+            {
+                largest.emplace(residency_size(streamed, wanted_levels[index]), index);
+            }
+        }
+        while (wanted_bytes > m_current_budget && !largest.empty())
+        {
+            auto [size, index] = largest.top();
+            largest.pop();
+            auto& streamed = m_textures[index];
+            auto coarser_size = residency_size(streamed, ++wanted_levels[index]);
+            wanted_bytes -= size - coarser_size;
+            if (wanted_levels[index] < streamed.tail_level)
+            {
+                largest.emplace(coarser_size, index);
+            }
+        }
+    }
+
+    // Coarsening frees memory and is done right away, refinements start with the largest on screen
+    std::vector<uint32_t> refinements;
+    for (uint32_t index = 0; index < m_textures.size(); index++)
+    {
+        auto& streamed = m_textures[index];
+        if (!streamed.alive || streamed.pending.has_value() || !streamed.resident.has_value())
+        {
+            continue;
+        }
+        if (wanted_levels[index] > streamed.resident->first_level)
+        {
+            auto stream_result = stream(streamed, wanted_levels[index]);
+            if (!stream_result.good())
+            {
+                return stream_result;
+            }
+        }
+        else if (wanted_levels[index] < streamed.resident->first_level)
+        {
+            refinements.push_back(index);
+        }
+    }
+    std::sort(refinements.begin(), refinements.end(), [&](uint32_t left, uint32_t right) {
+        return m_textures[left].screen_size > m_textures[right].screen_size;
+    });
+    VkDeviceSize upload_bytes = 0;
+    for (auto index : refinements)
+    {
+        if (upload_bytes >= m_upload_bytes_per_frame)
+        {
+            break;
+        }
+        auto& streamed = m_textures[index];
+        auto stream_result = stream(streamed, wanted_levels[index]);
+        if (!stream_result.good())
+        {
+            return stream_result;
+        }
+        upload_bytes += streamed.pending->size;
+    }
+
+    for (auto& streamed : m_textures)
+    {
+        streamed.screen_size = 0;
+    }
+    return { };
+}
+
+void vengine::texture_streamer::destroy()
+{
+    for (auto& streamed : m_textures)
+    {
+        if (streamed.resident.has_value())
+        {
+            destroy(*streamed.resident);
+        }
+        if (streamed.pending.has_value())
+        {
+            destroy(*streamed.pending);
+        }
+    }
+    for (auto& retired : m_retired)
+    {
+        destroy(retired.image);
+    }
+    m_textures.clear();
+    m_free_indices.clear();
+    m_retired.clear();
+}
+
+VkImageView vengine::texture_streamer::view(handle texture) const
+{
+    auto& streamed = m_textures[texture.index];
+    return streamed.resident.has_value() ? streamed.resident->view : VK_NULL_HANDLE;
+}
+
+uint32_t vengine::texture_streamer::resident_level(handle texture) const
+{
+    auto& streamed = m_textures[texture.index];
+    return streamed.resident.has_value() ? streamed.resident->first_level : (uint32_t)streamed.levels.size();
+}
+
+vengine::texture_streamer::statistics vengine::texture_streamer::stats() const
+{
+    statistics result { m_current_budget, 0, 0 };
+    for (auto& streamed : m_textures)
+    {
+        if (streamed.resident.has_value())
+        {
+            result.resident_bytes += streamed.resident->size;
+        }
+        if (streamed.pending.has_value())
+        {
+            result.resident_bytes += streamed.pending->size;
+            result.pending_uploads++;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,184 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_TEXTURE_STREAMER_HPP
+#define GAME_PROJ_TEXTURE_STREAMER_HPP
+
+#include "allocated_image.hpp"
+#include "ram_file.hpp"
+#include "texture.hpp"
+#include "upload_manager.hpp"
+#include "vulkan-utils/result.hpp"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace vengine
+{
+    class vengine;
+
+    /**
+     * Keeps only the mip levels of textures resident which are actually needed on screen.
+     *
+     * Every texture starts out with its small tail levels (see resident_size) and is refined
+     * once request reported it to be drawn larger. Each residency is an image of its own
+     * holding the levels from its first level down to 1x1, hence changing the residency
+     * recreates the image, re-uploads the smaller levels and bumps generation so descriptors
+     * referring to view can be rewritten. Samplers keep working unchanged as level 0 of the
+     * view always is the most detailed resident level.
+     *
+     * If the levels wanted exceed the budget, the largest levels are dropped first.
+     * Level data is read from the source on each upload, KTX2 files are mapped rather than read.
+     *
+     * Not thread safe.
+     */
+    class texture_streamer
+    {
+    public:
+        struct handle
+        {
+            uint32_t index;
+        };
+        struct statistics
+        {
+            VkDeviceSize budget;
+            // Of all residencies, including those still uploading
+            VkDeviceSize resident_bytes;
+            size_t pending_uploads;
+        };
+        // Levels with a width and height up to this many texels are always resident
+        static const uint32_t resident_size = 64;
+    private:
+        struct source_level
+        {
+            std::span<const uint8_t> data;
+            uint32_t width;
+            uint32_t height;
+        };
+        // An image holding the levels first_level to levels.size() - 1 of a texture
+        struct residency
+        {
+            allocated_image image;
+            VkImageView view;
+            uint32_t first_level;
+            VkDeviceSize size;
+        };
+        struct streamed_texture
+        {
+            // Either of both backs levels
+            std::optional<ram_file> file;
+            std::vector<uint8_t> data;
+            VkFormat format;
+            std::vector<source_level> levels;
+            // First level of the tail which stays resident
+            uint32_t tail_level;
+
+            std::optional<residency> resident;
+            std::optional<residency> pending;
+            upload_manager::upload_token pending_token;
+            // Largest size requested since the last update, 0 if none
+            float screen_size;
+            uint64_t generation;
+            bool alive;
+        };
+        struct retired_residency
+        {
+            residency image;
+            size_t frame;
+        };
+
+        ::vengine::vengine& m_engine;
+        VkDeviceSize m_budget;
+        float m_budget_fraction;
+        VkDeviceSize m_upload_bytes_per_frame;
+        std::vector<streamed_texture> m_textures;
+        std::vector<uint32_t> m_free_indices;
+        std::vector<retired_residency> m_retired;
+        VkDeviceSize m_current_budget;
+
+        [[nodiscard]] vulkan_utils::result<handle> add(streamed_texture&& streamed);
+        [[nodiscard]] VkDeviceSize residency_size(const streamed_texture& streamed, uint32_t first_level) const;
+        [[nodiscard]] VkDeviceSize query_budget() const;
+        /**
+         * Creates the image for the levels from first_level on and queues their upload as pending residency.
+         */
+        [[nodiscard]] vulkan_utils::result<void> stream(streamed_texture& streamed, uint32_t first_level);
+        void retire(residency& residency);
+        void destroy(residency& residency);
+    public:
+        /**
+         * @param budget Maximum bytes of all resident levels, 0 picks budget_fraction of the
+         *               device local memory budget reported by VMA.
+         * @param budget_fraction Share of the device local memory budget textures may use if budget is 0.
+         * @param upload_bytes_per_frame Refinements started per update stop once they exceed this many bytes.
+         */
+        texture_streamer(::vengine::vengine& engine, VkDeviceSize budget, float budget_fraction, VkDeviceSize upload_bytes_per_frame)
+                : m_engine(engine),
+                m_budget(budget),
+                m_budget_fraction(budget_fraction),
+                m_upload_bytes_per_frame(upload_bytes_per_frame),
+                m_current_budget(0)
+        {
+        }
+        texture_streamer(const texture_streamer&) = delete;
+        texture_streamer& operator=(const texture_streamer&) = delete;
+        ~texture_streamer() { destroy(); }
+
+        /**
+         * Maps the KTX2 file at path and streams its prebaked levels from the mapping.
+         * Formats the device cannot sample are decoded to RGBA8 up front.
+         */
+        [[nodiscard]] vulkan_utils::result<handle> add(const std::filesystem::path& path);
+
+        /**
+         * Streams source, whose data is moved into the streamer.
+         * If source has no prebaked levels, the mip chain is generated on the CPU.
+         */
+        [[nodiscard]] vulkan_utils::result<handle> add(texture&& source);
+
+        /**
+         * Drops the texture, its image is destroyed once the GPU is done with it.
+         */
+        void remove(handle texture);
+
+        /**
+         * Reports texture to be drawn this frame at screen_size pixels (the larger of the
+         * projected width and height). Textures without request fall back to their tail.
+         */
+        void request(handle texture, float screen_size);
+
+        /**
+         * Finishes landed uploads, destroys images the GPU is done with and starts the uploads
+         * of the residencies wanted for the requests since the last update.
+         * Called by vengine::render before the uploads are flushed.
+         */
+        vulkan_utils::result<void> update();
+
+        /**
+         * Destroys all images. The GPU must be done with them.
+         */
+        void destroy();
+
+        /**
+         * @returns The view of the resident levels, VK_NULL_HANDLE until the first upload landed.
+         */
+        [[nodiscard]] VkImageView view(handle texture) const;
+        /**
+         * @returns The level of the source shown as level 0 of view.
+         */
+        [[nodiscard]] uint32_t resident_level(handle texture) const;
+        /**
+         * @returns A counter increased whenever view changed.
+         */
+        [[nodiscard]] uint64_t generation(handle texture) const { return m_textures[texture.index].generation; }
+
+        [[nodiscard]] statistics stats() const;
+    };
+}
+
+#endif //GAME_PROJ_TEXTURE_STREAMER_HPP
@@ -0,0 +1,503 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "upload_manager.hpp"
+#include "vengine.hpp"
+#include "log.hpp"
+#include "vulkan-utils/buffer_builder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    // Offsets handed out by the staging ring are a multiple of this.
+    // Covers the texel block size of every format copied (vkCmdCopyBufferToImage requirement).
+    const uint64_t staging_alignment = 16;
+
+    uint64_t align_up(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * Blits every level of image from the one above, expects all levels in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+     * with level 0 written, and transitions all of them into final_layout.
+     */
+    void record_mip_generation(VkCommandBuffer command_buffer, VkImage image, VkExtent3D extent, uint32_t mip_levels,
+                               VkImageLayout final_layout, VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask)
+    {
+        VkImageMemoryBarrier barrier = { };
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.levelCount = 1;
+
+        auto width = (int32_t)extent.width;
+        auto height = (int32_t)extent.height;
+        for (uint32_t level = 1; level < mip_levels; level++)
+        {
+            // The level above was written by the copy or the previous blit
+            barrier.subresourceRange.baseMipLevel = level - 1;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            auto level_width = std::max(width / 2, 1);
+            auto level_height = std::max(height / 2, 1);
+            VkImageBlit blit = { };
+            blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+            blit.srcOffsets[1] = { width, height, 1 };
+            blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+            blit.dstOffsets[1] = { level_width, level_height, 1 };
+            vkCmdBlitImage(command_buffer,
+                           image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1, &blit, VK_FILTER_LINEAR);
+            width = level_width;
+            height = level_height;
+        }
+
+        // Every level but the last one has been read from
+        std::array<VkImageMemoryBarrier, 2> final_barriers { barrier, barrier };
+        final_barriers[0].subresourceRange.baseMipLevel = 0;
+        final_barriers[0].subresourceRange.levelCount = mip_levels - 1;
+        final_barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        final_barriers[0].newLayout = final_layout;
+        final_barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        final_barriers[0].dstAccessMask = dst_access_mask;
+        final_barriers[1].subresourceRange.baseMipLevel = mip_levels - 1;
+        final_barriers[1].subresourceRange.levelCount = 1;
+        final_barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        final_barriers[1].newLayout = final_layout;
+        final_barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        final_barriers[1].dstAccessMask = dst_access_mask;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage_mask,
+                             0, 0, nullptr, 0, nullptr, (uint32_t)final_barriers.size(), final_barriers.data());
+    }
+}
+
+vengine::vulkan_utils::result<void> vengine::upload_manager::allocate_staging_buffer(size_t size)
+{
+    if (m_staging_buffer.uploaded())
+    {
+        return {};
+    }
+    auto staging_buffer_result = vulkan_utils::buffer_builder(m_engine.allocator(), align_up(size, staging_alignment))
+            .set_buffer_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+            .set_memory_usage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .set_persistently_mapped()
+            .build();
+    if (!staging_buffer_result)
+    {
+        return staging_buffer_result;
+    }
+    m_staging_buffer = staging_buffer_result.value();
+    m_head = 0;
+    m_tail = 0;
+    return {};
+}
+
+void vengine::upload_manager::destroy()
+{
+    if (!m_staging_buffer.uploaded())
+    {
+        return;
+    }
+    // Copy commands referencing the staging buffer must not outlive it
+    auto wait_result = wait_all();
+    if (!wait_result)
+    {
+        m_engine.wait_idle();
+    }
+    for (auto& batch : m_in_flight_batches)
+    {
+        for (auto& buffer : batch.dedicated_staging_buffers)
+        {
+            buffer.destroy();
+        }
+    }
+    m_in_flight_batches.clear();
+    m_unacquired_batches.clear();
+    m_staging_buffer.destroy();
+}
+
+void vengine::upload_manager::reclaim()
+{
+    while (!m_in_flight_batches.empty() && m_engine.transfer_completed(m_in_flight_batches.front().timeline_value))
+    {
+        auto& batch = m_in_flight_batches.front();
+        for (auto& buffer : batch.dedicated_staging_buffers)
+        {
+            buffer.destroy();
+        }
+        m_tail = batch.staging_end;
+        m_completed_batch = batch.batch;
+        m_in_flight_batches.pop_front();
+    }
+}
+
+vengine::vulkan_utils::result<uint8_t*> vengine::upload_manager::reserve(size_t size, bool may_flush, VkBuffer& src, VkDeviceSize& src_offset)
+{
+    auto capacity = (uint64_t)m_staging_buffer.size;
+    auto aligned_size = align_up(size, staging_alignment);
+    if (aligned_size > capacity)
+    {
+        // Would never fit into the ring, the data gets a staging buffer of its own
+        auto dedicated_buffer_result = vulkan_utils::buffer_builder(m_engine.allocator(), size)
+                .set_buffer_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_CPU_ONLY)
+                .set_persistently_mapped()
+                .build();
+        if (!dedicated_buffer_result)
+        {
+            return { dedicated_buffer_result.vk_result(), std::string(dedicated_buffer_result.message()) };
+        }
+        auto dedicated_buffer = dedicated_buffer_result.value();
+        m_dedicated_staging_buffers.push_back(dedicated_buffer);
+        src = dedicated_buffer.buffer;
+        src_offset = 0;
+        return { dedicated_buffer.mapped_as<uint8_t>() };
+    }
+
+    while (true)
+    {
+        reclaim();
+        if (m_head == m_tail && m_in_flight_batches.empty())
+        {
+            // Ring is empty, restart at its beginning to avoid wrapping
+            m_head = 0;
+            m_tail = 0;
+        }
+        auto position = m_head % capacity;
+        auto padding = position + aligned_size > capacity ? capacity - position : 0;
+        if (m_head + padding + aligned_size - m_tail <= capacity)
+        {
+            m_head += padding;
+            src_offset = m_head % capacity;
+            m_head += aligned_size;
+            break;
+        }
+
+        // Ring is full, free up the memory used by the oldest batch
+        if (m_in_flight_batches.empty())
+        {
+            if (!may_flush)
+            {
+                return { VK_NOT_READY, "Staging ring is full and flushing was not allowed." };
+            }
+            auto flush_result = flush();
+            if (!flush_result)
+            {
+                return { flush_result.vk_result(), std::string(flush_result.message()) };
+            }
+            if (m_in_flight_batches.empty())
+            {
+                auto message = "Staging ring is exhausted without any batch to wait for.";
+                log::error("vengine::upload_manager::reserve(size_t, bool, VkBuffer&, VkDeviceSize&)", message);
+                return { message };
+            }
+        }
+        auto wait_result = m_engine.wait_for_transfer(m_in_flight_batches.front().timeline_value);
+        if (!wait_result)
+        {
+            return { wait_result.vk_result(), std::string(wait_result.message()) };
+        }
+    }
+
+    src = m_staging_buffer.buffer;
+    return { m_staging_buffer.mapped_as<uint8_t>() + src_offset };
+}
+
+vengine::vulkan_utils::result<VkBufferCopy> vengine::upload_manager::stage(std::span<const uint8_t> data, VkBuffer& src)
+{
+    VkBufferCopy region = { };
+    region.size = data.size();
+    auto reserve_result = reserve(data.size(), true, src, region.srcOffset);
+    if (!reserve_result)
+    {
+        return { reserve_result.vk_result(), std::string(reserve_result.message()) };
+    }
+    memcpy(reserve_result.value(), data.data(), data.size());
+    return { region };
+}
+
+vengine::vulkan_utils::result<vengine::upload_manager::upload_token>
+vengine::upload_manager::upload_buffer(std::span<const uint8_t> data, VkBuffer dst, VkDeviceSize dst_offset,
+                                       VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask)
+{
+    if (!m_staging_buffer.uploaded())
+    {
+        auto message = "Staging buffer was not allocated.";
+        log::error("vengine::upload_manager::upload_buffer(std::span<const uint8_t>, VkBuffer, VkDeviceSize, VkAccessFlags, VkPipelineStageFlags)", message);
+        return { message };
+    }
+    VkBuffer src;
+    auto stage_result = stage(data, src);
+    if (!stage_result)
+    {
+        return { stage_result.vk_result(), std::string(stage_result.message()) };
+    }
+    auto region = stage_result.value();
+    region.dstOffset = dst_offset;
+    m_buffer_copies.push_back({ src, dst, region, dst_access_mask, dst_stage_mask });
+    return { upload_token { m_batch } };
+}
+
+vengine::vulkan_utils::result<vengine::upload_manager::upload_token>
+vengine::upload_manager::upload_image(std::span<const uint8_t> data, VkImage dst, VkExtent3D extent,
+                                      VkImageLayout final_layout, VkAccessFlags dst_access_mask,
+                                      VkPipelineStageFlags dst_stage_mask, uint32_t mip_levels)
+{
+    auto level = image_level { 0, extent };
+    auto reserve_result = reserve_image_levels(dst, { &level, 1 }, data.size(), final_layout, dst_access_mask, dst_stage_mask, mip_levels);
+    if (!reserve_result)
+    {
+        return { reserve_result.vk_result(), std::string(reserve_result.message()) };
+    }
+    memcpy(reserve_result.value().data.data(), data.data(), data.size());
+    return { reserve_result.value().token };
+}
+
+vengine::vulkan_utils::result<vengine::upload_manager::upload_token>
+vengine::upload_manager::upload_image_levels(std::span<const uint8_t> data, VkImage dst, std::span<const image_level> levels,
+                                             VkImageLayout final_layout, VkAccessFlags dst_access_mask,
+                                             VkPipelineStageFlags dst_stage_mask)
+{
+    auto reserve_result = reserve_image_levels(dst, levels, data.size(), final_layout, dst_access_mask, dst_stage_mask);
+    if (!reserve_result)
+    {
+        return { reserve_result.vk_result(), std::string(reserve_result.message()) };
+    }
+    memcpy(reserve_result.value().data.data(), data.data(), data.size());
+    return { reserve_result.value().token };
+}
+
+vengine::vulkan_utils::result<vengine::upload_manager::image_reservation>
+vengine::upload_manager::reserve_image_levels(VkImage dst, std::span<const image_level> levels, size_t size,
+                                              VkImageLayout final_layout, VkAccessFlags dst_access_mask,
+                                              VkPipelineStageFlags dst_stage_mask, uint32_t mip_levels, bool may_flush)
+{
+    if (!m_staging_buffer.uploaded())
+    {
+        auto message = "Staging buffer was not allocated.";
+        log::error("vengine::upload_manager::reserve_image_levels(VkImage, std::span<const image_level>, size_t, VkImageLayout, VkAccessFlags, VkPipelineStageFlags, uint32_t, bool)", message);
+        return { message };
+    }
+    VkBuffer src;
+    VkDeviceSize src_offset;
+    auto reserve_result = reserve(size, may_flush, src, src_offset);
+    if (!reserve_result)
+    {
+        return { reserve_result.vk_result(), std::string(reserve_result.message()) };
+    }
+
+    std::vector<VkBufferImageCopy> regions;
+    regions.reserve(levels.size());
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        VkBufferImageCopy region = { };
+        region.bufferOffset = src_offset + levels[i].offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = (uint32_t)i;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = levels[i].extent;
+        regions.push_back(region);
+    }
+    m_image_copies.push_back({ src, dst, std::move(regions), levels.size() == 1 ? mip_levels : 1,
+                               final_layout, dst_access_mask, dst_stage_mask });
+    return { image_reservation { { reserve_result.value(), size }, upload_token { m_batch } } };
+}
+
+vengine::vulkan_utils::result<void> vengine::upload_manager::flush()
+{
+    if (!pending())
+    {
+        return {};
+    }
+    auto flush_staging_result = m_staging_buffer.flush();
+    if (!flush_staging_result)
+    {
+        return flush_staging_result;
+    }
+    // Written after they were reserved, hence flushed only now
+    for (auto& buffer : m_dedicated_staging_buffers)
+    {
+        auto flush_dedicated_result = buffer.flush();
+        if (!flush_dedicated_result)
+        {
+            return flush_dedicated_result;
+        }
+    }
+
+    auto transfer_result = m_engine.execute_transfer([&](auto& context) {
+        auto command_buffer = context.command_buffer();
+
+        VkImageSubresourceRange image_subresource_range = { };
+        image_subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_subresource_range.baseMipLevel = 0;
+        image_subresource_range.levelCount = VK_REMAINING_MIP_LEVELS;
+        image_subresource_range.baseArrayLayer = 0;
+        image_subresource_range.layerCount = 1;
+
+        // Barrier all images into the transfer-receive layout at once
+        if (!m_image_copies.empty())
+        {
+            std::vector<VkImageMemoryBarrier> image_memory_barriers;
+            image_memory_barriers.reserve(m_image_copies.size());
+            for (auto& copy : m_image_copies)
+            {
+                VkImageMemoryBarrier image_memory_barrier = { };
+                image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                image_memory_barrier.image = copy.dst;
+                image_memory_barrier.subresourceRange = image_subresource_range;
+                image_memory_barrier.srcAccessMask = 0;
+                image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                image_memory_barriers.push_back(image_memory_barrier);
+            }
+            vkCmdPipelineBarrier(
+                    command_buffer,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    0,
+                    nullptr,
+                    0,
+                    nullptr,
+                    (uint32_t)image_memory_barriers.size(),
+                    image_memory_barriers.data());
+        }
+
+        for (auto& copy : m_buffer_copies)
+        {
+            vkCmdCopyBuffer(command_buffer, copy.src, copy.dst, 1, &copy.region);
+        }
+        for (auto& copy : m_image_copies)
+        {
+            vkCmdCopyBufferToImage(command_buffer, copy.src, copy.dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   (uint32_t)copy.regions.size(), copy.regions.data());
+        }
+
+        // Only the written ranges change owner, other ranges of the buffers may be in use by the graphics queue
+        for (auto& copy : m_buffer_copies)
+        {
+            context.release_buffer(copy.dst, copy.dst_access_mask, copy.dst_stage_mask, copy.region.dstOffset, copy.region.size);
+        }
+        for (auto& copy : m_image_copies)
+        {
+            if (copy.mip_levels > 1)
+            {
+                // The transfer queue cannot blit, the graphics queue takes the image over as is and generates the levels
+                context.release_image(
+                        copy.dst,
+                        image_subresource_range,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT);
+                context.on_acquire([dst = copy.dst, extent = copy.regions.front().imageExtent, mip_levels = copy.mip_levels,
+                                    final_layout = copy.final_layout, dst_access_mask = copy.dst_access_mask,
+                                    dst_stage_mask = copy.dst_stage_mask](VkCommandBuffer graphics_command_buffer) {
+                    record_mip_generation(graphics_command_buffer, dst, extent, mip_levels, final_layout, dst_access_mask, dst_stage_mask);
+                });
+                continue;
+            }
+            context.release_image(
+                    copy.dst,
+                    image_subresource_range,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    copy.final_layout,
+                    copy.dst_access_mask,
+                    copy.dst_stage_mask);
+        }
+    });
+    if (!transfer_result)
+    {
+        return transfer_result;
+    }
+
+    m_in_flight_batches.push_back({ m_batch, transfer_result.value(), m_head, std::move(m_dedicated_staging_buffers) });
+    m_unacquired_batches.push_back({ m_batch, transfer_result.value() });
+    m_dedicated_staging_buffers.clear();
+    m_buffer_copies.clear();
+    m_image_copies.clear();
+    m_batch++;
+    return {};
+}
+
+void vengine::upload_manager::acquired(uint64_t timeline_value)
+{
+    while (!m_unacquired_batches.empty() && m_unacquired_batches.front().timeline_value <= timeline_value)
+    {
+        m_acquired_batch = m_unacquired_batches.front().batch;
+        m_unacquired_batches.pop_front();
+    }
+}
+
+vengine::vulkan_utils::result<void> vengine::upload_manager::wait(upload_token token)
+{
+    reclaim();
+    if (token.batch <= m_completed_batch)
+    {
+        return {};
+    }
+    if (token.batch == m_batch)
+    {
+        auto flush_result = flush();
+        if (!flush_result)
+        {
+            return flush_result;
+        }
+    }
+    for (auto& batch : m_in_flight_batches)
+    {
+        if (batch.batch < token.batch)
+        {
+            continue;
+        }
+        auto wait_result = m_engine.wait_for_transfer(batch.timeline_value);
+        if (!wait_result)
+        {
+            return wait_result;
+        }
+        break;
+    }
+    reclaim();
+    return {};
+}
+
+vengine::vulkan_utils::result<void> vengine::upload_manager::wait_all()
+{
+    auto flush_result = flush();
+    if (!flush_result)
+    {
+        return flush_result;
+    }
+    if (!m_in_flight_batches.empty())
+    {
+        auto wait_result = m_engine.wait_for_transfer(m_in_flight_batches.back().timeline_value);
+        if (!wait_result)
+        {
+            return wait_result;
+        }
+    }
+    reclaim();
+    return {};
+}
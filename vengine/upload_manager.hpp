@@ -0,0 +1,237 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_UPLOAD_MANAGER_HPP
+#define GAME_PROJ_UPLOAD_MANAGER_HPP
+
+#include "allocated_buffer.hpp"
+#include "vulkan-utils/result.hpp"
+
+#include <vulkan/vulkan.h>
+#include <span>
+#include <deque>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace vengine
+{
+    class vengine;
+
+    /**
+     * Batches uploads of buffer and image data into device local memory.
+     *
+     * Data is copied into a persistently mapped staging ring right away, the copy commands
+     * are collected and recorded into a single command buffer of the transfer queue on flush().
+     * The engine flushes at the start of every frame, scenes loading many assets may flush
+     * and wait() once after issuing all of their uploads.
+     *
+     * Staging memory is reclaimed once the batch using it landed. Uploads larger than the
+     * ring get a staging buffer of their own which is destroyed the same way.
+     *
+     * Not thread safe, use from the render thread only.
+     */
+    class upload_manager
+    {
+    public:
+        struct upload_token
+        {
+            // Index of the batch the upload was recorded into.
+            // 0 is never used by a batch and counts as completed.
+            uint64_t batch;
+        };
+        // Location of one mip level inside of the data passed to upload_image_levels
+        struct image_level
+        {
+            // Multiple of the texel block size and of 4
+            VkDeviceSize offset;
+            VkExtent3D extent;
+        };
+        // Staging memory of an image upload, filled by the caller (see reserve_image_levels)
+        struct image_reservation
+        {
+            std::span<uint8_t> data;
+            upload_token token;
+        };
+    private:
+        struct buffer_copy
+        {
+            VkBuffer src;
+            VkBuffer dst;
+            VkBufferCopy region;
+            VkAccessFlags dst_access_mask;
+            VkPipelineStageFlags dst_stage_mask;
+        };
+        struct image_copy
+        {
+            VkBuffer src;
+            VkImage dst;
+            // One per uploaded mip level
+            std::vector<VkBufferImageCopy> regions;
+            // Levels generated from level 0 on the graphics queue, 1 if none
+            uint32_t mip_levels;
+            VkImageLayout final_layout;
+            VkAccessFlags dst_access_mask;
+            VkPipelineStageFlags dst_stage_mask;
+        };
+        struct in_flight_batch
+        {
+            uint64_t batch;
+            // Value of the transfer timeline semaphore that signals the batch landed
+            uint64_t timeline_value;
+            // m_head after the batch was recorded, becomes m_tail once it landed
+            uint64_t staging_end;
+            std::vector<allocated_buffer> dedicated_staging_buffers;
+        };
+        struct unacquired_batch
+        {
+            uint64_t batch;
+            uint64_t timeline_value;
+        };
+
+        ::vengine::vengine& m_engine;
+        allocated_buffer m_staging_buffer;
+        // Byte counters which only ever grow, positions inside of m_staging_buffer are taken modulo its size
+        uint64_t m_head;
+        uint64_t m_tail;
+
+        // Currently open batch
+        uint64_t m_batch;
+        std::vector<buffer_copy> m_buffer_copies;
+        std::vector<image_copy> m_image_copies;
+        std::vector<allocated_buffer> m_dedicated_staging_buffers;
+
+        std::deque<in_flight_batch> m_in_flight_batches;
+        // Last batch that landed, its staging memory is reclaimed
+        uint64_t m_completed_batch;
+        // Batches whose queue family acquire was not yet recorded by a frame, oldest first
+        std::deque<unacquired_batch> m_unacquired_batches;
+        // Last batch whose acquire was recorded, see completed
+        uint64_t m_acquired_batch;
+
+        /**
+         * Reserves size bytes of staging memory, flushing or waiting for batches if the ring is full.
+         *
+         * @param may_flush If false, fails with VK_NOT_READY instead of flushing the open batch.
+         * @returns The mapped memory, src and src_offset receive the buffer and offset holding it.
+         */
+        vulkan_utils::result<uint8_t*> reserve(size_t size, bool may_flush, VkBuffer& src, VkDeviceSize& src_offset);
+
+        /**
+         * Copies data into reserved staging memory.
+         *
+         * @returns The buffer and offset holding the data.
+         */
+        vulkan_utils::result<VkBufferCopy> stage(std::span<const uint8_t> data, VkBuffer& src);
+
+        /**
+         * Releases the staging memory of every batch that landed.
+         */
+        void reclaim();
+    public:
+        explicit upload_manager(::vengine::vengine& engine)
+                : m_engine(engine),
+                m_head(0),
+                m_tail(0),
+                m_batch(1),
+                m_completed_batch(0),
+                m_acquired_batch(0)
+        {
+        }
+        upload_manager(const upload_manager&) = delete;
+        upload_manager& operator=(const upload_manager&) = delete;
+        ~upload_manager() { destroy(); }
+
+        /**
+         * Creates the staging ring. Must be called before any upload.
+         */
+        vulkan_utils::result<void> allocate_staging_buffer(size_t size);
+
+        /**
+         * Waits for all batches and releases the staging memory.
+         */
+        void destroy();
+
+        /**
+         * Copies data into dst at dst_offset. dst needs VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+         *
+         * @param dst_access_mask How the graphics queue is going to access dst.
+         * @param dst_stage_mask The pipeline stages the graphics queue is going to access dst in.
+         */
+        vulkan_utils::result<upload_token> upload_buffer(std::span<const uint8_t> data, VkBuffer dst, VkDeviceSize dst_offset,
+                                                         VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask);
+
+        /**
+         * Copies tightly packed texels into mip level 0 of dst and transitions all levels into final_layout.
+         * The previous content of dst is discarded. dst needs VK_IMAGE_USAGE_TRANSFER_DST_BIT.
+         *
+         * @param dst_access_mask How the graphics queue is going to access dst.
+         * @param dst_stage_mask The pipeline stages the graphics queue is going to access dst in.
+         * @param mip_levels If greater than 1, levels 1 to mip_levels - 1 are generated by blitting level 0
+         *                   down on the graphics queue once the copy landed. dst then needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+         *                   and its format VK_FORMAT_FEATURE_BLIT_SRC_BIT, VK_FORMAT_FEATURE_BLIT_DST_BIT and
+         *                   VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT.
+         */
+        vulkan_utils::result<upload_token> upload_image(std::span<const uint8_t> data, VkImage dst, VkExtent3D extent,
+                                                        VkImageLayout final_layout, VkAccessFlags dst_access_mask,
+                                                        VkPipelineStageFlags dst_stage_mask, uint32_t mip_levels = 1);
+
+        /**
+         * Copies levels[i] of data into mip level i of dst and transitions all levels into final_layout.
+         * Like upload_image but for mip chains prepared up front (eg. generated on the CPU or loaded from disk).
+         */
+        vulkan_utils::result<upload_token> upload_image_levels(std::span<const uint8_t> data, VkImage dst, std::span<const image_level> levels,
+                                                               VkImageLayout final_layout, VkAccessFlags dst_access_mask,
+                                                               VkPipelineStageFlags dst_stage_mask);
+
+        /**
+         * Like upload_image_levels (or upload_image if mip_levels is greater than 1) but instead of copying,
+         * the caller writes the size bytes of level data into the returned span, eg. by decoding straight into it.
+         * The span may be written from any thread but must be fully written before the next flush.
+         *
+         * @param may_flush If false and the staging ring is full, fails with VK_NOT_READY instead of flushing
+         *                  the open batch, which would submit other reservations not written yet.
+         */
+        vulkan_utils::result<image_reservation> reserve_image_levels(VkImage dst, std::span<const image_level> levels, size_t size,
+                                                                     VkImageLayout final_layout, VkAccessFlags dst_access_mask,
+                                                                     VkPipelineStageFlags dst_stage_mask, uint32_t mip_levels = 1,
+                                                                     bool may_flush = true);
+
+        /**
+         * Records every upload of the open batch into one command buffer and submits it to the transfer queue.
+         * Does nothing if no upload is pending.
+         */
+        vulkan_utils::result<void> flush();
+
+        /**
+         * Marks the batches up to timeline_value as acquired, called by vengine::render once the frame
+         * recording their acquire barriers was submitted.
+         */
+        void acquired(uint64_t timeline_value);
+
+        /**
+         * Answers from the frames vengine::render submitted, an upload only counts as completed once
+         * a frame acquiring it was submitted. A failed frame leaves its acquires to the next one.
+         *
+         * @returns true if the upload landed and its resources may be used by frames rendered from now on.
+         */
+        [[nodiscard]] bool completed(upload_token token) const { return token.batch <= m_acquired_batch; }
+
+        /**
+         * Blocks until the upload landed, flushing the open batch if it contains the upload.
+         * completed only reports it once the next frame acquiring it was submitted.
+         */
+        vulkan_utils::result<void> wait(upload_token token);
+
+        /**
+         * Flushes and blocks until every upload landed.
+         */
+        vulkan_utils::result<void> wait_all();
+
+        [[nodiscard]] bool pending() const { return !m_buffer_copies.empty() || !m_image_copies.empty(); }
+        [[nodiscard]] size_t staging_capacity() const { return m_staging_buffer.size; }
+    };
+}
+
+#endif //GAME_PROJ_UPLOAD_MANAGER_HPP
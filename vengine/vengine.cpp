@@ -14,11 +14,15 @@
 #include "vulkan-utils/descriptor_pool_builder.hpp"
 #include "vulkan-utils/fence_builder.hpp"
 #include "vulkan-utils/submit_builder.hpp"
+#include "vulkan-utils/semaphore_builder.hpp"
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <array>
+#include <iterator>
 #include <sstream>
+#include <thread>
 
 using namespace vengine::vulkan_utils;
 
@@ -49,17 +53,38 @@ inline std::string VKB_ERROR<VkResult>(std::string_view message, VkResult error)
     return ret_val;
 }
 
-vengine::vengine::vengine()
+vengine::vengine::vengine() : vengine(engine_options { })
 {
-    glfw_window_init(800, 600, "vengine");
-    if (!m_glfw_initialized)
+}
+
+vengine::vengine::vengine(const engine_options& options)
+{
+    m_frames_in_flight = options.frames_in_flight;
+    if (m_frames_in_flight < 1 || m_frames_in_flight > max_frames_in_flight)
     {
-        log::error("vengine::vengine::vengine()", "Failed to initialize glfw.");
-        return;
+        m_frames_in_flight = std::clamp<size_t>(m_frames_in_flight, 1, max_frames_in_flight);
+        log::warning("vengine::vengine::vengine(const engine_options&)", "frames_in_flight is outside of the supported range (1 - 4) and was clamped.");
+    }
+
+    m_requested_present_mode = options.present_mode;
+    m_requested_swap_chain_image_count = options.swap_chain_image_count;
+    frame_rate_limit(options.frame_rate_limit);
+    m_headless = options.headless;
+
+    if (!m_headless)
+    {
+        glfw_window_init(800, 600, "vengine");
+        if (!m_glfw_initialized)
+        {
+            log::error("vengine::vengine::vengine()", "Failed to initialize glfw.");
+            return;
+        }
     }
-    // Create vulkan instance
+    // Create vulkan instance, without surface extensions if headless
     auto
             instance_result = vkb::InstanceBuilder { }.set_app_name("vengine")
+                                                      .set_headless(m_headless)
+                                                      .require_api_version(1, 2, 0)
                                                       .request_validation_layers()
                                                       .use_default_debug_messenger()
                                                       .build();
@@ -71,22 +96,37 @@ vengine::vengine::vengine()
     m_vkb_instance = instance_result.value();
 
     // Create vulkan surface
-    auto glfw_surface_creation_result = glfwCreateWindowSurface(
-            m_vkb_instance.instance, static_cast<GLFWwindow *>(m_window_handle), nullptr, &m_vulkan_surface);
-    if (glfw_surface_creation_result != VK_SUCCESS)
+    if (!m_headless)
     {
-        log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create vulkan surface using glfw.", instance_result));
-        return;
+        auto glfw_surface_creation_result = glfwCreateWindowSurface(
+                m_vkb_instance.instance, static_cast<GLFWwindow *>(m_window_handle), nullptr, &m_vulkan_surface);
+        if (glfw_surface_creation_result != VK_SUCCESS)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create vulkan surface using glfw.", instance_result));
+            return;
+        }
     }
 
 
     // Pick vulkan physical device
+    VkPhysicalDeviceVulkan12Features physical_device_vulkan_12_features = { };
+    physical_device_vulkan_12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    physical_device_vulkan_12_features.timelineSemaphore = VK_TRUE;
+    physical_device_vulkan_12_features.drawIndirectCount = VK_TRUE;
+    VkPhysicalDeviceFeatures physical_device_features = { };
+    physical_device_features.multiDrawIndirect = VK_TRUE;
+    physical_device_features.drawIndirectFirstInstance = VK_TRUE;
+    auto physical_device_selector = vkb::PhysicalDeviceSelector { m_vkb_instance };
+    if (!m_headless)
+    {
+        physical_device_selector.set_surface(m_vulkan_surface);
+    }
     auto
-            physical_device_result = vkb::PhysicalDeviceSelector { m_vkb_instance }.set_surface(m_vulkan_surface)
-                                                                                   .set_minimum_version(1, 1)
-                                                                                   .require_dedicated_transfer_queue()
-                                                                                   .require_present()
-                                                                                   .select();
+            physical_device_result = physical_device_selector.set_minimum_version(1, 2)
+                                                             .set_required_features(physical_device_features)
+                                                             .set_required_features_12(physical_device_vulkan_12_features)
+                                                             .require_present(!m_headless)
+                                                             .select();
     if (!physical_device_result)
     {
         log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to find suitable vulkan physical device.", instance_result));
@@ -108,7 +148,7 @@ vengine::vengine::vengine()
     m_vkb_device = device_result.value();
 
     // Create descriptor pool
-    auto descriptor_pool_result = vulkan_utils::descriptor_pool_builder(m_vkb_device.device, 10 * frame_data_structures_count)
+    auto descriptor_pool_result = vulkan_utils::descriptor_pool_builder(m_vkb_device.device, 10 * m_frames_in_flight)
             .add_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10)
             .add_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10)
             .build();
@@ -132,16 +172,38 @@ vengine::vengine::vengine()
     m_descriptor_set_layout = descriptor_set_layout_result.value();
 
     // Create swap chain
-    auto
-            swap_chain_result
-            = vkb::SwapchainBuilder { m_vkb_device }.set_desired_format({ .format = VK_FORMAT_B8G8R8A8_SRGB, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR })
-                                                    .build();
-    if (!swap_chain_result)
+    if (m_headless)
     {
-        log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create vulkan swap chain.", instance_result));
-        return;
+        m_render_extent = { (uint32_t)options.headless_size.width, (uint32_t)options.headless_size.height };
+        m_color_format = VK_FORMAT_R8G8B8A8_SRGB;
+        log::info("vengine::vengine::vengine()", std::string("Rendering headless into ").append(std::to_string(m_render_extent.width))
+                .append("x").append(std::to_string(m_render_extent.height)).append(" offscreen images."));
+    }
+    else
+    {
+        auto swap_chain_result = swap_chain_builder().build();
+        if (!swap_chain_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create vulkan swap chain.", instance_result));
+            return;
+        }
+        m_vkb_swap_chain = swap_chain_result.value();
+        m_render_extent = m_vkb_swap_chain.extent;
+        m_color_format = m_vkb_swap_chain.image_format;
+        log_swap_chain("vengine::vengine::vengine()");
+    }
+
+    // Create pipeline cache, warm from the last run if the device and driver did not change
+    {
+        m_pipeline_cache = std::make_unique<pipeline_cache>(
+                m_vkb_device.device, m_physical_device_properties, options.pipeline_cache_path);
+        auto pipeline_cache_result = m_pipeline_cache->create();
+        if (!pipeline_cache_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create pipeline cache.", pipeline_cache_result));
+            return;
+        }
     }
-    m_vkb_swap_chain = swap_chain_result.value();
 
     // Create allocator
     {
@@ -158,53 +220,12 @@ vengine::vengine::vengine()
     }
 
 
-    // Create Depths image
+    // Create depths image and get swap chain image views
     m_depths_format = VK_FORMAT_D32_SFLOAT;
-    auto depths_image_result = vulkan_utils::image_builder(m_vma_allocator, {m_vkb_swap_chain.extent.width, m_vkb_swap_chain.extent.height, 1})
-            .set_memory_usage(VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY)
-            .set_image_usage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
-            .set_memory_property_flags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-            .set_format(m_depths_format)
-            .build();
-    if (!depths_image_result)
-    {
-        log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create depths image.", depths_image_result));
-        return;
-    }
-    m_depth_image = depths_image_result.value();
-
-    // Create Depths image view
-    auto depths_image_view_result = vulkan_utils::image_view_builder(m_vkb_device.device, m_depth_image.image)
-            .set_memory_usage(VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY)
-            .set_image_usage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
-            .set_memory_property_flags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-            .set_format(m_depths_format)
-            .set_image_aspect(VK_IMAGE_ASPECT_DEPTH_BIT)
-            .build();
-    if (!depths_image_view_result)
-    {
-        log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create depths image view.", depths_image_view_result));
-        return;
-    }
-    m_depths_image_view = depths_image_view_result.value();
-
-    // Get images
-    auto swap_chain_images_result = m_vkb_swap_chain.get_images();
-    if (!swap_chain_images_result)
-    {
-        log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to receive images from swap chain.", instance_result));
-        return;
-    }
-    m_swap_chain_images = swap_chain_images_result.value();
-
-    // Get image views
-    auto swap_chain_image_views_result = m_vkb_swap_chain.get_image_views();
-    if (!swap_chain_image_views_result)
+    if (!create_depth_image() || !create_swap_chain_image_views())
     {
-        log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to receive image views from swap chain.", instance_result));
         return;
     }
-    m_swap_chain_image_views = swap_chain_image_views_result.value();
 
 
     // Get Graphics Queue
@@ -225,6 +246,26 @@ vengine::vengine::vengine()
     }
     m_vkb_graphics_queue_index = graphics_queue_index_result.value();
 
+    // Get Transfer Queue
+    // Prefers a queue family without graphics and compute support (DMA engine) which runs
+    // uploads in parallel to rendering. Falls back to the graphics queue if the device has none.
+    if (auto dedicated_transfer_queue_result = m_vkb_device.get_dedicated_queue(vkb::QueueType::transfer))
+    {
+        m_vkb_transfer_queue = dedicated_transfer_queue_result.value();
+        m_vkb_transfer_queue_index = m_vkb_device.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+    }
+    else if (auto separate_transfer_queue_result = m_vkb_device.get_queue(vkb::QueueType::transfer))
+    {
+        m_vkb_transfer_queue = separate_transfer_queue_result.value();
+        m_vkb_transfer_queue_index = m_vkb_device.get_queue_index(vkb::QueueType::transfer).value();
+    }
+    else
+    {
+        log::info("vengine::vengine::vengine()", "No separate transfer queue available, uploads use the graphics queue.");
+        m_vkb_transfer_queue = m_vkb_graphics_queue;
+        m_vkb_transfer_queue_index = m_vkb_graphics_queue_index;
+    }
+
     // Create render pass
     {
         VkAttachmentReference color_attachment_ref = { };
@@ -242,17 +283,19 @@ vengine::vengine::vengine()
         sub_pass_description.pColorAttachments = &color_attachment_ref;
         sub_pass_description.pDepthStencilAttachment = &depth_attachment_ref;
 
-        auto render_pass_create_result = vulkan_utils::render_pass_builder(m_vkb_device.device)
+        auto color_pass_builder = vulkan_utils::render_pass_builder(m_vkb_device.device);
+        color_pass_builder
                 .add_attachment_description(
                         0,
-                        m_vkb_swap_chain.image_format,
+                        m_color_format,
                         VK_SAMPLE_COUNT_1_BIT,
                         VK_ATTACHMENT_LOAD_OP_CLEAR,
                         VK_ATTACHMENT_STORE_OP_STORE,
                         VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                         VK_ATTACHMENT_STORE_OP_DONT_CARE,
                         VK_IMAGE_LAYOUT_UNDEFINED,
-                        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+                        // Offscreen images are only ever copied from
+                        m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
                 .add_attachment_description(
                         0,
                         m_depths_format,
@@ -263,8 +306,20 @@ vengine::vengine::vengine()
                         VK_ATTACHMENT_STORE_OP_DONT_CARE,
                         VK_IMAGE_LAYOUT_UNDEFINED,
                         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-                .add_sub_pass_description(sub_pass_description)
-                .build();
+                .add_sub_pass_description(sub_pass_description);
+        if (m_headless)
+        {
+            // The implicit external dependency ends at BOTTOM_OF_PIPE without any access, this one
+            // chains the color writes and the final layout transition to the copy of record_read_back
+            color_pass_builder.add_sub_pass_dependency(
+                    0,
+                    VK_SUBPASS_EXTERNAL,
+                    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT);
+        }
+        auto render_pass_create_result = color_pass_builder.build();
         if (!render_pass_create_result)
         {
             log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create render pass.", render_pass_create_result));
@@ -274,34 +329,9 @@ vengine::vengine::vengine()
     }
 
     // Create frame buffers
+    if (!create_frame_buffers())
     {
-        VkFramebufferCreateInfo framebuffer_create_info = { };
-        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebuffer_create_info.pNext = nullptr;
-
-        framebuffer_create_info.renderPass = m_vulkan_render_pass;
-        framebuffer_create_info.width = m_vkb_swap_chain.extent.width;
-        framebuffer_create_info.height = m_vkb_swap_chain.extent.height;
-        framebuffer_create_info.layers = 1;
-
-        m_frame_buffers = std::vector<VkFramebuffer>(m_swap_chain_image_views.size(), nullptr);
-        for (size_t i = 0; i < m_swap_chain_image_views.size(); i++)
-        {
-            auto attachments = std::array<VkImageView, 2>{ m_swap_chain_image_views[i], m_depths_image_view };
-            framebuffer_create_info.attachmentCount = (uint32_t)attachments.size();
-            framebuffer_create_info.pAttachments = attachments.data();
-            auto
-                    create_frame_buffer_result = vkCreateFramebuffer(
-                    m_vkb_device.device,
-                    &framebuffer_create_info,
-                    nullptr,
-                    &m_frame_buffers[i]);
-            if (create_frame_buffer_result != VK_SUCCESS)
-            {
-                log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create frame buffer.", create_frame_buffer_result));
-                return;
-            }
-        }
+        return;
     }
 
     // Create general command pool
@@ -333,11 +363,102 @@ vengine::vengine::vengine()
         }
         m_general_fence = fence_create_result.value();
     }
+    // Create frame timeline semaphore
+    {
+        auto semaphore_create_result = semaphore_builder(m_vkb_device.device)
+                .set_timeline(0)
+                .build();
+
+        if (!semaphore_create_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create frame timeline semaphore.", semaphore_create_result));
+            return;
+        }
+        m_frame_timeline = semaphore_create_result.value();
+        m_frame_timeline_value = 0;
+    }
+    // Create transfer command pool
+    {
+        VkCommandPoolCreateInfo command_pool_create_info = { };
+        command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        command_pool_create_info.pNext = nullptr;
+        command_pool_create_info.queueFamilyIndex = m_vkb_transfer_queue_index;
+        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        auto command_pool_result = vkCreateCommandPool(
+                m_vkb_device.device, &command_pool_create_info, nullptr, &m_transfer_command_pool);
+        if (command_pool_result != VK_SUCCESS)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create transfer command pool.", command_pool_result));
+            return;
+        }
+    }
+    // Create transfer timeline semaphore
+    {
+        auto semaphore_create_result = semaphore_builder(m_vkb_device.device)
+                .set_timeline(0)
+                .build();
+
+        if (!semaphore_create_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create transfer timeline semaphore.", semaphore_create_result));
+            return;
+        }
+        m_transfer_timeline = semaphore_create_result.value();
+        m_transfer_timeline_value = 0;
+    }
+
+    // Create profiler, GPU zones need timestamp support of the graphics queue
+    {
+        ::vengine::profiler::thread_name("Render thread");
+        ::vengine::profiler::enabled(options.profiling);
+        m_profiler = std::make_unique<::vengine::profiler>(
+                m_vkb_device.device,
+                m_physical_device_properties,
+                m_vkb_device.queue_families[m_vkb_graphics_queue_index].timestampValidBits,
+                m_frames_in_flight,
+                options.profiler_gpu_zones,
+                options.profiler_history);
+        auto profiler_result = m_profiler->create();
+        if (!profiler_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create profiler.", profiler_result));
+            return;
+        }
+    }
+
+    // Create recording threads
+    m_worker_pool = std::make_unique<utils::worker_pool>(options.recording_threads);
+
+    // Create file reading service
+    m_async_io = std::make_unique<async_io>(options.io_queue_depth, options.io_fallback_threads);
+
+    // Create geometry pool, its buffers are created on first use
+    m_geometry_pool = std::make_unique<geometry_pool>(
+            m_vma_allocator, options.geometry_vertex_buffer_size, options.geometry_index_buffer_size);
+
+    // Create upload manager
+    {
+        m_upload_manager = std::make_unique<upload_manager>(*this);
+        auto staging_buffer_result = m_upload_manager->allocate_staging_buffer(options.staging_buffer_size);
+        if (!staging_buffer_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create staging buffer.", staging_buffer_result));
+            return;
+        }
+    }
+
+    // Create texture streamer, uploads through the upload manager
+    m_texture_streamer = std::make_unique<texture_streamer>(
+            *this, options.texture_budget, options.texture_budget_fraction, options.texture_upload_bytes_per_frame);
 
 
-    for (size_t i = 0; i < frame_data_structures_count; i++)
+    m_frame_data_structures.reserve(m_frames_in_flight);
+    for (size_t i = 0; i < m_frames_in_flight; i++)
     {
         auto& data = m_frame_data_structures.emplace_back();
+        data.index = i;
+        data.timeline_value = 0;
         // Create command pools
         {
             VkCommandPoolCreateInfo command_pool_create_info = { };
@@ -355,18 +476,24 @@ vengine::vengine::vengine()
             }
         }
 
-        // Create render fence
+        // Create worker command pools (one per recording thread + one for the render thread)
+        for (size_t j = 0; j < m_worker_pool->size() + 1; j++)
         {
-            auto fence_create_result = fence_builder(m_vkb_device.device)
-                    .set_fence_create_flags(VK_FENCE_CREATE_SIGNALED_BIT)
-                    .build();
+            VkCommandPoolCreateInfo command_pool_create_info = { };
+            command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            command_pool_create_info.pNext = nullptr;
+            command_pool_create_info.queueFamilyIndex = m_vkb_graphics_queue_index;
+            command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-            if (!fence_create_result)
+            auto& worker_command_pool = data.worker_command_pools.emplace_back();
+            worker_command_pool.used = 0;
+            auto command_pool_result = vkCreateCommandPool(
+                    m_vkb_device.device, &command_pool_create_info, nullptr, &worker_command_pool.command_pool);
+            if (command_pool_result != VK_SUCCESS)
             {
-                log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create general fence.", fence_create_result));
+                log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create worker command pool.", command_pool_result));
                 return;
             }
-            data.render_fence = fence_create_result.value();
         }
 
         // Create present and render semaphore
@@ -394,9 +521,10 @@ vengine::vengine::vengine()
 
         auto buffer = create_command_buffer(data);
 
-        auto camera_buffer_result = vulkan_utils::buffer_builder(m_vma_allocator, sizeof(data.camera_buffer))
+        auto camera_buffer_result = vulkan_utils::buffer_builder(m_vma_allocator, sizeof(gpu_camera_data))
                 .set_buffer_usage(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
                 .set_memory_usage(VMA_MEMORY_USAGE_CPU_TO_GPU)
+                .set_persistently_mapped()
                 .build();
         if (!camera_buffer_result)
         {
@@ -408,6 +536,7 @@ vengine::vengine::vengine()
         auto mesh_buffer_result = vulkan_utils::buffer_builder(m_vma_allocator, sizeof(vengine::vengine::gpu_mesh_data) * data.mesh_buffer_size)
                 .set_buffer_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
                 .set_memory_usage(VMA_MEMORY_USAGE_CPU_TO_GPU)
+                .set_persistently_mapped()
                 .build();
         if (!mesh_buffer_result)
         {
@@ -415,6 +544,20 @@ vengine::vengine::vengine()
             return;
         }
         data.mesh_buffer = mesh_buffer_result.value();
+        data.mesh_allocator = ring_allocator<gpu_mesh_data>(data.mesh_buffer);
+
+        auto indirect_buffer_result = vulkan_utils::buffer_builder(m_vma_allocator, sizeof(VkDrawIndexedIndirectCommand) * data.mesh_buffer_size)
+                .set_buffer_usage(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_CPU_TO_GPU)
+                .set_persistently_mapped()
+                .build();
+        if (!indirect_buffer_result)
+        {
+            log::error("vengine::vengine::vengine()", VKB_ERROR("Failed to create indirect buffer.", indirect_buffer_result));
+            return;
+        }
+        data.indirect_buffer = indirect_buffer_result.value();
+        data.indirect_allocator = ring_allocator<VkDrawIndexedIndirectCommand>(data.indirect_buffer);
 
 
         // Create descriptor set
@@ -463,6 +606,23 @@ vengine::vengine::vengine()
 
 vengine::vengine::~vengine()
 {
+    wait_idle();
+    if (m_texture_streamer)
+    {
+        m_texture_streamer->destroy();
+    }
+    if (m_upload_manager)
+    {
+        m_upload_manager->destroy();
+    }
+    if (m_geometry_pool)
+    {
+        m_geometry_pool->destroy();
+    }
+    if (m_profiler)
+    {
+        m_profiler->destroy();
+    }
     if (!m_shader_modules.empty())
     {
         for (auto it: m_shader_modules)
@@ -473,7 +633,7 @@ vengine::vengine::~vengine()
             }
             vkDestroyShaderModule(m_vkb_device.device, it, nullptr);
         }
-        m_frame_buffers.clear();
+        m_shader_modules.clear();
     }
     for (auto& data : m_frame_data_structures)
     {
@@ -485,10 +645,13 @@ vengine::vengine::~vengine()
         {
             data.mesh_buffer.destroy();
         }
-        if (data.render_fence)
+        if (data.indirect_buffer.uploaded())
+        {
+            data.indirect_buffer.destroy();
+        }
+        if (data.read_back_buffer.uploaded())
         {
-            vkDestroyFence(m_vkb_device.device, data.render_fence, nullptr);
-            data.render_fence = {};
+            data.read_back_buffer.destroy();
         }
         if (data.present_semaphore)
         {
@@ -515,56 +678,51 @@ vengine::vengine::~vengine()
             vkDestroyCommandPool(m_vkb_device.device, data.command_pool, nullptr);
             data.command_pool = {};
         }
+        for (auto& worker_command_pool : data.worker_command_pools)
+        {
+            if (worker_command_pool.command_pool)
+            {
+                // Destroying the pool frees all of its command buffers
+                vkDestroyCommandPool(m_vkb_device.device, worker_command_pool.command_pool, nullptr);
+                worker_command_pool.command_pool = {};
+            }
+        }
+        data.worker_command_pools.clear();
     }
     if (m_general_fence)
     {
         vkDestroyFence(m_vkb_device.device, m_general_fence, nullptr);
         m_general_fence = {};
     }
+    if (m_frame_timeline)
+    {
+        vkDestroySemaphore(m_vkb_device.device, m_frame_timeline, nullptr);
+        m_frame_timeline = {};
+    }
     if (m_general_command_pool)
     {
         vkDestroyCommandPool(m_vkb_device.device, m_general_command_pool, nullptr);
         m_general_command_pool = {};
     }
-    m_frame_data_structures.clear();
-    if (!m_frame_buffers.empty())
+    if (m_transfer_timeline)
     {
-        for (auto it: m_frame_buffers)
-        {
-            if (!it)
-            {
-                continue;
-            }
-            vkDestroyFramebuffer(m_vkb_device.device, it, nullptr);
-        }
-        m_frame_buffers.clear();
+        vkDestroySemaphore(m_vkb_device.device, m_transfer_timeline, nullptr);
+        m_transfer_timeline = {};
     }
+    if (m_transfer_command_pool)
+    {
+        // Destroying the pool frees the command buffers of pending transfers
+        vkDestroyCommandPool(m_vkb_device.device, m_transfer_command_pool, nullptr);
+        m_transfer_command_pool = {};
+    }
+    m_pending_transfers.clear();
+    m_frame_data_structures.clear();
+    destroy_swap_chain_resources();
     if (m_vulkan_render_pass)
     {
         vkDestroyRenderPass(m_vkb_device.device, m_vulkan_render_pass, nullptr);
         m_vulkan_render_pass = nullptr;
     }
-    for (auto it: m_swap_chain_image_views)
-    {
-        vkDestroyImageView(m_vkb_device.device, it, nullptr);
-    }
-    m_swap_chain_image_views.clear();
-    // for (auto it : m_swap_chain_images)
-    // {
-    //     vkDestroyImage(m_vkb_device.device, it, nullptr);
-    // }
-    m_swap_chain_images.clear();
-
-
-    if (m_depths_image_view)
-    {
-        vkDestroyImageView(m_vkb_device.device, m_depths_image_view, nullptr);
-        m_depths_image_view = nullptr;
-    }
-    if (m_depth_image.uploaded())
-    {
-        m_depth_image.destroy();
-    }
     if (m_vkb_swap_chain.swapchain)
     {
         vkb::destroy_swapchain(m_vkb_swap_chain);
@@ -584,6 +742,11 @@ vengine::vengine::~vengine()
         vkDestroyDescriptorPool(m_vkb_device.device, m_descriptor_pool, nullptr);
         m_descriptor_pool = nullptr;
     }
+    if (m_pipeline_cache)
+    {
+        m_pipeline_cache->save();
+        m_pipeline_cache->destroy();
+    }
     if (m_vkb_device.device)
     {
         vkb::destroy_device(m_vkb_device);
@@ -652,6 +815,124 @@ std::optional<VkCommandBuffer> vengine::vengine::create_command_buffer(VkCommand
     vkFreeCommandBuffers(m_vkb_device.device, command_pool, 1, &buffer);
 }
 
+std::optional<VkCommandBuffer> vengine::vengine::begin_secondary_command_buffer(frame_data& frame, size_t pool_index) const
+{
+    auto& worker_command_pool = frame.worker_command_pools[pool_index];
+    if (worker_command_pool.used == worker_command_pool.command_buffers.size())
+    {
+        VkCommandBufferAllocateInfo command_buffer_allocate_info = { };
+        command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_buffer_allocate_info.pNext = nullptr;
+
+        command_buffer_allocate_info.commandPool = worker_command_pool.command_pool;
+        command_buffer_allocate_info.commandBufferCount = 1;
+        command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+        VkCommandBuffer vk_command_buffer;
+        auto command_buffer_result = vkAllocateCommandBuffers(m_vkb_device.device, &command_buffer_allocate_info, &vk_command_buffer);
+        if (command_buffer_result != VK_SUCCESS)
+        {
+            log::error("vengine::vengine::begin_secondary_command_buffer(frame_data&, size_t)", VKB_ERROR("Failed to create secondary command buffer.", command_buffer_result));
+            return { };
+        }
+        worker_command_pool.command_buffers.push_back(vk_command_buffer);
+    }
+    auto command_buffer = worker_command_pool.command_buffers[worker_command_pool.used++];
+
+    VkCommandBufferInheritanceInfo command_buffer_inheritance_info = { };
+    command_buffer_inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    command_buffer_inheritance_info.pNext = nullptr;
+    command_buffer_inheritance_info.renderPass = m_vulkan_render_pass;
+    command_buffer_inheritance_info.subpass = 0;
+    command_buffer_inheritance_info.framebuffer = frame.framebuffer;
+
+    VkCommandBufferBeginInfo command_buffer_begin_info = { };
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.pNext = nullptr;
+    command_buffer_begin_info.pInheritanceInfo = &command_buffer_inheritance_info;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+
+    auto command_buffer_begin_result = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+    if (command_buffer_begin_result != VK_SUCCESS)
+    {
+        log::error("vengine::vengine::begin_secondary_command_buffer(frame_data&, size_t)", VKB_ERROR("Failed to begin secondary command buffer.", command_buffer_begin_result));
+        return { };
+    }
+
+    // Dynamic state is not inherited from the primary command buffer
+    auto viewport = vulkan_default_viewport();
+    auto scissors = vulkan_default_scissors();
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissors);
+    return command_buffer;
+}
+
+result<void> vengine::vengine::record_parallel(
+        on_render_pass_event_args& args,
+        size_t count,
+        const std::function<void(VkCommandBuffer, size_t)>& func)
+{
+    auto& data = args.current_frame_data;
+    auto render_thread_pool_index = data.worker_command_pools.size() - 1;
+
+    // Close what got recorded on the render thread so far to keep the execution order
+    auto command_buffer_end_result = vkEndCommandBuffer(args.command_buffer);
+    if (command_buffer_end_result != VK_SUCCESS)
+    {
+        auto message = VKB_ERROR("Failed to end command buffer.", command_buffer_end_result);
+        log::error("vengine::vengine::record_parallel(on_render_pass_event_args&, size_t, const std::function<void(VkCommandBuffer, size_t)>&)", message);
+        return { command_buffer_end_result, message };
+    }
+    data.secondary_command_buffers.push_back(args.command_buffer);
+    args.command_buffer = VK_NULL_HANDLE;
+
+    VENGINE_PROFILE_ZONE("vengine::record_parallel");
+    std::vector<VkCommandBuffer> recorded(count, VK_NULL_HANDLE);
+    // Stays failed if func throws, which parallel_for only logs
+    std::vector<VkResult> results(count, VK_ERROR_UNKNOWN);
+    m_worker_pool->parallel_for(count, [&](size_t index, size_t worker_index)
+    {
+        VENGINE_PROFILE_ZONE("vengine::record_parallel task");
+        auto command_buffer = begin_secondary_command_buffer(data, worker_index);
+        if (!command_buffer.has_value())
+        {
+            return;
+        }
+        func(command_buffer.value(), index);
+        results[index] = vkEndCommandBuffer(command_buffer.value());
+        recorded[index] = command_buffer.value();
+    });
+
+    // args.command_buffer is handed back begun even if recording failed, render() only executes what got recorded
+    auto command_buffer = begin_secondary_command_buffer(data, render_thread_pool_index);
+    if (command_buffer.has_value())
+    {
+        args.command_buffer = command_buffer.value();
+    }
+
+    result<void> record_result { };
+    for (size_t i = 0; i < count; i++)
+    {
+        if (results[i] != VK_SUCCESS)
+        {
+            if (record_result)
+            {
+                auto message = VKB_ERROR("Failed to record secondary command buffer.", results[i]);
+                log::error("vengine::vengine::record_parallel(on_render_pass_event_args&, size_t, const std::function<void(VkCommandBuffer, size_t)>&)", message);
+                record_result = { results[i], message };
+            }
+            continue;
+        }
+        // Inserted before args.command_buffer, which is pushed once the subscribers are done
+        data.secondary_command_buffers.push_back(recorded[i]);
+    }
+    if (!command_buffer.has_value())
+    {
+        return { "Failed to begin secondary command buffer." };
+    }
+    return record_result;
+}
+
 result<void> vengine::vengine::wait_for_fence(VkFence fence)
 {
     const size_t one_second_in_nano_seconds = 1'000'0000'000;
@@ -678,46 +959,581 @@ result<void> vengine::vengine::wait_for_fence(VkFence fence)
     return {};
 }
 
-vengine::vulkan_utils::result<void> vengine::vengine::render()
+result<void> vengine::vengine::wait_for_timeline(VkSemaphore semaphore, uint64_t value)
 {
-    const size_t one_second_in_nano_seconds = 1'000'0000'000;
-    // Wait for render fence
-
-    auto& data = current_frame_data();
-    wait_for_fence(data.render_fence);
-
-    // Acquire next swap chain image index
-    uint32_t swap_chain_image_index;
+    const size_t one_second_in_nano_seconds = 1'000'000'000;
+    VkSemaphoreWaitInfo semaphore_wait_info = { };
+    semaphore_wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    semaphore_wait_info.pNext = nullptr;
+    semaphore_wait_info.flags = 0;
+    semaphore_wait_info.semaphoreCount = 1;
+    semaphore_wait_info.pSemaphores = &semaphore;
+    semaphore_wait_info.pValues = &value;
+
+    VkResult wait_semaphores_result;
+    do
     {
-        auto acquire_next_image_result = vkAcquireNextImageKHR(
-                m_vkb_device.device,
-                m_vkb_swap_chain.swapchain,
-                one_second_in_nano_seconds,
-                data.present_semaphore,
-                nullptr,
-                &swap_chain_image_index);
-        if (acquire_next_image_result != VK_SUCCESS)
+        wait_semaphores_result = vkWaitSemaphores(m_vkb_device.device, &semaphore_wait_info, one_second_in_nano_seconds);
+        if (wait_semaphores_result != VK_SUCCESS && wait_semaphores_result != VK_TIMEOUT)
         {
-            auto message = VKB_ERROR("Failed to receive next swap chain image.", acquire_next_image_result);
-            log::error("vengine::vengine::render()", message);
-            return { acquire_next_image_result, message };
+            auto message = VKB_ERROR("Failed to wait for timeline semaphore.", wait_semaphores_result);
+            log::error("vengine::vengine::wait_for_timeline(VkSemaphore, uint64_t)", message);
+            return { wait_semaphores_result, message };
         }
     }
+    while (wait_semaphores_result == VK_TIMEOUT);
+    return {};
+}
 
+void vengine::vengine::wait_idle()
+{
+    if (m_vkb_device.device)
+    {
+        vkDeviceWaitIdle(m_vkb_device.device);
+    }
+}
 
-    // Reset command buffers
-    for (auto command_buffer: data.command_buffers)
+vkb::SwapchainBuilder vengine::vengine::swap_chain_builder() const
+{
+    // FIFO is the fallback if the requested mode is not supported by the surface
+    auto builder = vkb::SwapchainBuilder { m_vkb_device }.set_desired_format({ .format = VK_FORMAT_B8G8R8A8_SRGB, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR })
+                                                         .set_desired_present_mode(m_requested_present_mode);
+    if (m_requested_swap_chain_image_count > 0)
     {
-        auto reset_command_buffer_result = vkResetCommandBuffer(command_buffer, 0);
-        if (reset_command_buffer_result != VK_SUCCESS)
-        {
-            auto message = VKB_ERROR("Failed to reset command buffer.", reset_command_buffer_result);
-            log::error("vengine::vengine::render()", message);
-            return { reset_command_buffer_result, message };
-        }
+        builder.set_desired_min_image_count(m_requested_swap_chain_image_count);
     }
+    return builder;
+}
 
-    for (auto command_buffer: data.command_buffers)
+void vengine::vengine::log_swap_chain(const char* source) const
+{
+    auto message = std::string("Presenting ").append(std::to_string(m_vkb_swap_chain.extent.width)).append("x")
+            .append(std::to_string(m_vkb_swap_chain.extent.height)).append(" with ")
+            .append(std::to_string(m_vkb_swap_chain.image_count)).append(" images in ")
+            .append(stringify::data(m_vkb_swap_chain.present_mode)).append(".");
+    if (m_vkb_swap_chain.present_mode != m_requested_present_mode)
+    {
+        message.append(" ").append(stringify::data(m_requested_present_mode)).append(" is not supported by the surface.");
+        log::warning(source, message);
+        return;
+    }
+    log::info(source, message);
+}
+
+void vengine::vengine::frame_rate_limit(uint32_t frames_per_second)
+{
+    m_frame_interval = frames_per_second == 0
+                       ? std::chrono::steady_clock::duration::zero()
+                       : std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / frames_per_second;
+    m_next_frame_time = std::chrono::steady_clock::now();
+}
+
+result<void> vengine::vengine::create_depth_image()
+{
+    auto depths_image_result = vulkan_utils::image_builder(m_vma_allocator, {m_render_extent.width, m_render_extent.height, 1})
+            .set_memory_usage(VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY)
+            .set_image_usage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            .set_memory_property_flags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            .set_format(m_depths_format)
+            .build();
+    if (!depths_image_result)
+    {
+        auto message = VKB_ERROR("Failed to create depths image.", depths_image_result);
+        log::error("vengine::vengine::create_depth_image()", message);
+        return { depths_image_result.vk_result(), message };
+    }
+    m_depth_image = depths_image_result.value();
+
+    auto depths_image_view_result = vulkan_utils::image_view_builder(m_vkb_device.device, m_depth_image.image)
+            .set_memory_usage(VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY)
+            .set_image_usage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            .set_memory_property_flags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            .set_format(m_depths_format)
+            .set_image_aspect(VK_IMAGE_ASPECT_DEPTH_BIT)
+            .build();
+    if (!depths_image_view_result)
+    {
+        auto message = VKB_ERROR("Failed to create depths image view.", depths_image_view_result);
+        log::error("vengine::vengine::create_depth_image()", message);
+        return { depths_image_view_result.vk_result(), message };
+    }
+    m_depths_image_view = depths_image_view_result.value();
+    return { };
+}
+
+result<void> vengine::vengine::create_swap_chain_image_views()
+{
+    if (m_headless)
+    {
+        for (size_t i = 0; i < m_frames_in_flight; i++)
+        {
+            auto offscreen_image_result = vulkan_utils::image_builder(m_vma_allocator, {m_render_extent.width, m_render_extent.height, 1})
+                    .set_memory_usage(VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY)
+                    .set_image_usage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+                    .set_memory_property_flags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    .set_format(m_color_format)
+                    .build();
+            if (!offscreen_image_result)
+            {
+                auto message = VKB_ERROR("Failed to create offscreen image.", offscreen_image_result);
+                log::error("vengine::vengine::create_swap_chain_image_views()", message);
+                return { offscreen_image_result.vk_result(), message };
+            }
+            auto& offscreen_image = m_offscreen_images.emplace_back(offscreen_image_result.value());
+            m_swap_chain_images.push_back(offscreen_image.image);
+
+            auto offscreen_image_view_result = vulkan_utils::image_view_builder(m_vkb_device.device, offscreen_image.image)
+                    .set_memory_usage(VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY)
+                    .set_image_usage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+                    .set_memory_property_flags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    .set_format(m_color_format)
+                    .set_image_aspect(VK_IMAGE_ASPECT_COLOR_BIT)
+                    .build();
+            if (!offscreen_image_view_result)
+            {
+                auto message = VKB_ERROR("Failed to create offscreen image view.", offscreen_image_view_result);
+                log::error("vengine::vengine::create_swap_chain_image_views()", message);
+                return { offscreen_image_view_result.vk_result(), message };
+            }
+            m_swap_chain_image_views.push_back(offscreen_image_view_result.value());
+        }
+        return { };
+    }
+
+    auto swap_chain_images_result = m_vkb_swap_chain.get_images();
+    if (!swap_chain_images_result)
+    {
+        auto message = VKB_ERROR("Failed to receive images from swap chain.", swap_chain_images_result);
+        log::error("vengine::vengine::create_swap_chain_image_views()", message);
+        return { message };
+    }
+    m_swap_chain_images = swap_chain_images_result.value();
+
+    auto swap_chain_image_views_result = m_vkb_swap_chain.get_image_views();
+    if (!swap_chain_image_views_result)
+    {
+        auto message = VKB_ERROR("Failed to receive image views from swap chain.", swap_chain_image_views_result);
+        log::error("vengine::vengine::create_swap_chain_image_views()", message);
+        return { message };
+    }
+    m_swap_chain_image_views = swap_chain_image_views_result.value();
+    return { };
+}
+
+result<void> vengine::vengine::create_frame_buffers()
+{
+    VkFramebufferCreateInfo framebuffer_create_info = { };
+    framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_create_info.pNext = nullptr;
+
+    framebuffer_create_info.renderPass = m_vulkan_render_pass;
+    framebuffer_create_info.width = m_render_extent.width;
+    framebuffer_create_info.height = m_render_extent.height;
+    framebuffer_create_info.layers = 1;
+
+    m_frame_buffers = std::vector<VkFramebuffer>(m_swap_chain_image_views.size(), nullptr);
+    for (size_t i = 0; i < m_swap_chain_image_views.size(); i++)
+    {
+        auto attachments = std::array<VkImageView, 2>{ m_swap_chain_image_views[i], m_depths_image_view };
+        framebuffer_create_info.attachmentCount = (uint32_t)attachments.size();
+        framebuffer_create_info.pAttachments = attachments.data();
+        auto
+                create_frame_buffer_result = vkCreateFramebuffer(
+                m_vkb_device.device,
+                &framebuffer_create_info,
+                nullptr,
+                &m_frame_buffers[i]);
+        if (create_frame_buffer_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to create frame buffer.", create_frame_buffer_result);
+            log::error("vengine::vengine::create_frame_buffers()", message);
+            return { create_frame_buffer_result, message };
+        }
+    }
+    return { };
+}
+
+void vengine::vengine::destroy_swap_chain_resources()
+{
+    for (auto it: m_frame_buffers)
+    {
+        if (!it)
+        {
+            continue;
+        }
+        vkDestroyFramebuffer(m_vkb_device.device, it, nullptr);
+    }
+    m_frame_buffers.clear();
+    // Swap chain images belong to the swap chain and are not destroyed
+    for (auto it: m_swap_chain_image_views)
+    {
+        vkDestroyImageView(m_vkb_device.device, it, nullptr);
+    }
+    m_swap_chain_image_views.clear();
+    m_swap_chain_images.clear();
+    for (auto& offscreen_image : m_offscreen_images)
+    {
+        offscreen_image.destroy();
+    }
+    m_offscreen_images.clear();
+    if (m_depths_image_view)
+    {
+        vkDestroyImageView(m_vkb_device.device, m_depths_image_view, nullptr);
+        m_depths_image_view = nullptr;
+    }
+    if (m_depth_image.uploaded())
+    {
+        m_depth_image.destroy();
+    }
+}
+
+result<void> vengine::vengine::recreate_swap_chain()
+{
+    const char* source = "vengine::vengine::recreate_swap_chain()";
+    int width, height;
+    glfwGetFramebufferSize(static_cast<GLFWwindow*>(m_window_handle), &width, &height);
+    if (width == 0 || height == 0)
+    {
+        // Minimized, there is nothing to present to until the window is restored
+        return { VK_NOT_READY };
+    }
+
+    // Framebuffers and the depths image may still be used by frames in flight or pending presents,
+    // the transfer queue is left running
+    auto queue_wait_idle_result = vkQueueWaitIdle(m_vkb_graphics_queue);
+    if (queue_wait_idle_result != VK_SUCCESS)
+    {
+        auto message = VKB_ERROR("Failed to wait for the graphics queue.", queue_wait_idle_result);
+        log::error(source, message);
+        return { queue_wait_idle_result, message };
+    }
+
+    // Hands the images over from the old swap chain, which is retired by the driver
+    auto swap_chain_result = swap_chain_builder().set_desired_extent((uint32_t)width, (uint32_t)height)
+                                                 .set_old_swapchain(m_vkb_swap_chain)
+                                                 .build();
+    if (!swap_chain_result)
+    {
+        auto message = VKB_ERROR("Failed to recreate vulkan swap chain.", swap_chain_result);
+        log::error(source, message);
+        return { message };
+    }
+    if (swap_chain_result.value().image_format != m_color_format)
+    {
+        // The render pass and every pipeline would have to be recreated as well
+        auto message = "Swap chain image format changed on recreation.";
+        log::error(source, message);
+        vkb::destroy_swapchain(swap_chain_result.value());
+        return { VK_ERROR_FORMAT_NOT_SUPPORTED, message };
+    }
+
+    destroy_swap_chain_resources();
+    vkb::destroy_swapchain(m_vkb_swap_chain);
+    m_vkb_swap_chain = swap_chain_result.value();
+    m_render_extent = m_vkb_swap_chain.extent;
+    m_swap_chain_outdated = false;
+
+    if (!create_swap_chain_image_views() || !create_depth_image() || !create_frame_buffers())
+    {
+        auto message = "Failed to recreate swap chain resources.";
+        log::error(source, message);
+        return { message };
+    }
+    log_swap_chain(source);
+    return { };
+}
+
+result<void> vengine::vengine::record_read_back(frame_data& data, VkCommandBuffer command_buffer)
+{
+    // Tightly packed, the color formats used have 4 bytes per texel
+    VkDeviceSize size = (VkDeviceSize)m_render_extent.width * m_render_extent.height * 4;
+    if (!data.read_back_buffer.uploaded() || data.read_back_buffer.size < size)
+    {
+        if (data.read_back_buffer.uploaded())
+        {
+            data.read_back_buffer.destroy();
+        }
+        auto read_back_buffer_result = vulkan_utils::buffer_builder(m_vma_allocator, size)
+                .set_buffer_usage(VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                .set_memory_usage(VMA_MEMORY_USAGE_GPU_TO_CPU)
+                .set_persistently_mapped()
+                .build();
+        if (!read_back_buffer_result)
+        {
+            auto message = VKB_ERROR("Failed to create read back buffer.", read_back_buffer_result);
+            log::error("vengine::vengine::record_read_back(frame_data&, VkCommandBuffer)", message);
+            return { read_back_buffer_result.vk_result(), message };
+        }
+        data.read_back_buffer = read_back_buffer_result.value();
+    }
+
+    // The external dependency of the render pass makes the color writes and the transition
+    // to TRANSFER_SRC_OPTIMAL available to the copy, no barrier is needed in between
+    VkBufferImageCopy region = { };
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { m_render_extent.width, m_render_extent.height, 1 };
+    vkCmdCopyImageToBuffer(
+            command_buffer,
+            data.color_image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            data.read_back_buffer.buffer,
+            1,
+            &region);
+
+    VkMemoryBarrier host_barrier = { };
+    host_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    host_barrier.pNext = nullptr;
+    host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1,
+            &host_barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+    return { };
+}
+
+void vengine::vengine::deliver_read_back(frame_data& data)
+{
+    if (!data.read_back)
+    {
+        return;
+    }
+    auto callback = std::move(data.read_back);
+    data.read_back = { };
+    // Makes the device writes visible to the host (no-op on host-coherent memory)
+    if (!data.read_back_buffer.invalidate())
+    {
+        return;
+    }
+    VkDeviceSize size = (VkDeviceSize)m_render_extent.width * m_render_extent.height * 4;
+    callback(data.read_back_buffer.mapped().subspan(0, size), m_render_extent, m_color_format);
+}
+
+result<void> vengine::vengine::finish_read_backs()
+{
+    for (auto& data : m_frame_data_structures)
+    {
+        if (!data.read_back)
+        {
+            continue;
+        }
+        auto wait_for_timeline_result = wait_for_timeline(m_frame_timeline, data.timeline_value);
+        if (!wait_for_timeline_result)
+        {
+            return wait_for_timeline_result;
+        }
+        deliver_read_back(data);
+    }
+    return { };
+}
+
+vengine::vulkan_utils::result<void> vengine::vengine::render()
+{
+    const size_t one_second_in_nano_seconds = 1'000'0000'000;
+
+    // Minimized windows have nothing to present to, sleep on the event queue until restored or closed
+    // instead of spinning through empty frames
+    if (m_swap_chain_outdated && !m_headless)
+    {
+        auto window = static_cast<GLFWwindow*>(m_window_handle);
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        while ((width == 0 || height == 0) && !glfwWindowShouldClose(window))
+        {
+            glfwWaitEvents();
+            glfwGetFramebufferSize(window, &width, &height);
+        }
+        if (width == 0 || height == 0)
+        {
+            return { };
+        }
+    }
+
+    // Closes the zones of the last frame, every zone until the next call belongs to this one
+    m_profiler->begin_frame(m_frame_counter);
+    VENGINE_PROFILE_ZONE("vengine::render");
+
+    // Pace the CPU, frames that are late start right away instead of catching up
+    if (m_frame_interval > std::chrono::steady_clock::duration::zero())
+    {
+        VENGINE_PROFILE_ZONE("Frame rate limit");
+        std::this_thread::sleep_until(m_next_frame_time);
+        m_next_frame_time = std::max(m_next_frame_time, std::chrono::steady_clock::now() - m_frame_interval) + m_frame_interval;
+    }
+
+    // Only the size dependent resources are recreated, pipelines use dynamic viewport and scissors
+    if (m_swap_chain_outdated && !m_headless)
+    {
+        auto recreate_swap_chain_result = recreate_swap_chain();
+        if (recreate_swap_chain_result.vk_result() == VK_NOT_READY)
+        {
+            return { };
+        }
+        if (!recreate_swap_chain_result)
+        {
+            return recreate_swap_chain_result;
+        }
+    }
+
+    // Wait until the GPU finished the frame that used this frame_data last.
+    // Only blocks if the CPU is frames_in_flight frames ahead.
+    auto& data = current_frame_data();
+    {
+        VENGINE_PROFILE_ZONE("Wait for frame in flight");
+        auto wait_for_timeline_result = wait_for_timeline(m_frame_timeline, data.timeline_value);
+        if (!wait_for_timeline_result)
+        {
+            return wait_for_timeline_result;
+        }
+    }
+
+    // GPU is done with this frame_data, its dynamic buffers may be rewritten
+    data.mesh_allocator.reset();
+    data.indirect_allocator.reset();
+    deliver_read_back(data);
+    m_profiler->begin_gpu_frame(data.index);
+
+    // Reset secondary command buffers
+    for (auto& worker_command_pool : data.worker_command_pools)
+    {
+        auto reset_command_pool_result = vkResetCommandPool(m_vkb_device.device, worker_command_pool.command_pool, 0);
+        if (reset_command_pool_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to reset worker command pool.", reset_command_pool_result);
+            log::error("vengine::vengine::render()", message);
+            return { reset_command_pool_result, message };
+        }
+        worker_command_pool.used = 0;
+    }
+    data.secondary_command_buffers.clear();
+
+    // Reset command buffers
+    for (auto command_buffer: data.command_buffers)
+    {
+        auto reset_command_buffer_result = vkResetCommandBuffer(command_buffer, 0);
+        if (reset_command_buffer_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to reset command buffer.", reset_command_buffer_result);
+            log::error("vengine::vengine::render()", message);
+            return { reset_command_buffer_result, message };
+        }
+    }
+
+    // Adjust texture residency to last frame's requests, its uploads go out with the flush below
+    {
+        VENGINE_PROFILE_ZONE("texture_streamer::update");
+        auto update_textures_result = m_texture_streamer->update();
+        if (!update_textures_result)
+        {
+            return update_textures_result;
+        }
+    }
+
+    // Submit the uploads issued since the last frame
+    {
+        VENGINE_PROFILE_ZONE("upload_manager::flush");
+        auto flush_uploads_result = m_upload_manager->flush();
+        if (!flush_uploads_result)
+        {
+            return flush_uploads_result;
+        }
+    }
+
+    // Acquire next swap chain image index, offscreen images belong to a frame_data each
+    uint32_t swap_chain_image_index = (uint32_t)m_frame_data_index;
+    if (!m_headless)
+    {
+        VENGINE_PROFILE_ZONE("Acquire swap chain image");
+        auto acquire_next_image_result = vkAcquireNextImageKHR(
+                m_vkb_device.device,
+                m_vkb_swap_chain.swapchain,
+                one_second_in_nano_seconds,
+                data.present_semaphore,
+                nullptr,
+                &swap_chain_image_index);
+        if (acquire_next_image_result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            // Nothing was acquired, the frame is skipped and the swap chain recreated next render
+            m_swap_chain_outdated = true;
+            return { };
+        }
+        if (acquire_next_image_result == VK_SUBOPTIMAL_KHR)
+        {
+            // Still presentable, recreated after this frame
+            m_swap_chain_outdated = true;
+        }
+        else if (acquire_next_image_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to receive next swap chain image.", acquire_next_image_result);
+            log::error("vengine::vengine::render()", message);
+            return { acquire_next_image_result, message };
+        }
+    }
+
+    // A frame failing from here on still has to wait on present_semaphore, else the next acquire into it
+    // would signal a semaphore that already is signaled. Dismissed once the frame was submitted.
+    struct present_wait_guard
+    {
+        VkQueue queue;
+        VkSemaphore semaphore;
+        ~present_wait_guard()
+        {
+            if (semaphore != VK_NULL_HANDLE)
+            {
+                (void)submit_builder(queue, VK_NULL_HANDLE)
+                        .add_wait_semaphore(semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+                        .submit();
+            }
+        }
+    } present_wait { m_vkb_graphics_queue, m_headless ? VK_NULL_HANDLE : data.present_semaphore };
+
+    data.framebuffer = m_frame_buffers[swap_chain_image_index];
+    data.color_image = m_swap_chain_images[swap_chain_image_index];
+    // Handed to data only once the frame was submitted, a failed frame keeps it pending
+    bool read_back_requested = static_cast<bool>(m_pending_read_back);
+
+    // Collect the transfers that landed since the last frame, their resources are handed over to the graphics queue.
+    // They stay pending until the frame was submitted, a failed frame leaves them to the next one.
+    std::vector<VkBufferMemoryBarrier> buffer_acquires;
+    std::vector<VkImageMemoryBarrier> image_acquires;
+    std::vector<std::function<void(VkCommandBuffer)>> acquire_callbacks;
+    VkPipelineStageFlags transfer_wait_stage_mask = 0;
+    uint64_t transfer_wait_value = 0;
+    uint64_t transfer_timeline_value;
+    {
+        std::unique_lock lock(m_transfer_mutex);
+        vkGetSemaphoreCounterValue(m_vkb_device.device, m_transfer_timeline, &transfer_timeline_value);
+        for (auto& pending : m_pending_transfers)
+        {
+            if (pending.timeline_value > transfer_timeline_value)
+            {
+                continue;
+            }
+            buffer_acquires.insert(buffer_acquires.end(), pending.buffer_acquires.begin(), pending.buffer_acquires.end());
+            image_acquires.insert(image_acquires.end(), pending.image_acquires.begin(), pending.image_acquires.end());
+            acquire_callbacks.insert(acquire_callbacks.end(), pending.acquire_callbacks.begin(), pending.acquire_callbacks.end());
+            transfer_wait_stage_mask |= pending.acquire_stage_mask;
+            transfer_wait_value = std::max(transfer_wait_value, pending.timeline_value);
+        }
+    }
+
+    uint32_t gpu_frame_zone = ::vengine::profiler::invalid_zone;
+    uint32_t gpu_render_pass_zone = ::vengine::profiler::invalid_zone;
+    for (auto command_buffer: data.command_buffers)
     {
         // Begin command buffers
         {
@@ -738,6 +1554,53 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
             }
         }
 
+        // Reset the timestamp queries before anything of the frame writes them
+        if (command_buffer == data.command_buffers.front())
+        {
+            VENGINE_PROFILE_GPU_RESET(*m_profiler, command_buffer);
+            gpu_frame_zone = VENGINE_PROFILE_GPU_ZONE_BEGIN(*m_profiler, command_buffer, "Frame");
+        }
+
+        // Acquire ownership of resources uploaded via the transfer queue
+        if (command_buffer == data.command_buffers.front() && (!buffer_acquires.empty() || !image_acquires.empty()))
+        {
+            // Chains with the transfer timeline wait of the submit, which uses the same stages
+            vkCmdPipelineBarrier(
+                    command_buffer,
+                    transfer_wait_stage_mask,
+                    transfer_wait_stage_mask,
+                    0,
+                    0,
+                    nullptr,
+                    (uint32_t)buffer_acquires.size(),
+                    buffer_acquires.data(),
+                    (uint32_t)image_acquires.size(),
+                    image_acquires.data());
+        }
+        if (command_buffer == data.command_buffers.front())
+        {
+            for (auto& acquire_callback : acquire_callbacks)
+            {
+                acquire_callback(command_buffer);
+            }
+        }
+
+        // Raise before render pass event (eg. compute work the render pass depends on)
+        if (command_buffer == data.command_buffers.front())
+        {
+            VENGINE_PROFILE_ZONE("on_before_render_pass");
+            VENGINE_PROFILE_GPU_ZONE(*m_profiler, command_buffer, "on_before_render_pass");
+            on_before_render_pass_event_args args { data, command_buffer };
+            on_before_render_pass.raise(this, args);
+        }
+
+        // Begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, the primary may only execute commands
+        // inside of the render pass, hence its zone brackets the pass from outside. The secondaries write their own.
+        if (command_buffer == data.command_buffers.front())
+        {
+            gpu_render_pass_zone = VENGINE_PROFILE_GPU_ZONE_BEGIN(*m_profiler, command_buffer, "Render pass");
+        }
+
         // Begin render pass
         {
             VkClearValue color_clear_value = {};
@@ -756,18 +1619,63 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
             render_pass_begin_info.renderPass = m_vulkan_render_pass;
             render_pass_begin_info.renderArea.offset.x = 0;
             render_pass_begin_info.renderArea.offset.y = 0;
-            render_pass_begin_info.renderArea.extent = m_vkb_swap_chain.extent;
+            render_pass_begin_info.renderArea.extent = m_render_extent;
             render_pass_begin_info.framebuffer = m_frame_buffers[swap_chain_image_index];
             render_pass_begin_info.clearValueCount = (uint32_t)clear_values.size();
             render_pass_begin_info.pClearValues = clear_values.data();
 
-            vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
         }
     }
 
     // Raise render event
-    on_render_pass.raise(this, { data, data.command_buffers.front() });
+    {
+        auto render_thread_command_buffer = begin_secondary_command_buffer(data, data.worker_command_pools.size() - 1);
+        if (!render_thread_command_buffer.has_value())
+        {
+            return { "Failed to begin secondary command buffer." };
+        }
+        VENGINE_PROFILE_ZONE("on_render_pass");
+        on_render_pass_event_args args { data, render_thread_command_buffer.value() };
+        // Subscribers may replace the command buffer (see record_parallel), the zone ends in the last one
+        auto gpu_on_render_pass_zone = VENGINE_PROFILE_GPU_ZONE_BEGIN(*m_profiler, args.command_buffer, "on_render_pass");
+        on_render_pass.raise(this, args);
+        if (args.command_buffer == VK_NULL_HANDLE)
+        {
+            // record_parallel failed to begin the buffer to continue with
+            auto message = "A render pass subscriber left no command buffer to continue recording in.";
+            log::error("vengine::vengine::render()", message);
+            return { message };
+        }
+        VENGINE_PROFILE_GPU_ZONE_END(*m_profiler, args.command_buffer, gpu_on_render_pass_zone);
+
+        auto command_buffer_end_result = vkEndCommandBuffer(args.command_buffer);
+        if (command_buffer_end_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to end command buffer.", command_buffer_end_result);
+            log::error("vengine::vengine::render()", message);
+            return { command_buffer_end_result, message };
+        }
+        data.secondary_command_buffers.push_back(args.command_buffer);
+    }
+
+    // Make host writes to the persistently mapped buffers visible (no-op on host-coherent memory)
+    data.camera_buffer.flush();
+    data.mesh_allocator.flush();
+    data.indirect_allocator.flush();
+
+    // Execute secondary command buffers in recording order
+    if (data.secondary_command_buffers.size() > UINT32_MAX)
+    {
+        auto message = "More secondary command buffers have been recorded then vulkan can handle.";
+        log::error("vengine::vengine::render()", message);
+        return { message };
+    }
+    vkCmdExecuteCommands(
+            data.command_buffers.front(),
+            (uint32_t)data.secondary_command_buffers.size(),
+            data.secondary_command_buffers.data());
 
     for (auto command_buffer: data.command_buffers)
     {
@@ -775,6 +1683,24 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
         {
             vkCmdEndRenderPass(command_buffer);
         }
+        if (command_buffer == data.command_buffers.front())
+        {
+            VENGINE_PROFILE_GPU_ZONE_END(*m_profiler, command_buffer, gpu_render_pass_zone);
+        }
+
+        // Copy the color image for read_back
+        if (command_buffer == data.command_buffers.front() && read_back_requested)
+        {
+            auto record_read_back_result = record_read_back(data, command_buffer);
+            if (!record_read_back_result)
+            {
+                return record_read_back_result;
+            }
+        }
+        if (command_buffer == data.command_buffers.front())
+        {
+            VENGINE_PROFILE_GPU_ZONE_END(*m_profiler, command_buffer, gpu_frame_zone);
+        }
 
         // End command buffer
         {
@@ -790,9 +1716,21 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
 
 
     // Submit queue
-    auto submit_result = submit_builder(m_vkb_graphics_queue, data.render_fence)
-            .add_wait_semaphore(data.present_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
-            .add_signal_semaphore(data.render_semaphore)
+    auto frame_timeline_value = m_frame_timeline_value + 1;
+    auto frame_submit_builder = submit_builder(m_vkb_graphics_queue, VK_NULL_HANDLE);
+    if (!m_headless)
+    {
+        frame_submit_builder.add_wait_semaphore(data.present_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        frame_submit_builder.add_signal_semaphore(data.render_semaphore);
+    }
+    if (transfer_wait_value > 0)
+    {
+        // Already signaled, the wait only establishes the memory dependency to the transfer queue
+        frame_submit_builder.add_wait_semaphore(m_transfer_timeline, transfer_wait_stage_mask, transfer_wait_value);
+    }
+    auto submit_time = ::vengine::profiler::now();
+    auto submit_result = frame_submit_builder
+            .add_signal_semaphore(m_frame_timeline, frame_timeline_value)
             .add_command_buffer(data.command_buffers.begin(), data.command_buffers.end())
             .submit();
     if (!submit_result)
@@ -800,9 +1738,35 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
         log::error("vengine::vengine::render()", VKB_ERROR("Failed to submit render queue.", submit_result));
         return submit_result;
     }
+    present_wait.semaphore = VK_NULL_HANDLE;
+    m_frame_timeline_value = frame_timeline_value;
+    data.timeline_value = frame_timeline_value;
+
+    // The acquires were submitted, transfers issued during the frame signal larger values and stay pending
+    {
+        std::unique_lock lock(m_transfer_mutex);
+        auto landed = std::stable_partition(
+                m_pending_transfers.begin(),
+                m_pending_transfers.end(),
+                [transfer_timeline_value](const pending_transfer& pending) { return pending.timeline_value > transfer_timeline_value; });
+        for (auto it = landed; it != m_pending_transfers.end(); it++)
+        {
+            destroy_command_buffer(m_transfer_command_pool, it->command_buffer);
+        }
+        m_pending_transfers.erase(landed, m_pending_transfers.end());
+        m_upload_manager->acquired(transfer_timeline_value);
+    }
+    if (read_back_requested)
+    {
+        data.read_back = std::move(m_pending_read_back);
+        m_pending_read_back = { };
+    }
+    m_profiler->end_gpu_frame(m_frame_counter, submit_time);
 
     // Present image to screen
+    if (!m_headless)
     {
+        VENGINE_PROFILE_ZONE("Present");
         VkPresentInfoKHR presentInfo = { };
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         presentInfo.pNext = nullptr;
@@ -816,7 +1780,11 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
         presentInfo.pImageIndices = &swap_chain_image_index;
 
         auto queue_present_result = vkQueuePresentKHR(m_vkb_graphics_queue, &presentInfo);
-        if (queue_present_result != VK_SUCCESS)
+        if (queue_present_result == VK_ERROR_OUT_OF_DATE_KHR || queue_present_result == VK_SUBOPTIMAL_KHR)
+        {
+            m_swap_chain_outdated = true;
+        }
+        else if (queue_present_result != VK_SUCCESS)
         {
             auto message = VKB_ERROR("Failed present render queue.", queue_present_result);
             log::error("vengine::vengine::render()", message);
@@ -826,7 +1794,7 @@ vengine::vulkan_utils::result<void> vengine::vengine::render()
     }
     // Increase frame counter
     m_frame_counter++;
-    m_frame_data_index = m_frame_data_index + 1 >= frame_data_structures_count ? 0 : m_frame_data_index + 1;
+    m_frame_data_index = m_frame_data_index + 1 >= m_frames_in_flight ? 0 : m_frame_data_index + 1;
 
     return {};
 }
@@ -918,6 +1886,171 @@ result<void> vengine::vengine::execute(std::function<void(VkCommandBuffer&)> fun
     return {};
 }
 
+result<uint64_t> vengine::vengine::execute_transfer(const std::function<void(transfer_context&)>& func)
+{
+    std::unique_lock lock(m_transfer_mutex);
+    auto command_buffer_optional = create_command_buffer(m_transfer_command_pool);
+    if (!command_buffer_optional.has_value())
+    {
+        return { "Failed to create Command-Buffer" };
+    }
+    auto command_buffer = command_buffer_optional.value();
+
+    // Begin command buffer
+    {
+        VkCommandBufferBeginInfo command_buffer_begin_info = { };
+        command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        command_buffer_begin_info.pNext = nullptr;
+
+        command_buffer_begin_info.pInheritanceInfo = nullptr;
+        command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        auto command_buffer_begin_result = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+        if (command_buffer_begin_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to begin command buffer.", command_buffer_begin_result);
+            log::error("vengine::vengine::execute_transfer(const std::function<void(transfer_context&)>&)", message);
+            destroy_command_buffer(m_transfer_command_pool, command_buffer);
+            return { command_buffer_begin_result, message };
+        }
+    }
+    transfer_context context(command_buffer, m_vkb_transfer_queue_index, m_vkb_graphics_queue_index);
+    func(context);
+    context.record_releases();
+    // End command buffer
+    {
+        auto command_buffer_end_result = vkEndCommandBuffer(command_buffer);
+        if (command_buffer_end_result != VK_SUCCESS)
+        {
+            auto message = VKB_ERROR("Failed to end command buffer.", command_buffer_end_result);
+            log::error("vengine::vengine::execute_transfer(const std::function<void(transfer_context&)>&)", message);
+            destroy_command_buffer(m_transfer_command_pool, command_buffer);
+            return { command_buffer_end_result, message };
+        }
+    }
+
+    // Submit to transfer queue
+    auto transfer_timeline_value = m_transfer_timeline_value + 1;
+    auto submit_result = submit_builder(m_vkb_transfer_queue, VK_NULL_HANDLE)
+            .add_command_buffer(command_buffer)
+            .add_signal_semaphore(m_transfer_timeline, transfer_timeline_value)
+            .submit();
+    if (!submit_result)
+    {
+        auto message = VKB_ERROR("Failed to submit to transfer queue.", submit_result);
+        log::error("vengine::vengine::execute_transfer(const std::function<void(transfer_context&)>&)", message);
+        destroy_command_buffer(m_transfer_command_pool, command_buffer);
+        return { submit_result.vk_result(), message };
+    }
+    m_transfer_timeline_value = transfer_timeline_value;
+
+    // Graphics work waits for the transfer once it is picked up by render()
+    m_pending_transfers.push_back({
+            transfer_timeline_value,
+            command_buffer,
+            std::move(context.m_buffer_acquires),
+            std::move(context.m_image_acquires),
+            context.m_acquire_stage_mask == 0 ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : context.m_acquire_stage_mask,
+            std::move(context.m_acquire_callbacks) });
+    return { transfer_timeline_value };
+}
+
+bool vengine::vengine::transfer_completed(uint64_t timeline_value) const
+{
+    uint64_t transfer_timeline_value;
+    vkGetSemaphoreCounterValue(m_vkb_device.device, m_transfer_timeline, &transfer_timeline_value);
+    return transfer_timeline_value >= timeline_value;
+}
+
+void vengine::vengine::transfer_context::release_buffer(VkBuffer buffer, VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask,
+                                                        VkDeviceSize offset, VkDeviceSize size)
+{
+    VkBufferMemoryBarrier buffer_memory_barrier = { };
+    buffer_memory_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    buffer_memory_barrier.pNext = nullptr;
+    buffer_memory_barrier.buffer = buffer;
+    buffer_memory_barrier.offset = offset;
+    buffer_memory_barrier.size = size;
+    buffer_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    m_acquire_stage_mask |= dst_stage_mask;
+
+    if (m_transfer_queue_index == m_graphics_queue_index)
+    {
+        // Same queue family, no ownership transfer needed.
+        // The transfer timeline wait of the frame makes the writes available to the graphics work.
+        return;
+    }
+
+    // Release on the transfer queue, the destination access is performed by the acquire
+    buffer_memory_barrier.srcQueueFamilyIndex = m_transfer_queue_index;
+    buffer_memory_barrier.dstQueueFamilyIndex = m_graphics_queue_index;
+    buffer_memory_barrier.dstAccessMask = 0;
+    m_buffer_releases.push_back(buffer_memory_barrier);
+
+    // Acquire on the graphics queue, the source access was made available by the release
+    buffer_memory_barrier.srcAccessMask = 0;
+    buffer_memory_barrier.dstAccessMask = dst_access_mask;
+    m_buffer_acquires.push_back(buffer_memory_barrier);
+}
+
+void vengine::vengine::transfer_context::release_image(VkImage image, VkImageSubresourceRange subresource_range,
+                                                       VkImageLayout old_layout, VkImageLayout new_layout,
+                                                       VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask)
+{
+    VkImageMemoryBarrier image_memory_barrier = { };
+    image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_memory_barrier.pNext = nullptr;
+    image_memory_barrier.image = image;
+    image_memory_barrier.subresourceRange = subresource_range;
+    image_memory_barrier.oldLayout = old_layout;
+    image_memory_barrier.newLayout = new_layout;
+    image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    m_acquire_stage_mask |= dst_stage_mask;
+
+    if (m_transfer_queue_index == m_graphics_queue_index)
+    {
+        // Same queue family, the layout transition can happen right away
+        image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_memory_barrier.dstAccessMask = dst_access_mask;
+        m_image_releases.push_back(image_memory_barrier);
+        return;
+    }
+
+    // Release on the transfer queue. The layout transition has to be specified identically
+    // in release and acquire, it is executed once in between the two.
+    image_memory_barrier.srcQueueFamilyIndex = m_transfer_queue_index;
+    image_memory_barrier.dstQueueFamilyIndex = m_graphics_queue_index;
+    image_memory_barrier.dstAccessMask = 0;
+    m_image_releases.push_back(image_memory_barrier);
+
+    // Acquire on the graphics queue
+    image_memory_barrier.srcAccessMask = 0;
+    image_memory_barrier.dstAccessMask = dst_access_mask;
+    m_image_acquires.push_back(image_memory_barrier);
+}
+
+void vengine::vengine::transfer_context::record_releases()
+{
+    if (m_buffer_releases.empty() && m_image_releases.empty())
+    {
+        return;
+    }
+    // Releases happen before the queue family switch, they need no destination stage.
+    // Within the same queue family the image barriers perform the actual transition.
+    vkCmdPipelineBarrier(
+            m_command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            m_transfer_queue_index == m_graphics_queue_index ? m_acquire_stage_mask : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            (uint32_t)m_buffer_releases.size(),
+            m_buffer_releases.data(),
+            (uint32_t)m_image_releases.size(),
+            m_image_releases.data());
+}
+
 #pragma region glfw
 #define glfw_wnd (static_cast<GLFWwindow*>(m_window_handle))
 
@@ -929,7 +2062,10 @@ void vengine::vengine::set_error_callback(void (*error_handle)(int, const char *
 void vengine::vengine::glfw_window_destroy()
 {
     glfw_unset_window_callbacks();
-    glfwDestroyWindow(glfw_wnd);
+    if (m_window_handle)
+    {
+        glfwDestroyWindow(glfw_wnd);
+    }
     m_window_handle = nullptr;
     if (m_glfw_initialized)
     {
@@ -948,7 +2084,7 @@ void vengine::vengine::glfw_window_init(int width, int height, const std::string
     }
     m_glfw_initialized = true;
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, false);
+    glfwWindowHint(GLFW_RESIZABLE, true);
     m_window_handle = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
     glfw_set_window_callbacks();
 }
@@ -1115,6 +2251,8 @@ void vengine::vengine::glfw_set_window_callbacks()
                 if (user_pointer)
                 {
                     auto instance = reinterpret_cast<vengine *>(user_pointer);
+                    // Not every platform reports VK_ERROR_OUT_OF_DATE_KHR on resize
+                    instance->m_swap_chain_outdated = true;
                     instance->on_window_size.raise(*instance, { width, height });
                 }
             });
@@ -1134,17 +2272,30 @@ void vengine::vengine::glfw_set_window_callbacks()
 vengine::vengine::size vengine::vengine::window_size() const
 {
     vengine::vengine::size size { 0 };
+    if (!m_window_handle)
+    {
+        // Headless, the offscreen images are the window
+        return { (int)m_render_extent.width, (int)m_render_extent.height };
+    }
     glfwGetWindowSize(glfw_wnd, &size.width, &size.height);
     return size;
 }
 
 void vengine::vengine::window_size(const vengine::vengine::size &size)
 {
+    if (!m_window_handle)
+    {
+        return;
+    }
     glfwSetWindowSize(glfw_wnd, size.width, size.height);
 }
 
 void vengine::vengine::window_title(const std::string &title)
 {
+    if (!m_window_handle)
+    {
+        return;
+    }
     glfwSetWindowTitle(glfw_wnd, title.c_str());
 }
 
@@ -1155,11 +2306,19 @@ void vengine::vengine::handle_pending_events()
 
 void vengine::vengine::swap_buffers()
 {
+    if (!m_window_handle)
+    {
+        return;
+    }
     glfwSwapBuffers(glfw_wnd);
 }
 
 vengine::vengine::key_actions vengine::vengine::get_key(keys key)
 {
+    if (!m_window_handle)
+    {
+        return key_actions::RELEASE;
+    }
     auto result = glfwGetKey(glfw_wnd, static_cast<int>(key));
     return static_cast<vengine::vengine::key_actions>(result);
 }
@@ -11,12 +11,26 @@
 #include "vk_mem_alloc.h"
 #include "allocated_buffer.hpp"
 #include "allocated_image.hpp"
+#include "ring_allocator.hpp"
+#include "worker_pool.hpp"
+#include "upload_manager.hpp"
+#include "geometry_pool.hpp"
+#include "texture_streamer.hpp"
+#include "async_io.hpp"
+#include "pipeline_cache.hpp"
+#include "profiler.hpp"
 #include "vulkan-utils/result.hpp"
 
 
 #include <glm/glm.hpp>
 #include <vector>
 #include <optional>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <filesystem>
+#include <chrono>
+#include <span>
 
 namespace vengine
 {
@@ -29,6 +43,56 @@ namespace vengine
             int height;
         };
 
+        struct engine_options
+        {
+            // Number of frames the CPU may record ahead of the GPU (1 - 4).
+            // Higher values trade latency for throughput.
+            size_t frames_in_flight = 2;
+            // Number of threads used for parallel command recording (see record_parallel).
+            // 0 picks the hardware concurrency.
+            size_t recording_threads = 0;
+            // Size of the staging ring uploads are batched in (see upload_manager).
+            // Uploads larger than this get a staging buffer of their own.
+            size_t staging_buffer_size = 64 * 1024 * 1024;
+            // Size of every shared vertex buffer of the geometry_pool (one per vertex_format).
+            size_t geometry_vertex_buffer_size = 64 * 1024 * 1024;
+            // Size of every shared index buffer of the geometry_pool (one per index type).
+            size_t geometry_index_buffer_size = 32 * 1024 * 1024;
+            // Maximum number of file reads in flight (see async_io).
+            size_t io_queue_depth = 64;
+            // Number of threads blocking on file reads if io_uring is not available.
+            size_t io_fallback_threads = 4;
+            // Maximum bytes of resident texture levels (see texture_streamer).
+            // 0 picks texture_budget_fraction of the device local memory budget.
+            size_t texture_budget = 0;
+            float texture_budget_fraction = 0.5f;
+            // Texture refinements started per frame stop once they exceed this many bytes.
+            size_t texture_upload_bytes_per_frame = 32 * 1024 * 1024;
+            // File the pipeline cache is loaded from on startup and saved to on shutdown, empty to not persist it.
+            std::filesystem::path pipeline_cache_path = "pipeline_cache.bin";
+            // Presentation mode requested, VK_PRESENT_MODE_FIFO_KHR (always supported) is used if the surface lacks it.
+            // FIFO waits for vertical blank and draws the least power, FIFO_RELAXED tears when a frame is late,
+            // MAILBOX replaces queued images for low latency without tearing, IMMEDIATE has the lowest latency but tears.
+            VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+            // Minimum number of swap chain images, clamped to what the surface supports. 0 lets the driver decide.
+            // Fewer images lower latency, more let the GPU queue up frames.
+            uint32_t swap_chain_image_count = 0;
+            // Frames rendered per second at most, render() sleeps to keep the pace. 0 for no limit.
+            uint32_t frame_rate_limit = 0;
+            // Renders into offscreen images instead of a window, neither GLFW nor a surface is created.
+            // Meant for benchmarks and tests on machines without display, frames are read back via read_back.
+            bool headless = false;
+            // Size of the offscreen images in headless mode.
+            size headless_size = { 800, 600 };
+            // Records CPU zones and GPU timestamps of every frame (see profiler), may be toggled later via profiler::enabled.
+            bool profiling = false;
+            // GPU zones a single frame may record, further ones are dropped.
+            size_t profiler_gpu_zones = 256;
+            // Number of completed frames the profiler keeps.
+            size_t profiler_history = 240;
+        };
+        static const size_t max_frames_in_flight = 4;
+
 #pragma pack(push, 1)
         struct gpu_camera_data
         {
@@ -39,6 +103,11 @@ namespace vengine
 
             void set_gpu_buffer_data(allocated_buffer buffer) const
             {
+                if (buffer.persistently_mapped())
+                {
+                    memcpy(buffer.mapped_data, this, sizeof(gpu_camera_data));
+                    return;
+                }
                 void* data;
                 vmaMapMemory(buffer.allocator, buffer.allocation, &data);
                 memcpy(data, this, sizeof(gpu_camera_data));
@@ -51,6 +120,20 @@ namespace vengine
         };
 #pragma pack(pop)
 
+        struct worker_command_pool
+        {
+            VkCommandPool command_pool;
+            // Secondary command buffers, reused every time the frame_data comes around
+            std::vector<VkCommandBuffer> command_buffers;
+            size_t used;
+        };
+
+        /**
+         * Receives the tightly packed rows of a color image read back from the GPU (see read_back).
+         * texels are only valid during the call.
+         */
+        using read_back_callback = std::function<void(std::span<const uint8_t> texels, VkExtent2D extent, VkFormat format)>;
+
         struct frame_data
         {
             void bind_graphics_pipeline(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout,
@@ -68,17 +151,101 @@ namespace vengine
                         nullptr);
             }
 
+            // Index of this frame_data, in range [0, frames_in_flight())
+            size_t index;
             VkSemaphore present_semaphore;
             VkSemaphore render_semaphore;
-            VkFence render_fence;
+            // Value of the frame timeline semaphore that signals the GPU is done with this frame_data
+            uint64_t timeline_value;
             VkCommandPool command_pool;
             std::vector<VkCommandBuffer> command_buffers;
+            // One pool per recording thread, the last one belongs to the render thread.
+            // Command pools are externally synchronized, hence every thread needs its own.
+            std::vector<worker_command_pool> worker_command_pools;
+            // Secondary command buffers recorded this frame in execution order
+            std::vector<VkCommandBuffer> secondary_command_buffers;
+            VkFramebuffer framebuffer;
 
 
             const size_t mesh_buffer_size = 100000;
+            // Persistently mapped, write via camera_buffer.mapped_as<gpu_camera_data>()
             allocated_buffer camera_buffer;
+            // Persistently mapped, write via mesh_allocator
             allocated_buffer mesh_buffer;
+            // Hands out gpu_mesh_data slots of mesh_buffer, reset once the frame_data gets reused
+            ring_allocator<gpu_mesh_data> mesh_allocator;
+            // Persistently mapped, write via indirect_allocator
+            allocated_buffer indirect_buffer;
+            // Hands out VkDrawIndexedIndirectCommand slots of indirect_buffer, reset once the frame_data gets reused
+            ring_allocator<VkDrawIndexedIndirectCommand> indirect_allocator;
             VkDescriptorSet descriptor_set;
+            // Color image rendered into this frame
+            VkImage color_image;
+            // Persistently mapped, receives the color image if a read back was requested for this frame
+            allocated_buffer read_back_buffer;
+            // Invoked once the GPU finished this frame, empty if no read back was requested
+            read_back_callback read_back;
+        };
+
+        /**
+         * Passed to the function given to execute_transfer.
+         *
+         * Resources written on the transfer queue must be released via release_buffer / release_image
+         * before the graphics queue may use them. The matching acquire barriers are recorded by the engine
+         * at the start of the first frame rendered after the upload landed.
+         */
+        class transfer_context
+        {
+            friend class vengine;
+            VkCommandBuffer m_command_buffer;
+            uint32_t m_transfer_queue_index;
+            uint32_t m_graphics_queue_index;
+            std::vector<VkBufferMemoryBarrier> m_buffer_releases;
+            std::vector<VkImageMemoryBarrier> m_image_releases;
+            std::vector<VkBufferMemoryBarrier> m_buffer_acquires;
+            std::vector<VkImageMemoryBarrier> m_image_acquires;
+            VkPipelineStageFlags m_acquire_stage_mask;
+            std::vector<std::function<void(VkCommandBuffer)>> m_acquire_callbacks;
+
+            transfer_context(VkCommandBuffer command_buffer, uint32_t transfer_queue_index, uint32_t graphics_queue_index)
+                    : m_command_buffer(command_buffer),
+                      m_transfer_queue_index(transfer_queue_index),
+                      m_graphics_queue_index(graphics_queue_index),
+                      m_acquire_stage_mask(0)
+            {
+            }
+
+            // Records all releases in a single barrier, called once func of execute_transfer returned
+            void record_releases();
+        public:
+            [[nodiscard]] VkCommandBuffer command_buffer() const { return m_command_buffer; }
+
+            /**
+             * Hands the range of buffer over to the graphics queue after it was written by a transfer command.
+             * Other ranges of buffer may be in use by the graphics queue meanwhile.
+             *
+             * @param dst_access_mask How the graphics queue is going to access the buffer.
+             * @param dst_stage_mask The pipeline stages the graphics queue is going to access the buffer in.
+             */
+            void release_buffer(VkBuffer buffer, VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask,
+                                VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+            /**
+             * Hands image over to the graphics queue after it was written by a transfer command,
+             * transitioning it from old_layout to new_layout.
+             *
+             * @param dst_access_mask How the graphics queue is going to access the image.
+             * @param dst_stage_mask The pipeline stages the graphics queue is going to access the image in.
+             */
+            void release_image(VkImage image, VkImageSubresourceRange subresource_range, VkImageLayout old_layout,
+                               VkImageLayout new_layout, VkAccessFlags dst_access_mask, VkPipelineStageFlags dst_stage_mask);
+
+            /**
+             * Records func into the graphics command buffer of the first frame rendered after the transfer landed,
+             * right after the acquire barriers. Meant for work the transfer queue cannot do (eg. blits).
+             * Resources referenced by func must stay alive until that frame was recorded.
+             */
+            void on_acquire(std::function<void(VkCommandBuffer)> func) { m_acquire_callbacks.push_back(std::move(func)); }
         };
 
 #pragma region GLFW
@@ -440,6 +607,9 @@ namespace vengine
         vkb::Swapchain m_vkb_swap_chain{};
         VkQueue m_vkb_graphics_queue{};
         uint32_t m_vkb_graphics_queue_index{};
+        // Dedicated transfer queue if the device has one, otherwise the graphics queue
+        VkQueue m_vkb_transfer_queue{};
+        uint32_t m_vkb_transfer_queue_index{};
         VkRenderPass m_vulkan_render_pass{};
         VmaAllocator m_vma_allocator{};
         VkDescriptorPool m_descriptor_pool{};
@@ -447,26 +617,107 @@ namespace vengine
         VkPhysicalDeviceProperties m_physical_device_properties{};
         VkCommandPool m_general_command_pool{};
         VkFence m_general_fence{};
+        VkSemaphore m_frame_timeline{};
+        uint64_t m_frame_timeline_value{};
+
+        struct pending_transfer
+        {
+            // Value of the transfer timeline semaphore that signals the transfer landed
+            uint64_t timeline_value;
+            VkCommandBuffer command_buffer;
+            // Ownership acquire barriers to be recorded on the graphics queue
+            std::vector<VkBufferMemoryBarrier> buffer_acquires;
+            std::vector<VkImageMemoryBarrier> image_acquires;
+            VkPipelineStageFlags acquire_stage_mask;
+            // Recorded after the acquire barriers (see transfer_context::on_acquire)
+            std::vector<std::function<void(VkCommandBuffer)>> acquire_callbacks;
+        };
+        VkCommandPool m_transfer_command_pool{};
+        VkSemaphore m_transfer_timeline{};
+        uint64_t m_transfer_timeline_value{};
+        std::vector<pending_transfer> m_pending_transfers{};
+        std::mutex m_transfer_mutex{};
         std::vector<VkShaderModule> m_shader_modules{};
         std::vector<VkImage> m_swap_chain_images{};
         std::vector<VkImageView> m_swap_chain_image_views{};
         std::vector<VkFramebuffer> m_frame_buffers{};
-        const size_t frame_data_structures_count = 2;
+        size_t m_frames_in_flight{};
         std::vector<frame_data> m_frame_data_structures{};
 
         VkFormat m_depths_format{};
         allocated_image m_depth_image{};
         VkImageView m_depths_image_view{};
-
+        bool m_headless{};
+        // Of the images rendered into, taken from the swap chain unless headless
+        VkExtent2D m_render_extent{};
+        VkFormat m_color_format{};
+        // Take the place of the swap chain images in headless mode, one per frame in flight
+        std::vector<allocated_image> m_offscreen_images{};
+        // Set by read_back, handed to the next frame rendered
+        read_back_callback m_pending_read_back{};
+        // Set on resize or when presenting reported the swap chain to be out of date
+        bool m_swap_chain_outdated{};
+        VkPresentModeKHR m_requested_present_mode{};
+        uint32_t m_requested_swap_chain_image_count{};
+        std::chrono::steady_clock::duration m_frame_interval{};
+        std::chrono::steady_clock::time_point m_next_frame_time{};
+
+        /**
+         * Builder of the swap chain with the requested format, present mode and image count.
+         */
+        [[nodiscard]] vkb::SwapchainBuilder swap_chain_builder() const;
+        void log_swap_chain(const char* source) const;
+        /**
+         * Records the copy of the color image of data into its read_back_buffer, after the render pass ended.
+         */
+        [[nodiscard]] vulkan_utils::result<void> record_read_back(frame_data& data, VkCommandBuffer command_buffer);
+        /**
+         * Invokes the read back callback of data, the GPU must be done with it.
+         */
+        void deliver_read_back(frame_data& data);
+        [[nodiscard]] vulkan_utils::result<void> create_depth_image();
+        /**
+         * Gets the swap chain images and creates their views, in headless mode the offscreen images are created instead.
+         */
+        [[nodiscard]] vulkan_utils::result<void> create_swap_chain_image_views();
+        [[nodiscard]] vulkan_utils::result<void> create_frame_buffers();
+        /**
+         * Destroys everything depending on the swap chain extent, that is frame buffers, swap chain image views and the depths image.
+         */
+        void destroy_swap_chain_resources();
+        /**
+         * Recreates the swap chain for the current window size, handing over from the old one, along with the
+         * resources depending on its extent. Render pass and pipelines are kept.
+         *
+         * @returns VK_NOT_READY if the window is minimized.
+         */
+        [[nodiscard]] vulkan_utils::result<void> recreate_swap_chain();
 
         [[maybe_unused]] [[nodiscard]] std::optional<VkCommandBuffer> create_command_buffer(frame_data& frame) const;
         [[maybe_unused]] [[nodiscard]] std::optional<VkCommandBuffer> create_command_buffer(VkCommandPool& command_pool) const;
 
         [[maybe_unused]] [[maybe_unused]] void destroy_command_buffer(frame_data& frame, VkCommandBuffer buffer) const;
         [[maybe_unused]] [[maybe_unused]] void destroy_command_buffer(VkCommandPool& command_pool, VkCommandBuffer buffer) const;
+
+        std::unique_ptr<utils::worker_pool> m_worker_pool;
+        std::unique_ptr<::vengine::upload_manager> m_upload_manager;
+        std::unique_ptr<::vengine::geometry_pool> m_geometry_pool;
+        std::unique_ptr<::vengine::async_io> m_async_io;
+        std::unique_ptr<::vengine::texture_streamer> m_texture_streamer;
+        std::unique_ptr<::vengine::pipeline_cache> m_pipeline_cache;
+        std::unique_ptr<::vengine::profiler> m_profiler;
+
+        /**
+         * Takes the next free secondary command buffer of the given worker_command_pool of frame
+         * and begins it, inheriting the render pass.
+         * Must only be called from the thread owning the pool.
+         */
+        [[nodiscard]] std::optional<VkCommandBuffer> begin_secondary_command_buffer(frame_data& frame, size_t pool_index) const;
     public:
         vengine();
 
+        explicit vengine(const engine_options& options);
+
         ~vengine();
 
         [[nodiscard]] size_t frame_count() const
@@ -474,11 +725,28 @@ namespace vengine
             return m_frame_counter;
         }
 
+        [[nodiscard]] size_t frames_in_flight() const
+        {
+            return m_frames_in_flight;
+        }
+
         [[nodiscard]] bool good() const
         {
-            return m_glfw_initialized && m_initialized;
+            return (m_headless || m_glfw_initialized) && m_initialized;
         }
 
+        [[nodiscard]] bool headless() const { return m_headless; }
+
+        /**
+         * Copies the color image of the next frame rendered into host memory. The copy is part of the frame,
+         * callback is invoked by render() once the GPU finished it, frames_in_flight frames later, or by finish_read_backs.
+         */
+        void read_back(read_back_callback callback) { m_pending_read_back = std::move(callback); }
+        /**
+         * Waits for every frame with a read back and invokes the callbacks.
+         */
+        vulkan_utils::result<void> finish_read_backs();
+
         [[maybe_unused]] [[nodiscard]] std::optional<VkShaderModule> create_shader_module(const ram_file &file);
 
         [[maybe_unused]] void destroy_shader_module(VkShaderModule buffer);
@@ -493,6 +761,13 @@ namespace vengine
         {
             return m_vulkan_render_pass;
         }
+        /**
+         * Shared by every pipeline, pass it to the pipeline builders.
+         */
+        [[maybe_unused]] [[nodiscard]] VkPipelineCache vulkan_pipeline_cache() const
+        {
+            return m_pipeline_cache ? m_pipeline_cache->handle() : VK_NULL_HANDLE;
+        }
         [[maybe_unused]] [[nodiscard]] VkDescriptorSetLayout vulkan_descriptor_set_layout() const
         {
             return m_descriptor_set_layout;
@@ -505,17 +780,96 @@ namespace vengine
 
         vulkan_utils::result<void> wait_for_fence(VkFence fence);
 
+        /**
+         * Blocks until the timeline semaphore reached at least value.
+         */
+        vulkan_utils::result<void> wait_for_timeline(VkSemaphore semaphore, uint64_t value);
+
+        /**
+         * Blocks until the device finished all submitted work.
+         */
+        void wait_idle();
+
         vulkan_utils::result<void> execute(std::function<void(VkCommandBuffer& command_buffer)> func);
 
+        /**
+         * Records func into a command buffer of the transfer queue and submits it without waiting.
+         * Resources written must be released via the transfer_context, they may be used by frames
+         * rendered after the returned transfer timeline value was reached (see transfer_completed / wait_for_transfer).
+         *
+         * Must be called from the render thread, as the transfer queue falls back to the graphics queue
+         * on devices without a dedicated one.
+         *
+         * @returns The value the transfer timeline semaphore reaches once the transfer landed.
+         */
+        vulkan_utils::result<uint64_t> execute_transfer(const std::function<void(transfer_context& context)>& func);
+
+        /**
+         * Blocks until the transfer returned by execute_transfer landed.
+         */
+        vulkan_utils::result<void> wait_for_transfer(uint64_t timeline_value)
+        {
+            return wait_for_timeline(m_transfer_timeline, timeline_value);
+        }
+
+        [[nodiscard]] bool transfer_completed(uint64_t timeline_value) const;
+
+        /**
+         * Batches asset uploads, flushed at the start of every frame.
+         */
+        [[nodiscard]] ::vengine::upload_manager& uploads() { return *m_upload_manager; }
+
+        /**
+         * Shared vertex and index buffers every mesh is allocated from.
+         */
+        [[nodiscard]] ::vengine::geometry_pool& geometry() { return *m_geometry_pool; }
+
+        /**
+         * Background file reads, used to load assets concurrently.
+         */
+        [[nodiscard]] ::vengine::async_io& file_io() { return *m_async_io; }
+
+        /**
+         * Mip level residency of streamed textures, updated every frame.
+         */
+        [[nodiscard]] ::vengine::texture_streamer& textures() { return *m_texture_streamer; }
+
+        /**
+         * CPU and GPU zones of the last frames. render() records the frame, its stages and the render pass,
+         * on_render_pass subscribers may add GPU zones to args.command_buffer via VENGINE_PROFILE_GPU_ZONE.
+         */
+        [[nodiscard]] ::vengine::profiler& profiler() { return *m_profiler; }
+
+        [[maybe_unused]] [[nodiscard]] uint32_t graphics_queue_index() const { return m_vkb_graphics_queue_index; }
+        [[maybe_unused]] [[nodiscard]] uint32_t transfer_queue_index() const { return m_vkb_transfer_queue_index; }
+
         frame_data& current_frame_data() { return m_frame_data_structures[m_frame_data_index]; }
 
+        /**
+         * @returns The presentation mode negotiated with the surface, which may differ from the one requested.
+         */
+        [[nodiscard]] VkPresentModeKHR present_mode() const { return m_vkb_swap_chain.present_mode; }
+        /**
+         * Requests mode, the swap chain is recreated with it before the next frame.
+         */
+        void present_mode(VkPresentModeKHR mode)
+        {
+            m_requested_present_mode = mode;
+            m_swap_chain_outdated = true;
+        }
+        [[nodiscard]] uint32_t swap_chain_image_count() const { return m_vkb_swap_chain.image_count; }
+        /**
+         * Limits render() to frames_per_second, 0 removes the limit.
+         */
+        void frame_rate_limit(uint32_t frames_per_second);
+
         [[maybe_unused]] [[nodiscard]] VkViewport vulkan_default_viewport() const
         {
             VkViewport viewport;
             viewport.x = 0.0f;
             viewport.y = 0.0f;
-            viewport.width = (float) m_vkb_swap_chain.extent.width;
-            viewport.height = (float) m_vkb_swap_chain.extent.height;
+            viewport.width = (float) m_render_extent.width;
+            viewport.height = (float) m_render_extent.height;
             viewport.minDepth = 0.0f;
             viewport.maxDepth = 1.0f;
             return viewport;
@@ -525,14 +879,23 @@ namespace vengine
         {
             VkRect2D rect2d;
             rect2d.offset = {0,0};
-            rect2d.extent = m_vkb_swap_chain.extent;
+            rect2d.extent = m_render_extent;
             return rect2d;
         }
 
         vulkan_utils::result<void> render();
 
+        [[nodiscard]] utils::worker_pool& worker_pool() { return *m_worker_pool; }
+
         [[nodiscard]] const VkPhysicalDeviceProperties& physical_device_properties() const { return m_physical_device_properties; }
 
+        [[nodiscard]] VkFormatProperties format_properties(VkFormat format) const
+        {
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(m_vkb_physical_device.physical_device, format, &properties);
+            return properties;
+        }
+
         [[nodiscard]] size_t gpu_pad(size_t original_size) const
         {
             size_t padding = physical_device_properties().limits.minUniformBufferOffsetAlignment;
@@ -542,13 +905,44 @@ namespace vengine
         }
 
     public:
+        struct on_before_render_pass_event_args
+        {
+            frame_data& current_frame_data;
+            // Primary command buffer, outside of the render pass
+            VkCommandBuffer command_buffer{};
+        };
+        using on_before_render_pass_event = utils::event_source<vengine, on_before_render_pass_event_args>;
+        on_before_render_pass_event on_before_render_pass;
+
         struct on_render_pass_event_args
         {
-            frame_data current_frame_data;
+            frame_data& current_frame_data;
+            // Secondary command buffer inside of the render pass, owned by the render thread.
+            // Gets replaced when calling record_parallel.
             VkCommandBuffer command_buffer{};
         };
         using on_render_pass_event = utils::event_source<vengine, on_render_pass_event_args>;
         on_render_pass_event on_render_pass;
+
+        /**
+         * Records count secondary command buffers in parallel on the recording threads.
+         * Must be called from within an on_render_pass subscriber.
+         *
+         * Execution order is deterministic: everything recorded to args.command_buffer before this call,
+         * then the buffers passed to func in ascending index order, then everything recorded to
+         * args.command_buffer afterwards (args.command_buffer is replaced with a fresh buffer).
+         *
+         * Every buffer passed to func is already inside of the render pass, but has no pipeline or
+         * descriptor sets bound.
+         *
+         * @param args The args received by the on_render_pass subscriber.
+         * @param count Number of command buffers to record.
+         * @param func Recording function, called once per index from any of the recording threads.
+         */
+        vulkan_utils::result<void> record_parallel(
+                on_render_pass_event_args& args,
+                size_t count,
+                const std::function<void(VkCommandBuffer command_buffer, size_t index)>& func);
     };
 }
 
@@ -21,10 +21,12 @@ namespace vengine::vulkan_utils
         VmaAllocator m_allocator;
         std::optional<VmaMemoryUsage> m_memory_usage;
         std::optional<VkBufferUsageFlags> m_buffer_usage;
+        bool m_persistently_mapped;
         size_t m_size;
     public:
         buffer_builder(VmaAllocator allocator, size_t size)
                 : m_allocator(allocator),
+                m_persistently_mapped(false),
                 m_size(size)
         {
 
@@ -40,6 +42,16 @@ namespace vengine::vulkan_utils
             m_buffer_usage = buffer_usage_flags;
             return *this;
         }
+        /**
+         * Keeps the allocation mapped for its whole lifetime, making it
+         * accessible via allocated_buffer::mapped without any map/unmap calls.
+         * Requires a host visible memory usage (eg. VMA_MEMORY_USAGE_CPU_TO_GPU).
+         */
+        buffer_builder& set_persistently_mapped(bool persistently_mapped = true)
+        {
+            m_persistently_mapped = persistently_mapped;
+            return *this;
+        }
 
         result<allocated_buffer> build() // NOLINT(readability-convert-member-functions-to-static)
         {
@@ -65,15 +77,21 @@ namespace vengine::vulkan_utils
 
             VmaAllocationCreateInfo allocation_create_info = {};
             allocation_create_info.usage = m_memory_usage.value();
+            if (m_persistently_mapped)
+            {
+                allocation_create_info.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+            }
 
+            VmaAllocationInfo allocation_info = {};
             allocated_buffer result(m_allocator);
             auto create_buffer_result = vmaCreateBuffer(m_allocator, &buffer_create_info, &allocation_create_info,
                     &result.buffer,
                     &result.allocation,
-                    nullptr);
+                    &allocation_info);
             if (create_buffer_result == VK_SUCCESS)
             {
                 result.size = m_size;
+                result.mapped_data = m_persistently_mapped ? allocation_info.pMappedData : nullptr;
                 return { result };
             }
             else
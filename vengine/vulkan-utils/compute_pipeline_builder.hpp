@@ -0,0 +1,81 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_COMPUTE_PIPELINE_BUILDER_HPP
+#define GAME_PROJ_COMPUTE_PIPELINE_BUILDER_HPP
+
+#include "result.hpp"
+#include "../log.hpp"
+#include "stringify.hpp"
+
+#include <vulkan/vulkan.h>
+#include <optional>
+
+namespace vengine::vulkan_utils
+{
+    class compute_pipeline_builder
+    {
+        VkDevice m_device;
+        VkPipelineLayout m_pipeline_layout;
+        std::optional<VkPipelineShaderStageCreateInfo> m_shader_stage_create_info;
+        VkPipelineCache m_pipeline_cache;
+    public:
+        compute_pipeline_builder(VkDevice device, VkPipelineLayout pipeline_layout)
+                : m_device(device), m_pipeline_layout(pipeline_layout), m_pipeline_cache(VK_NULL_HANDLE)
+        {
+
+        }
+
+        compute_pipeline_builder &set_pipeline_cache(VkPipelineCache pipeline_cache)
+        {
+            m_pipeline_cache = pipeline_cache;
+            return *this;
+        }
+
+        compute_pipeline_builder &set_shader(VkShaderModule shader_module, const char *entry_method = "main")
+        {
+            VkPipelineShaderStageCreateInfo shader_stage_create_info { };
+            shader_stage_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            shader_stage_create_info.pNext = nullptr;
+
+            shader_stage_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            shader_stage_create_info.module = shader_module;
+            shader_stage_create_info.pName = entry_method;
+            m_shader_stage_create_info = shader_stage_create_info;
+            return *this;
+        }
+
+        result<VkPipeline> build() // NOLINT(readability-convert-member-functions-to-static)
+        {
+            if (!m_shader_stage_create_info.has_value())
+            {
+                auto message = "Shader never has been set. (set_shader)";
+                log::error("vengine::vulkan_utils::compute_pipeline_builder::build()", message);
+                return message;
+            }
+
+            VkComputePipelineCreateInfo pipeline_create_info = {};
+            pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipeline_create_info.pNext = nullptr;
+            pipeline_create_info.stage = m_shader_stage_create_info.value();
+            pipeline_create_info.layout = m_pipeline_layout;
+            pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+
+            VkPipeline pipeline;
+            auto pipeline_creation_result = vkCreateComputePipelines(m_device, m_pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline);
+            if (pipeline_creation_result == VK_SUCCESS)
+            {
+                return { pipeline };
+            }
+            else
+            {
+                auto message = std::string("Failed to build compute pipeline (").append(stringify::data(pipeline_creation_result)).append(")");
+                log::error("vengine::vulkan_utils::compute_pipeline_builder::build()", message);
+                return { pipeline_creation_result, message };
+            }
+        }
+    };
+}
+
+#endif //GAME_PROJ_COMPUTE_PIPELINE_BUILDER_HPP
@@ -30,13 +30,33 @@ namespace vengine::vulkan_utils
         std::vector<VkPipelineColorBlendAttachmentState> m_color_blend_attachment_states;
         std::vector<VkVertexInputBindingDescription> m_vertex_input_binding_descriptions;
         std::vector<VkVertexInputAttributeDescription> m_vertex_input_attribute_descriptions;
+        std::vector<VkDynamicState> m_dynamic_states;
+        VkPipelineCache m_pipeline_cache;
     public:
         pipeline_builder(VkDevice device, VkRenderPass render_pass, VkViewport viewport, VkRect2D scissors, VkPipelineLayout pipeline_layout)
-                : m_device(device), m_render_pass(render_pass), m_viewport(viewport), m_scissors(scissors), m_pipeline_layout(pipeline_layout)
+                : m_device(device), m_render_pass(render_pass), m_viewport(viewport), m_scissors(scissors), m_pipeline_layout(pipeline_layout),
+                m_pipeline_cache(VK_NULL_HANDLE)
         {
 
         }
 
+        pipeline_builder &set_pipeline_cache(VkPipelineCache pipeline_cache)
+        {
+            m_pipeline_cache = pipeline_cache;
+            return *this;
+        }
+
+        /**
+         * Makes state part of the command buffer instead of the pipeline.
+         * With VK_DYNAMIC_STATE_VIEWPORT and VK_DYNAMIC_STATE_SCISSOR, the viewport and scissors passed
+         * to the constructor are ignored and the pipeline survives swap chain recreation.
+         */
+        pipeline_builder &add_dynamic_state(VkDynamicState dynamic_state)
+        {
+            m_dynamic_states.push_back(dynamic_state);
+            return *this;
+        }
+
         pipeline_builder &add_shader(VkShaderModule shader_module, VkShaderStageFlagBits stage_flag_bits,
                                      const char *entry_method = "main")
         {
@@ -250,6 +270,12 @@ namespace vengine::vulkan_utils
             color_blend_state_create_info.attachmentCount = (uint32_t)m_color_blend_attachment_states.size();
             color_blend_state_create_info.pAttachments = m_color_blend_attachment_states.data();
 
+            // Dynamic State
+            VkPipelineDynamicStateCreateInfo dynamic_state_create_info = { };
+            dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamic_state_create_info.pNext = nullptr;
+            dynamic_state_create_info.dynamicStateCount = (uint32_t)m_dynamic_states.size();
+            dynamic_state_create_info.pDynamicStates = m_dynamic_states.data();
 
             // Pipeline
             VkGraphicsPipelineCreateInfo pipelineInfo = {};
@@ -264,6 +290,7 @@ namespace vengine::vulkan_utils
             pipelineInfo.pMultisampleState = &m_multisample_state_create_info.value();
             pipelineInfo.pColorBlendState = &color_blend_state_create_info;
             pipelineInfo.pDepthStencilState = m_pipeline_depth_stencil_state_create_info.has_value() ? &m_pipeline_depth_stencil_state_create_info.value() : nullptr;
+            pipelineInfo.pDynamicState = m_dynamic_states.empty() ? nullptr : &dynamic_state_create_info;
             pipelineInfo.layout = m_pipeline_layout;
             pipelineInfo.renderPass = m_render_pass;
             pipelineInfo.subpass = 0;
@@ -271,7 +298,7 @@ namespace vengine::vulkan_utils
 
             //it's easy to error out on create graphics pipeline, so we handle it a bit better than the common VK_CHECK case
             VkPipeline pipeline;
-            auto pipeline_creation_result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+            auto pipeline_creation_result = vkCreateGraphicsPipelines(m_device, m_pipeline_cache, 1, &pipelineInfo, nullptr, &pipeline);
             if (pipeline_creation_result == VK_SUCCESS)
             {
                 return { pipeline };
@@ -23,6 +23,7 @@ namespace vengine::vulkan_utils
         std::vector<VkSubpassDescription> m_sub_pass_descriptions;
         std::vector<VkAttachmentReference> m_sub_pass_descriptions_attachment_references;
         std::vector<uint32_t> m_sub_pass_descriptions_preserve_attachments;
+        std::vector<VkSubpassDependency> m_sub_pass_dependencies;
     public:
         explicit render_pass_builder(VkDevice device)
                 : m_device(device)
@@ -64,6 +65,31 @@ namespace vengine::vulkan_utils
             m_sub_pass_descriptions.push_back(sub_pass_description);
             return *this;
         }
+        render_pass_builder& add_sub_pass_dependency(VkSubpassDependency sub_pass_dependency)
+        {
+            m_sub_pass_dependencies.push_back(sub_pass_dependency);
+            return *this;
+        }
+        render_pass_builder& add_sub_pass_dependency(
+                uint32_t                src_sub_pass,
+                uint32_t                dst_sub_pass,
+                VkPipelineStageFlags    src_stage_mask,
+                VkPipelineStageFlags    dst_stage_mask,
+                VkAccessFlags           src_access_mask,
+                VkAccessFlags           dst_access_mask,
+                VkDependencyFlags       dependency_flags = 0)
+        {
+            VkSubpassDependency sub_pass_dependency = { };
+            sub_pass_dependency.srcSubpass = src_sub_pass;
+            sub_pass_dependency.dstSubpass = dst_sub_pass;
+            sub_pass_dependency.srcStageMask = src_stage_mask;
+            sub_pass_dependency.dstStageMask = dst_stage_mask;
+            sub_pass_dependency.srcAccessMask = src_access_mask;
+            sub_pass_dependency.dstAccessMask = dst_access_mask;
+            sub_pass_dependency.dependencyFlags = dependency_flags;
+            m_sub_pass_dependencies.push_back(sub_pass_dependency);
+            return *this;
+        }
 
         result<VkRenderPass> build() // NOLINT(readability-convert-member-functions-to-static)
         {
@@ -79,6 +105,12 @@ namespace vengine::vulkan_utils
                 log::error("vengine::vulkan_utils::render_pass_builder::build()", message);
                 return message;
             }
+            if (m_sub_pass_dependencies.size() > UINT32_MAX)
+            {
+                auto message = "More sub pass dependencies have been added then vulkan can handle.";
+                log::error("vengine::vulkan_utils::render_pass_builder::build()", message);
+                return message;
+            }
             
             VkRenderPassCreateInfo render_pass_info = { };
             render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -86,6 +118,8 @@ namespace vengine::vulkan_utils
             render_pass_info.pAttachments = m_attachment_descriptions.data();
             render_pass_info.subpassCount = (uint32_t)m_sub_pass_descriptions.size();
             render_pass_info.pSubpasses = m_sub_pass_descriptions.data();
+            render_pass_info.dependencyCount = (uint32_t)m_sub_pass_dependencies.size();
+            render_pass_info.pDependencies = m_sub_pass_dependencies.data();
 
 
             VkRenderPass result = {};
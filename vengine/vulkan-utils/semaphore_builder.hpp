@@ -0,0 +1,64 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_SEMAPHORE_BUILDER_HPP
+#define GAME_PROJ_SEMAPHORE_BUILDER_HPP
+#include "result.hpp"
+#include "../log.hpp"
+#include "stringify.hpp"
+
+#include <vulkan/vulkan.h>
+#include <optional>
+
+namespace vengine::vulkan_utils
+{
+    class semaphore_builder
+    {
+        VkDevice m_device;
+        std::optional<uint64_t> m_timeline_initial_value;
+    public:
+        explicit semaphore_builder(VkDevice device)
+                : m_device(device)
+        {
+
+        }
+        /**
+         * Makes the semaphore a timeline semaphore (Vulkan 1.2 / timelineSemaphore feature).
+         * If never called, a binary semaphore is created.
+         *
+         * @param initial_value The value the timeline starts with.
+         */
+        semaphore_builder& set_timeline(uint64_t initial_value = 0)
+        {
+            m_timeline_initial_value = initial_value;
+            return *this;
+        }
+
+        result<VkSemaphore> build() // NOLINT(readability-convert-member-functions-to-static)
+        {
+            VkSemaphoreTypeCreateInfo semaphore_type_create_info = { };
+            semaphore_type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            semaphore_type_create_info.pNext = nullptr;
+            semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+            semaphore_type_create_info.initialValue = m_timeline_initial_value.value_or(0);
+
+            VkSemaphoreCreateInfo semaphore_create_info = { };
+            semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphore_create_info.pNext = m_timeline_initial_value.has_value() ? &semaphore_type_create_info : nullptr;
+            semaphore_create_info.flags = 0;
+
+            VkSemaphore semaphore;
+            auto semaphore_create_result = vkCreateSemaphore(m_device, &semaphore_create_info, nullptr, &semaphore);
+            if (semaphore_create_result != VK_SUCCESS)
+            {
+                auto message = std::string("Failed to create semaphore (").append(stringify::data(semaphore_create_result)).append(")");
+                log::error("vengine::vulkan_utils::semaphore_builder::build()", message);
+                return { semaphore_create_result, message };
+            }
+            return { semaphore };
+        }
+    };
+}
+
+#endif //GAME_PROJ_SEMAPHORE_BUILDER_HPP
@@ -59,6 +59,19 @@ namespace vengine::vulkan_utils
                 case VK_RESULT_MAX_ENUM: return "VK_RESULT_MAX_ENUM";
             }
         }
+        static std::string_view data(VkPresentModeKHR vk_present_mode)
+        {
+            switch (vk_present_mode)
+            {
+                default: return "[UNKNOWN]";
+                case VK_PRESENT_MODE_IMMEDIATE_KHR: return "VK_PRESENT_MODE_IMMEDIATE_KHR";
+                case VK_PRESENT_MODE_MAILBOX_KHR: return "VK_PRESENT_MODE_MAILBOX_KHR";
+                case VK_PRESENT_MODE_FIFO_KHR: return "VK_PRESENT_MODE_FIFO_KHR";
+                case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "VK_PRESENT_MODE_FIFO_RELAXED_KHR";
+                case VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR: return "VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR";
+                case VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR: return "VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR";
+            }
+        }
     };
 }
 
@@ -21,26 +21,49 @@ namespace vengine::vulkan_utils
         {
             VkSemaphore semaphore;
             VkPipelineStageFlags pipeline_stage_flags;
+            uint64_t value;
         };
         VkQueue m_queue;
         VkFence m_fence;
+        bool m_has_timeline_semaphores;
         std::vector<wait_tuple> m_wait_tuples;
         std::vector<VkSemaphore> m_signal_semaphores;
+        std::vector<uint64_t> m_signal_semaphore_values;
         std::vector<VkCommandBuffer> m_command_buffers;
     public:
         explicit submit_builder(VkQueue queue, VkFence fence)
-                : m_queue(queue), m_fence(fence)
+                : m_queue(queue), m_fence(fence), m_has_timeline_semaphores(false)
         {
 
         }
         submit_builder& add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags pipeline_stage_flags)
         {
-            m_wait_tuples.push_back({ semaphore, pipeline_stage_flags });
+            m_wait_tuples.push_back({ semaphore, pipeline_stage_flags, 0 });
+            return *this;
+        }
+        /**
+         * Waits for a timeline semaphore to reach value.
+         */
+        submit_builder& add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags pipeline_stage_flags, uint64_t value)
+        {
+            m_wait_tuples.push_back({ semaphore, pipeline_stage_flags, value });
+            m_has_timeline_semaphores = true;
             return *this;
         }
         submit_builder& add_signal_semaphore(VkSemaphore semaphore)
         {
             m_signal_semaphores.push_back(semaphore);
+            m_signal_semaphore_values.push_back(0);
+            return *this;
+        }
+        /**
+         * Sets a timeline semaphore to value once the submitted work completed.
+         */
+        submit_builder& add_signal_semaphore(VkSemaphore semaphore, uint64_t value)
+        {
+            m_signal_semaphores.push_back(semaphore);
+            m_signal_semaphore_values.push_back(value);
+            m_has_timeline_semaphores = true;
             return *this;
         }
         submit_builder& add_command_buffer(VkCommandBuffer command_buffer)
@@ -78,15 +101,26 @@ namespace vengine::vulkan_utils
 
             std::vector<VkPipelineStageFlags> pipeline_stage_flags(m_wait_tuples.size());
             std::vector<VkSemaphore> semaphores(m_wait_tuples.size());
+            std::vector<uint64_t> wait_values(m_wait_tuples.size());
             for (size_t i = 0; i < m_wait_tuples.size(); i++)
             {
                 semaphores[i] = m_wait_tuples[i].semaphore;
                 pipeline_stage_flags[i] = m_wait_tuples[i].pipeline_stage_flags;
+                wait_values[i] = m_wait_tuples[i].value;
             }
 
+            // Values of binary semaphores are ignored by vulkan
+            VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info = { };
+            timeline_semaphore_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timeline_semaphore_submit_info.pNext = nullptr;
+            timeline_semaphore_submit_info.waitSemaphoreValueCount = (uint32_t)wait_values.size();
+            timeline_semaphore_submit_info.pWaitSemaphoreValues = wait_values.data();
+            timeline_semaphore_submit_info.signalSemaphoreValueCount = (uint32_t)m_signal_semaphore_values.size();
+            timeline_semaphore_submit_info.pSignalSemaphoreValues = m_signal_semaphore_values.data();
+
             VkSubmitInfo submit_info = { };
             submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            submit_info.pNext = nullptr;
+            submit_info.pNext = m_has_timeline_semaphores ? &timeline_semaphore_submit_info : nullptr;
 
             submit_info.waitSemaphoreCount = (uint32_t)m_wait_tuples.size();
             submit_info.pWaitSemaphores = semaphores.data();
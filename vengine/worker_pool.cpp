@@ -0,0 +1,123 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#include "worker_pool.hpp"
+#include "log.hpp"
+#include "profiler.hpp"
+
+#include <exception>
+#include <string>
+
+vengine::utils::worker_pool::worker_pool(size_t thread_count) : m_stop(false)
+{
+    if (thread_count == 0)
+    {
+        thread_count = default_thread_count();
+    }
+    m_threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        m_threads.emplace_back([this, i]() { worker_main(i); });
+    }
+}
+
+vengine::utils::worker_pool::~worker_pool()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+size_t vengine::utils::worker_pool::default_thread_count()
+{
+    auto hardware_concurrency = std::thread::hardware_concurrency();
+    return hardware_concurrency == 0 ? 1 : hardware_concurrency;
+}
+
+void vengine::utils::worker_pool::worker_main(size_t worker_index)
+{
+    ::vengine::profiler::thread_name(std::string("Worker ").append(std::to_string(worker_index)));
+    while (true)
+    {
+        std::function<void(size_t)> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            if (m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        try
+        {
+            task(worker_index);
+        }
+        catch (const std::exception& e)
+        {
+            log::error("vengine::utils::worker_pool::worker_main(size_t)", std::string("Task threw an exception: ").append(e.what()));
+        }
+        catch (...)
+        {
+            log::error("vengine::utils::worker_pool::worker_main(size_t)", "Task threw an unknown exception.");
+        }
+    }
+}
+
+void vengine::utils::worker_pool::enqueue(std::function<void(size_t)> func)
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_tasks.push_back(std::move(func));
+    }
+    m_condition.notify_one();
+}
+
+void vengine::utils::worker_pool::parallel_for(size_t count, const std::function<void(size_t, size_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    std::mutex done_mutex;
+    std::condition_variable done_condition;
+    size_t remaining = count;
+    {
+        std::unique_lock lock(m_mutex);
+        for (size_t i = 0; i < count; i++)
+        {
+            m_tasks.emplace_back([&, i](size_t worker_index)
+            {
+                try
+                {
+                    func(i, worker_index);
+                }
+                catch (const std::exception& e)
+                {
+                    log::error("vengine::utils::worker_pool::parallel_for(size_t, const std::function<void(size_t, size_t)>&)", std::string("Task threw an exception: ").append(e.what()));
+                }
+                catch (...)
+                {
+                    // Anything escaping would skip the decrement below and leave the caller waiting forever
+                    log::error("vengine::utils::worker_pool::parallel_for(size_t, const std::function<void(size_t, size_t)>&)", "Task threw an unknown exception.");
+                }
+                std::unique_lock done_lock(done_mutex);
+                if (--remaining == 0)
+                {
+                    done_condition.notify_all();
+                }
+            });
+        }
+    }
+    m_condition.notify_all();
+    std::unique_lock done_lock(done_mutex);
+    done_condition.wait(done_lock, [&]() { return remaining == 0; });
+}
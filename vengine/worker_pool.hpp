@@ -0,0 +1,78 @@
+//
+// Created by marco.silipo on 17.10.2026.
+//
+
+#ifndef GAME_PROJ_WORKER_POOL_HPP
+#define GAME_PROJ_WORKER_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace vengine::utils
+{
+    /**
+     * Fixed size pool of worker threads.
+     *
+     * Every task receives the index of the worker executing it (0 to size() - 1),
+     * which allows callers to keep per-thread resources (eg. command pools) without locking.
+     */
+    class worker_pool
+    {
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void(size_t)>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stop;
+
+        void worker_main(size_t worker_index);
+    public:
+        /**
+         * @param thread_count Number of worker threads to spawn. If 0, default_thread_count() is used.
+         */
+        explicit worker_pool(size_t thread_count);
+        worker_pool(const worker_pool&) = delete;
+        worker_pool& operator=(const worker_pool&) = delete;
+        ~worker_pool();
+
+        [[nodiscard]] size_t size() const { return m_threads.size(); }
+
+        [[nodiscard]] static size_t default_thread_count();
+
+        /**
+         * Queues func to be executed on any of the worker threads.
+         */
+        void enqueue(std::function<void(size_t worker_index)> func);
+
+        /**
+         * Queues func to be executed on any of the worker threads.
+         *
+         * @returns A future receiving the result of func.
+         */
+        template<typename TFunc>
+        [[nodiscard]] auto submit(TFunc func) -> std::future<std::invoke_result_t<TFunc>>
+        {
+            using result_t = std::invoke_result_t<TFunc>;
+            auto task = std::make_shared<std::packaged_task<result_t()>>(std::move(func));
+            auto future = task->get_future();
+            enqueue([task](size_t) { (*task)(); });
+            return future;
+        }
+
+        /**
+         * Executes func for every index in [0, count) on the worker threads and
+         * blocks until all invocations returned.
+         *
+         * Must not be called from a worker thread of this pool.
+         */
+        void parallel_for(size_t count, const std::function<void(size_t index, size_t worker_index)>& func);
+    };
+}
+
+#endif //GAME_PROJ_WORKER_POOL_HPP
@@ -0,0 +1,43 @@
+#version 460
+// Vertex layout of vengine::compact_vertex
+layout (location = 0) in vec3 vPosition;
+// Octahedral encoded
+layout (location = 1) in vec2 vNormal;
+
+layout (location = 0) out vec3 outColor;
+
+layout(set = 0, binding = 0) uniform  CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 projection_view;
+} camera_data;
+
+struct gpu_mesh_data {
+    mat4 model;
+};
+
+// Object matrices
+layout(std140, set = 0, binding = 1) readonly buffer ObjectBuffer {
+
+    gpu_mesh_data mesh_data[];
+} mesh_buffer;
+
+vec3 decode_octahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    mat4 model_space = mesh_buffer.mesh_data[gl_BaseInstance].model;
+    mat4 camera_space = camera_data.projection_view * model_space;
+    gl_Position = camera_space * vec4(vPosition, 1.0f);
+    // OBJ meshes carry their normal as debug color (see mesh::from_obj), which the unorm8 color
+    // of compact_vertex clamps to [0, 1], hence it is taken from the decoded normal instead
+    outColor = decode_octahedral(vNormal);
+}
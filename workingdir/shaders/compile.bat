@@ -1,3 +1,5 @@
 D:\dev\lib\vulkan\1.2.148.1\Bin32\glslangValidator.exe -V shader.vert
 D:\dev\lib\vulkan\1.2.148.1\Bin32\glslangValidator.exe -V shader.frag
+D:\dev\lib\vulkan\1.2.148.1\Bin32\glslangValidator.exe -V compact.vert -o compact_vert.spv
+D:\dev\lib\vulkan\1.2.148.1\Bin32\glslangValidator.exe -V cull.comp -o cull.spv
 pause
\ No newline at end of file